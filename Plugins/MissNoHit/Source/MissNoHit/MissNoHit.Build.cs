@@ -46,6 +46,8 @@ public class MissNoHit : ModuleRules
 			}
 			);
 		
+		SetupGameplayDebuggerSupport(Target);
+		
 		
 		DynamicallyLoadedModuleNames.AddRange(
 			new string[]
@@ -1,24 +1,66 @@
 ﻿// Copyright 2024 Eren Balatkan. All Rights Reserved.
 
 #include "MissNoHit.h"
+#include "MnhCapture.h"
+#include "MnhConsoleVariables.h"
+#include "MnhDebugDraw.h"
+#include "MnhGameplayDebugger.h"
+#include "MnhTrace.h"
 #include "MnhTracer.h"
 #include "MnhTracerComponent.h"
+#include "Algo/Sort.h"
 #include "Async/ParallelFor.h"
 #include "Components/StaticMeshComponent.h"
 #include "Kismet/GameplayStatics.h"
+#include "Misc/CoreDelegates.h"
 #include "UnrealEngine.h"
+#include "VisualLogger/VisualLogger.h"
 
 #define LOCTEXT_NAMESPACE "FMissNoHitModule"
 
 void FMissNoHitModule::StartupModule()
 {
-	this->TracerDatas.Reserve(4096);
+	Instance = this;
+	LLM_SCOPE_BYTAG(MissNoHit_Registry);
+	this->TracerDatas.Reserve(FMath::Max(FMnhConsoleVariables::InitialTracerPoolSize, 0));
+	bWarnedTracerPoolGrowth = false;
+	DebugDrawBatcher = MakeUnique<FMnhDebugDrawBatcher>();
+
+#if WITH_GAMEPLAY_DEBUGGER
+	// The module starts before the engine, the Gameplay Debugger is only ready once it is initialized
+	FCoreDelegates::OnPostEngineInit.AddLambda([]()
+	{
+		IGameplayDebugger& GameplayDebuggerModule = IGameplayDebugger::Get();
+		GameplayDebuggerModule.RegisterCategory("MissNoHit",
+			IGameplayDebugger::FOnGetCategory::CreateStatic(&FGameplayDebuggerCategory_MissNoHit::MakeInstance),
+			EGameplayDebuggerCategoryState::EnabledInGameAndSimulate);
+		GameplayDebuggerModule.NotifyCategoriesChanged();
+	});
+#endif
 }
 
 void FMissNoHitModule::ShutdownModule()
 {
+#if WITH_GAMEPLAY_DEBUGGER
+	if (IGameplayDebugger::IsAvailable())
+	{
+		IGameplayDebugger& GameplayDebuggerModule = IGameplayDebugger::Get();
+		GameplayDebuggerModule.UnregisterCategory("MissNoHit");
+		GameplayDebuggerModule.NotifyCategoriesChanged();
+	}
+#endif
+	for (auto& [SourceComponent, PoseSource] : AnimationPoseSources)
+	{
+		ReleaseAnimationPoseSource(PoseSource.Get());
+	}
+	AnimationPoseSources.Empty();
+	PendingPoseSourceBinds.Empty();
+	StopCapture();
+	Instance = nullptr;
 }
 
+FMissNoHitModule::~FMissNoHitModule() = default;
+
 
 void FMissNoHitModule::Tick(float DeltaTime)
 {
@@ -28,19 +70,41 @@ void FMissNoHitModule::Tick(float DeltaTime)
 	// Lock removals so we don't get any modifications to the array while we are iterating
 	RemovalLock = true;
 	
+	const uint64 TickStartCycles = FPlatformTime::Cycles64();
+	uint64 PhaseStartCycles = TickStartCycles;
+	const auto EndPhase = [&PhaseStartCycles](double& OutSeconds)
+	{
+		const uint64 Cycles = FPlatformTime::Cycles64();
+		OutSeconds = FPlatformTime::ToSeconds64(Cycles - PhaseStartCycles);
+		PhaseStartCycles = Cycles;
+	};
+	
+	ApplyTracerCommands();
+	EndPhase(LastTickTimings.ApplyTracerCommands);
 	UpdateTracerTransforms(DeltaTime);
+	EndPhase(LastTickTimings.UpdateTracerTransforms);
 	PerformTraces(DeltaTime);
+	EndPhase(LastTickTimings.PerformTraces);
+	if (CaptureRecorder)
+	{
+		CaptureRecorder->RecordFrame(TickIdx, DeltaTime, MakeArrayView(TracerDatas.GetData(), NumActiveTracerDatas));
+	}
+	EndPhase(LastTickTimings.Capture);
 	NotifyTraceResults();
+	EndPhase(LastTickTimings.NotifyTraceResults);
+	FlushHitEvents();
+	EndPhase(LastTickTimings.FlushHitEvents);
+	LastTickTimings.Total = FPlatformTime::ToSeconds64(PhaseStartCycles - TickStartCycles);
+
+#if MNH_WITH_TRACER_STATS
+	FMnhTracerStats::Get().EndFrame(NumActiveTracerDatas);
+#endif
 
 	// Reverse iterate, remove pending removals
 	RemovalLock = false;
-	for (int TracerDataIdx = TracerDatas.Num() - 1; TracerDataIdx >= 0; TracerDataIdx--)
+	for (int TracerDataIdx = NumActiveTracerDatas - 1; TracerDataIdx >= 0; TracerDataIdx--)
 	{
 		const auto& TracerData = TracerDatas[TracerDataIdx];
-		if (!TracerDatas.IsValidIndex(TracerDataIdx))
-		{
-			continue;
-		}
 		
 		if (TracerData.IsPendingRemoval)
 		{
@@ -52,22 +116,25 @@ void FMissNoHitModule::Tick(float DeltaTime)
 void FMissNoHitModule::RemoveTracerDataAt(const int TracerDataIdx, const FGuid Guid)
 {
 	SCOPE_CYCLE_COUNTER(STAT_MnhRemoveTracer)
-	if (TracerDatas.IsValidIndex(TracerDataIdx) && TracerDatas[TracerDataIdx].Guid == Guid)
+	if (TracerDataIdx >= 0 && TracerDataIdx < NumActiveTracerDatas && TracerDatas[TracerDataIdx].Guid == Guid)
 	{
-		FScopeLock ScopeLock(&CriticalSection);
-		TracerDatas.RemoveAtSwap(TracerDataIdx);
+		DetachAnimationPoseSource(TracerDatas[TracerDataIdx]);
+		// Move the last active slot into the hole, the released slot goes back to the pool with its buffers intact
+		const int LastActiveIdx = --NumActiveTracerDatas;
+		TracerDatas.Swap(TracerDataIdx, LastActiveIdx);
+		TracerDatas[LastActiveIdx].ResetForReuse();
 
-		// If we removed the last element in array we don't need to update the index of the tracer
-		if (TracerDatas.IsValidIndex(TracerDataIdx))
+		// If we removed the last active element we don't need to update the index of the tracer
+		if (TracerDataIdx != LastActiveIdx)
 		{
-			const auto TracerData = TracerDatas[TracerDataIdx];
+			const auto& TracerData = TracerDatas[TracerDataIdx];
 			if (TracerData.bUsesTracerConfig)
 			{
 				TracerData.OwnerTracerComponent->TracerConfigs[TracerData.OwnerTracerConfigIdx].TracerDataIdx = TracerDataIdx;
 			}
 			else
 			{
-				TracerDatas[TracerDataIdx].OwnerTracer->TracerDataIdx = TracerDataIdx;
+				TracerData.OwnerTracer->TracerDataIdx = TracerDataIdx;
 			}
 		}
 	}
@@ -76,12 +143,15 @@ void FMissNoHitModule::RemoveTracerDataAt(const int TracerDataIdx, const FGuid G
 void FMissNoHitModule::UpdateTracerTransforms(const float DeltaTime)
 {
 	SCOPE_CYCLE_COUNTER(STAT_MnhTracerUpdateTransforms);
-	ParallelFor(TracerDatas.Num(), [&](const int32 TracerDataIdx)
 	{
-		if (!TracerDatas.IsValidIndex(TracerDataIdx)){
-			return;
-		}
+		LLM_SCOPE_BYTAG(MissNoHit_Registry);
+		TracersWithoutPoseSourceQueue.Reset(NumActiveTracerDatas);
+	}
+	ParallelFor(TEXT("MnhUpdateTracerTransforms"), NumActiveTracerDatas, FMath::Max(FMnhConsoleVariables::ParallelBatchSize, 1),
+		[&](const int32 TracerDataIdx)
+	{
 		auto& TracerData = TracerDatas[TracerDataIdx];
+		TracerData.ApplyPendingChanges();
 		if (TracerData.TracerState == EMnhTracerState::Stopped)
 		{
 			return;
@@ -91,6 +161,7 @@ void FMissNoHitModule::UpdateTracerTransforms(const float DeltaTime)
 		{
 			TracerData.TracerState = EMnhTracerState::Stopped;
 			TracerData.bShouldTickThisFrame = false;
+			MNH_TRACE(TickDecision(TracerData, false, EMnhTraceTickReason::SourceInvalid));
 			return;
 		}
 		
@@ -107,114 +178,284 @@ void FMissNoHitModule::UpdateTracerTransforms(const float DeltaTime)
 		{
 			TracerData.bShouldTickThisFrame = true;
 			TracerData.TracerTransformsOverTime.Add(CurrentTransform);
+			MNH_TRACE(TickDecision(TracerData, true, EMnhTraceTickReason::PendingStop));
 			return;
 		}
 		
-		switch (TracerData.TracerTickType)
+		EMnhCoreTickType TickType;
+		float TickInterval;
+		FMnhConsoleVariables::GetTickSchedule(TracerData.TracerTickType, TracerData.TickInterval, TickType, TickInterval);
+		switch (TickType)
 		{
-		case EMnhTracerTickType::MatchGameTick:
+		case EMnhCoreTickType::MatchGameTick:
 			TracerData.TracerTransformsOverTime.Add(CurrentTransform);
 			TracerData.bShouldTickThisFrame = true;
+			MNH_TRACE(TickDecision(TracerData, true, EMnhTraceTickReason::MatchGameTick));
 			return;
-		case EMnhTracerTickType::DistanceTick:
-			if ((TracerData.TracerTransformsOverTime[0].GetLocation() - CurrentTransform.GetLocation()).Length() >= TracerData.TickInterval)
+		case EMnhCoreTickType::DistanceTick:
+			if (FMnhCoreScheduling::ShouldTick(EMnhCoreTickType::DistanceTick,
+				(TracerData.TracerTransformsOverTime[0].GetLocation() - CurrentTransform.GetLocation()).Length(), TracerData.DeltaTimeLastTick,
+				DeltaTime, TickInterval))
 			{
 				TracerData.TracerTransformsOverTime.Add(CurrentTransform);
 				TracerData.bShouldTickThisFrame = true;
 			}
+			MNH_TRACE(TickDecision(TracerData, TracerData.bShouldTickThisFrame,
+				TracerData.bShouldTickThisFrame ? EMnhTraceTickReason::DistanceReached : EMnhTraceTickReason::DistanceNotReached));
 			return;
-		case EMnhTracerTickType::FixedRateTick:
-			if (TracerData.DeltaTimeLastTick + DeltaTime > TracerData.TickInterval / 2){
+		case EMnhCoreTickType::FixedRateTick:
+			if (FMnhCoreScheduling::ShouldTick(EMnhCoreTickType::FixedRateTick, 0, TracerData.DeltaTimeLastTick, DeltaTime, TickInterval))
+			{
 				TracerData.TracerTransformsOverTime.Add(CurrentTransform);
 				TracerData.bShouldTickThisFrame = true;
 			}
+			MNH_TRACE(TickDecision(TracerData, TracerData.bShouldTickThisFrame,
+				TracerData.bShouldTickThisFrame ? EMnhTraceTickReason::FixedRateDue : EMnhTraceTickReason::FixedRateNotDue));
 			return;
+		case EMnhCoreTickType::AnimationFinalized:
+			{
+				const auto& PoseSource = TracerData.AnimationPoseSource;
+				if (!PoseSource || PoseSource->SourceComponentKey != TObjectKey<UPrimitiveComponent>(TracerData.SourceComponent))
+				{
+					// Only when the tick type changed without a command, bound before the next tick's workers
+					TracersWithoutPoseSourceQueue.Enqueue(TracerDataIdx);
+				}
+				else if (const uint32 PoseSerial = PoseSource->GetPoseSerial(); !PoseSource->bIsSkeletalMesh || PoseSerial != TracerData.LastSweptPoseSerial)
+				{
+					TracerData.LastSweptPoseSerial = PoseSerial;
+					TracerData.TracerTransformsOverTime.Add(CurrentTransform);
+					TracerData.bShouldTickThisFrame = true;
+				}
+				MNH_TRACE(TickDecision(TracerData, TracerData.bShouldTickThisFrame,
+					TracerData.bShouldTickThisFrame ? EMnhTraceTickReason::PoseFinalized : EMnhTraceTickReason::PoseNotFinalized));
+				return;
+			}
 		}
-	});
+	}, FMnhConsoleVariables::GetParallelForFlags(NumActiveTracerDatas));
+
+	// Drained before removals can move the tracers
+	const auto TracersWithoutPoseSource = TracersWithoutPoseSourceQueue.Drain();
+	if (TracersWithoutPoseSource.Num() > 0)
+	{
+		LLM_SCOPE_BYTAG(MissNoHit_Registry);
+		for (const int32 TracerDataIdx : TracersWithoutPoseSource)
+		{
+			PendingPoseSourceBinds.Emplace(TracerDataIdx, TracerDatas[TracerDataIdx].Guid);
+		}
+	}
+}
+
+void FMissNoHitModule::BindAnimationPoseSources()
+{
+	if (PendingPoseSourceBinds.Num() == 0)
+	{
+		return;
+	}
+
+	LLM_SCOPE_BYTAG(MissNoHit_Registry);
+	// Sources left behind by re-attached tracers are released here, binding is rare enough to pay for the scan
+	for (auto It = AnimationPoseSources.CreateIterator(); It; ++It)
+	{
+		if (It->Value.GetSharedReferenceCount() == 1)
+		{
+			ReleaseAnimationPoseSource(It->Value.Get());
+			It.RemoveCurrent();
+		}
+	}
+
+	for (const auto& [TracerDataIdx, Guid] : PendingPoseSourceBinds)
+	{
+		FMnhTracerData* TracerDataPtr = FindTracerData(TracerDataIdx, Guid);
+		if (!TracerDataPtr || TracerDataPtr->TracerState == EMnhTracerState::Stopped)
+		{
+			continue;
+		}
+		auto& TracerData = *TracerDataPtr;
+		// Staged attachment and tick policy decide which pose the tracer waits for
+		TracerData.ApplyPendingChanges();
+		EMnhCoreTickType TickType;
+		float TickInterval;
+		FMnhConsoleVariables::GetTickSchedule(TracerData.TracerTickType, TracerData.TickInterval, TickType, TickInterval);
+		UPrimitiveComponent* SourceComponent = TracerData.SourceComponent;
+		if (TickType != EMnhCoreTickType::AnimationFinalized || !IsValid(SourceComponent))
+		{
+			continue;
+		}
+		if (TracerData.AnimationPoseSource && TracerData.AnimationPoseSource->SourceComponentKey == TObjectKey<UPrimitiveComponent>(SourceComponent))
+		{
+			continue;
+		}
+		DetachAnimationPoseSource(TracerData);
+
+		if (const auto PoseSource = AnimationPoseSources.Find(SourceComponent))
+		{
+			TracerData.AnimationPoseSource = *PoseSource;
+			TracerData.LastSweptPoseSerial = (*PoseSource)->GetPoseSerial();
+			continue;
+		}
+
+		const TSharedRef<FMnhAnimationPoseSource> PoseSource = MakeShared<FMnhAnimationPoseSource>();
+		PoseSource->SourceComponentKey = SourceComponent;
+		if (USkeletalMeshComponent* Mesh = Cast<USkeletalMeshComponent>(SourceComponent))
+		{
+			PoseSource->Mesh = Mesh;
+			PoseSource->bIsSkeletalMesh = true;
+			PoseSource->BoneTransformsFinalizedHandle = Mesh->RegisterOnBoneTransformsFinalizedDelegate(
+				FOnBoneTransformsFinalizedMultiCast::FDelegate::CreateSPLambda(PoseSource, [PoseSourcePtr = &PoseSource.Get()]()
+				{
+					PoseSourcePtr->PoseSerial.fetch_add(1, std::memory_order_relaxed);
+				}));
+		}
+		else
+		{
+			FMnhHelpers::Mnh_Log(FString::Printf(TEXT("MissNoHit Warning: Tracer [%s] ticks on Animation Finalized but its source"
+				" component [%s] is not a Skeletal Mesh, it ticks with the game instead"), *TracerData.GetTracerTag().ToString(),
+				*SourceComponent->GetName()));
+		}
+		AnimationPoseSources.Add(SourceComponent, PoseSource);
+		TracerData.AnimationPoseSource = PoseSource;
+		TracerData.LastSweptPoseSerial = PoseSource->GetPoseSerial();
+	}
+	PendingPoseSourceBinds.Reset();
+}
+
+void FMissNoHitModule::DetachAnimationPoseSource(FMnhTracerData& TracerData)
+{
+	if (!TracerData.AnimationPoseSource)
+	{
+		return;
+	}
+	
+	const TObjectKey<UPrimitiveComponent> SourceComponentKey = TracerData.AnimationPoseSource->SourceComponentKey;
+	TracerData.AnimationPoseSource.Reset();
+	// Released with its last tracer so the mesh stops notifying the module
+	const auto PoseSource = AnimationPoseSources.Find(SourceComponentKey);
+	if (PoseSource && PoseSource->GetSharedReferenceCount() == 1)
+	{
+		ReleaseAnimationPoseSource(PoseSource->Get());
+		AnimationPoseSources.Remove(SourceComponentKey);
+	}
+}
+
+void FMissNoHitModule::ReleaseAnimationPoseSource(FMnhAnimationPoseSource& PoseSource)
+{
+	if (USkeletalMeshComponent* Mesh = PoseSource.Mesh.Get())
+	{
+		Mesh->UnregisterOnBoneTransformsFinalizedDelegate(PoseSource.BoneTransformsFinalizedHandle);
+	}
+	PoseSource.BoneTransformsFinalizedHandle.Reset();
 }
 
 void FMissNoHitModule::PerformTraces(const float DeltaTime)
 {
 	SCOPE_CYCLE_COUNTER(STAT_MnhTracerDoTrace)
 
-	ParallelFor(TracerDatas.Num(), [&](const int32 TracerDataIdx)
+	// Each tracer is pushed at most once per tick
+	{
+		LLM_SCOPE_BYTAG(MissNoHit_Registry);
+		TracersWithHitsQueue.Reset(NumActiveTracerDatas);
+	}
+	const AActor* DebugDrawPriorityActor = DebugDrawBatcher->GetPriorityActor();
+	const bool bDebugDraw = FMnhConsoleVariables::bDebugDraw;
+	ParallelFor(TEXT("MnhPerformTraces"), NumActiveTracerDatas, FMath::Max(FMnhConsoleVariables::ParallelBatchSize, 1),
+		[&](const int32 TracerDataIdx)
 	{
-		if (!TracerDatas.IsValidIndex(TracerDataIdx)){
-			return;
-		}
 		auto& TracerData = TracerDatas[TracerDataIdx];
+#if MNH_WITH_TRACER_STATS
+		FMnhTracerCounters FrameCounters;
+#endif
 		if (TracerData.bShouldTickThisFrame)
 		{
-			int SubSteps = 1;
-			if (TracerData.TracerTickType == EMnhTracerTickType::DistanceTick)
+			EMnhCoreTickType TickType;
+			float TickInterval;
+			FMnhConsoleVariables::GetTickSchedule(TracerData.TracerTickType, TracerData.TickInterval, TickType, TickInterval);
+			const double DistanceTraveled = TickType == EMnhCoreTickType::DistanceTick
+				? (TracerData.TracerTransformsOverTime[0].GetLocation() - TracerData.TracerTransformsOverTime[1].GetLocation()).Length()
+				: 0;
+			const int SubSteps = FMnhCoreScheduling::GetSubstepCount(TickType, DistanceTraveled,
+				DeltaTime, TickInterval, FMath::Max(FMnhConsoleVariables::MaxSubsteps, 1));
+#if MNH_WITH_TRACER_STATS
+			const uint64 SweepStartCycles = FPlatformTime::Cycles64();
+#endif
+			TracerData.DoTrace(SubSteps, TickIdx);
+
+			int32 NumHits = 0;
+			for (const auto& SubstepResults : TracerData.GetSubstepHits())
 			{
-				SubSteps = FMath::CeilToInt((TracerData.TracerTransformsOverTime[0].GetLocation() - TracerData.TracerTransformsOverTime[1].GetLocation()).Length() / TracerData.TickInterval);
+				NumHits += SubstepResults.HitResults.Num();
 			}
-			else if (TracerData.TracerTickType == EMnhTracerTickType::FixedRateTick)
+			if (NumHits > 0)
 			{
-				SubSteps = FMath::CeilToInt(DeltaTime / TracerData.TickInterval);
+				TracersWithHitsQueue.Enqueue(TracerDataIdx);
 			}
-			SubSteps = FMath::Min(10, SubSteps);
-			TracerData.DoTrace(SubSteps, TickIdx);
+			
+#if MNH_WITH_TRACER_STATS
+			FrameCounters.NumTicks = 1;
+			FrameCounters.NumSweeps = TracerData.NumSubstepHits;
+			FrameCounters.NumHits = NumHits;
+			FrameCounters.SweepCycles = FPlatformTime::Cycles64() - SweepStartCycles;
+#endif
 		}
 		
 		TracerData.DeltaTimeLastTick += DeltaTime;
-	});
+		if (TracerData.bShouldTickThisFrame && bDebugDraw && TracerData.Definition->DrawDebugType != EDrawDebugTrace::None)
+		{
+			const auto& Definition = *TracerData.Definition;
+			const bool bIsPriority = DebugDrawPriorityActor && TracerData.OwnerTracerComponent
+				&& TracerData.OwnerTracerComponent->GetOwner() == DebugDrawPriorityActor;
+			for (const auto& SubstepResults : TracerData.GetSubstepHits())
+			{
+				DebugDrawBatcher->AddSweep(SubstepResults.StartLocation,
+					SubstepResults.EndLocation,
+					SubstepResults.Scale,
+					SubstepResults.Rotation,
+					SubstepResults.HitResults, TracerData.ShapeData, TracerData.World,
+					Definition.DrawDebugType,
+					Definition.DrawDebugType == EDrawDebugTrace::ForOneFrame ? TracerData.DeltaTimeLastTick : Definition.DebugDrawTime,
+					Definition.DebugTraceColor, Definition.DebugTraceBlockColor, Definition.DebugTraceHitColor, bIsPriority);
+			}
+		}
+#if MNH_WITH_TRACER_STATS
+		if (TracerData.StatsEntry && (TracerData.bShouldTickThisFrame || TracerData.TracerState != EMnhTracerState::Stopped))
+		{
+			FrameCounters.ActiveTime = DeltaTime;
+			TracerData.Counters.Add(FrameCounters);
+			TracerData.StatsEntry->Add(FrameCounters);
+		}
+#endif
+	}, FMnhConsoleVariables::GetParallelForFlags(NumActiveTracerDatas));
 }
 
 void FMissNoHitModule::NotifyTraceResults()
 {
-	for (auto& TracerData : TracerDatas)
+	DebugDrawBatcher->Submit();
+#if ENABLE_VISUAL_LOG
+	if (FVisualLogger::IsRecording())
 	{
-		if (!TracerData.bShouldTickThisFrame)
-		{
-			continue;
-		}
-		
-		const auto OwnerTracer = TracerData.OwnerTracer;
-		for (const auto& SubstepResults : TracerData.SubstepHits)
+		for (const auto& TracerData : MakeArrayView(TracerDatas.GetData(), NumActiveTracerDatas))
 		{
-			// Respect cancellations by user-defined code immediately.
-			if (TracerData.TracerState == EMnhTracerState::Stopped)
+			if (TracerData.bShouldTickThisFrame)
 			{
-				break;
+				FMnhVisualLogger::LogTracerSweeps(TracerData);
 			}
+		}
+	}
+#endif
 
-			if (TracerData.bUsesTracerConfig)
-			{
-				auto& TracerConfig = TracerData.OwnerTracerComponent->TracerConfigs[TracerData.OwnerTracerConfigIdx];
-				if (TracerConfig.DrawDebugType != EDrawDebugTrace::None)
-				{
-					FMnhHelpers::DrawDebug(SubstepResults.StartLocation,
-						SubstepResults.EndLocation,
-						SubstepResults.Scale,
-						SubstepResults.Rotation,
-						SubstepResults.HitResults, TracerData.ShapeData, TracerData.World,
-						TracerConfig.DrawDebugType,
-						TracerConfig.DrawDebugType == EDrawDebugTrace::ForOneFrame ? TracerData.DeltaTimeLastTick : TracerConfig.DebugDrawTime,
-						TracerConfig.DebugTraceColor, TracerConfig.DebugTraceBlockColor, TracerConfig.DebugTraceHitColor);
-				}
+	// Dispatch in TracerDatas order so filtering across tracers does not depend on worker scheduling
+	auto TracersWithHits = TracersWithHitsQueue.Drain();
+	Algo::Sort(TracersWithHits);
+	for (const int32 TracerDataIdx : TracersWithHits)
+	{
+		DispatchTracerHits(TracerDataIdx);
+	}
 
-				TracerData.OwnerTracerComponent->OnTracerHitDetected(TracerConfig.TracerTag, SubstepResults.HitResults,
-					TracerData.DeltaTimeLastTick / TracerData.SubstepHits.Num(), TickIdx);
-			}
-			else
-			{
-				if (TracerData.OwnerTracer->DrawDebugType != EDrawDebugTrace::None)
-				{
-					FMnhHelpers::DrawDebug(SubstepResults.StartLocation,
-						SubstepResults.EndLocation,
-						SubstepResults.Scale,
-						SubstepResults.Rotation,
-						SubstepResults.HitResults, TracerData.ShapeData, TracerData.World,
-						OwnerTracer->DrawDebugType,
-						OwnerTracer->DrawDebugType == EDrawDebugTrace::ForOneFrame ? TracerData.DeltaTimeLastTick : OwnerTracer->DebugDrawTime,
-						OwnerTracer->DebugTraceColor, OwnerTracer->DebugTraceBlockColor, OwnerTracer->DebugTraceHitColor);
-				}
-			
-				TracerData.OwnerTracerComponent->OnTracerHitDetected(TracerData.OwnerTracer->TracerTag, SubstepResults.HitResults,
-					TracerData.DeltaTimeLastTick / TracerData.SubstepHits.Num(), TickIdx);
-			}
+	// User-defined code may have registered tracers while handling hits, which can reallocate TracerDatas
+	for (auto& TracerData : MakeArrayView(TracerDatas.GetData(), NumActiveTracerDatas))
+	{
+		if (!TracerData.bShouldTickThisFrame)
+		{
+			continue;
 		}
 			
 		TracerData.DeltaTimeLastTick = 0;
@@ -232,11 +473,103 @@ void FMissNoHitModule::NotifyTraceResults()
 	}
 }
 
+void FMissNoHitModule::DispatchTracerHits(const int32 TracerDataIdx)
+{
+	const int SubstepCount = TracerDatas[TracerDataIdx].NumSubstepHits;
+	for (int SubstepIdx = 0; SubstepIdx < SubstepCount; SubstepIdx++)
+	{
+		// User-defined code may register new tracers while handling hits, so TracerData is looked up again every substep
+		const auto& TracerData = TracerDatas[TracerDataIdx];
+		
+		// Respect cancellations by user-defined code immediately.
+		if (TracerData.TracerState == EMnhTracerState::Stopped)
+		{
+			break;
+		}
+
+		const auto& SubstepResults = TracerData.SubstepHits[SubstepIdx];
+		if (SubstepResults.HitResults.Num() == 0)
+		{
+			continue;
+		}
+
+#if MNH_TRACE_ENABLED
+		if (FMnhTraceEvents::IsEnabled())
+		{
+			for (const auto& HitResult : SubstepResults.HitResults)
+			{
+				FMnhTraceEvents::HitDispatched(TracerData, SubstepIdx, HitResult);
+			}
+		}
+#endif
+		[[maybe_unused]] const int32 NumHits = SubstepResults.HitResults.Num();
+		// Substep hits are only rewritten by the next PerformTraces, after this tick's FlushHitEvents
+		[[maybe_unused]] const int32 NumAcceptedHits = TracerData.OwnerTracerComponent->OnTracerHitDetected(TracerData.GetTracerTag(),
+			SubstepResults.HitResults, TracerData.DeltaTimeLastTick / SubstepCount, TickIdx, true);
+		
+#if MNH_WITH_TRACER_STATS
+		// Looked up again, listeners may have registered tracers
+		auto& DispatchedTracerData = TracerDatas[TracerDataIdx];
+		DispatchedTracerData.Counters.NumFilteredHits += NumHits - NumAcceptedHits;
+		if (DispatchedTracerData.StatsEntry)
+		{
+			FMnhTracerCounters FilteredCounters;
+			FilteredCounters.NumFilteredHits = NumHits - NumAcceptedHits;
+			DispatchedTracerData.StatsEntry->Add(FilteredCounters);
+		}
+#endif
+	}
+}
+
+void FMissNoHitModule::FlushHitEvents()
+{
+	SCOPE_CYCLE_COUNTER(STAT_MnhFlushHitEvents)
+
+	// Components can request another flush while we are broadcasting, those are handled on the next tick
+	auto ComponentsToFlush = MoveTemp(PendingHitEventsFlushes);
+	for (const auto& TracerComponent : ComponentsToFlush)
+	{
+		if (TracerComponent.IsValid())
+		{
+			TracerComponent->FlushHitEvents();
+		}
+	}
+}
+
+void FMissNoHitModule::RequestHitEventsFlush(UMnhTracerComponent* TracerComponent)
+{
+	LLM_SCOPE_BYTAG(MissNoHit_Registry);
+	PendingHitEventsFlushes.Add(TracerComponent);
+}
+
+bool FMissNoHitModule::StartCapture(const FString& FilePath)
+{
+	LLM_SCOPE_BYTAG(MissNoHit_Debug);
+	auto Recorder = MakeUnique<FMnhCaptureRecorder>();
+	if (!Recorder->Open(FilePath))
+	{
+		return false;
+	}
+	CaptureRecorder = MoveTemp(Recorder);
+	return true;
+}
+
+void FMissNoHitModule::StopCapture()
+{
+	CaptureRecorder.Reset();
+}
+
 void FMissNoHitModule::MarkTracerDataForRemoval(const int TracerDataIdx, const FGuid Guid)
 {
+	if (!IsInGameThread())
+	{
+		EnqueueTracerCommand({EMnhTracerCommandType::Remove, TracerDataIdx, Guid});
+		return;
+	}
+	
 	if (RemovalLock)
 	{
-		if (TracerDatas.IsValidIndex(TracerDataIdx) && TracerDatas[TracerDataIdx].Guid == Guid)
+		if (TracerDataIdx >= 0 && TracerDataIdx < NumActiveTracerDatas && TracerDatas[TracerDataIdx].Guid == Guid)
 		{
 			TracerDatas[TracerDataIdx].IsPendingRemoval = true;
 		}
@@ -248,16 +581,234 @@ void FMissNoHitModule::MarkTracerDataForRemoval(const int TracerDataIdx, const F
 	
 }
 
+void FMissNoHitModule::ChangeTracerState(const int TracerDataIdx, const FGuid Guid, const bool bIsTracerActive, const bool bStopImmediate)
+{
+	if (!IsInGameThread())
+	{
+		const auto CommandType = bIsTracerActive ? EMnhTracerCommandType::Start
+			: bStopImmediate ? EMnhTracerCommandType::Stop : EMnhTracerCommandType::StopDelayed;
+		EnqueueTracerCommand({CommandType, TracerDataIdx, Guid});
+		return;
+	}
+
+	if (const auto TracerData = FindTracerData(TracerDataIdx, Guid))
+	{
+		TracerData->ChangeTracerState(bIsTracerActive, bStopImmediate);
+		if (bIsTracerActive)
+		{
+			PendingPoseSourceBinds.Emplace(TracerDataIdx, Guid);
+		}
+		else
+		{
+			// Pending stop sweeps do not wait for a pose, a restarted tracer is bound again
+			DetachAnimationPoseSource(*TracerData);
+		}
+	}
+}
+
+void FMissNoHitModule::UpdateTracerData(const int TracerDataIdx, const FGuid Guid, const FMnhTracerDataChangeSet& Changes)
+{
+	if (!IsInGameThread())
+	{
+		EnqueueTracerCommand({EMnhTracerCommandType::Update, TracerDataIdx, Guid, Changes});
+		return;
+	}
+
+	if (const auto TracerData = FindTracerData(TracerDataIdx, Guid))
+	{
+		TracerData->PendingChanges.Merge(Changes);
+		if (EnumHasAnyFlags(Changes.DirtyFlags, EMnhTracerDataDirtyFlags::Attachment | EMnhTracerDataDirtyFlags::TickPolicy))
+		{
+			PendingPoseSourceBinds.Emplace(TracerDataIdx, Guid);
+		}
+	}
+}
+
+void FMissNoHitModule::AddIgnoredActor(const TSharedRef<FMnhIgnoreSet>& IgnoreSet, const AActor* Actor)
+{
+	if (!IsInGameThread())
+	{
+		EnqueueTracerCommand({EMnhTracerCommandType::AddIgnoredActor, -1, FGuid(), {}, IgnoreSet, Actor});
+		return;
+	}
+	IgnoreSet->AddIgnoredActor(Actor);
+}
+
+void FMissNoHitModule::RemoveIgnoredActor(const TSharedRef<FMnhIgnoreSet>& IgnoreSet, const AActor* Actor)
+{
+	if (!IsInGameThread())
+	{
+		EnqueueTracerCommand({EMnhTracerCommandType::RemoveIgnoredActor, -1, FGuid(), {}, IgnoreSet, Actor});
+		return;
+	}
+	IgnoreSet->RemoveIgnoredActor(Actor);
+}
+
+void FMissNoHitModule::EnqueueTracerCommand(FMnhTracerCommand&& Command)
+{
+	LLM_SCOPE_BYTAG(MissNoHit_Registry);
+	TracerCommands.Enqueue(MoveTemp(Command));
+}
+
+void FMissNoHitModule::ApplyTracerCommands()
+{
+	SCOPE_CYCLE_COUNTER(STAT_MnhApplyTracerCommands)
+	LLM_SCOPE_BYTAG(MissNoHit_Registry);
+	
+	// Applied in the order they were issued, index hints can be stale and ignore set commands must stay in place
+	// relative to the starts and stops around them
+	while (TOptional<FMnhTracerCommand> Command = TracerCommands.Dequeue())
+	{
+		ApplyTracerCommand(Command.GetValue());
+	}
+
+	// Bound before the workers run, so a tracer started or re-attached this tick already waits for its mesh's next pose
+	BindAnimationPoseSources();
+}
+
+void FMissNoHitModule::ApplyTracerCommand(FMnhTracerCommand& Command)
+{
+	switch (Command.Type)
+	{
+	case EMnhTracerCommandType::AddIgnoredActor:
+		Command.IgnoreSet->AddIgnoredActor(Command.Actor.Get());
+		return;
+	case EMnhTracerCommandType::RemoveIgnoredActor:
+		Command.IgnoreSet->RemoveIgnoredActor(Command.Actor.Get());
+		return;
+	default:
+		break;
+	}
+	
+	const auto TracerData = FindTracerData(Command.TracerDataIdx, Command.TracerDataGuid);
+	if (!TracerData)
+	{
+		return;
+	}
+	
+	switch (Command.Type)
+	{
+	case EMnhTracerCommandType::Remove:
+		// Commands are applied during the tick, so removal is deferred like any other removal requested while ticking
+		TracerData->IsPendingRemoval = true;
+		break;
+	case EMnhTracerCommandType::Start:
+		TracerData->ChangeTracerState(true);
+		PendingPoseSourceBinds.Emplace(Command.TracerDataIdx, Command.TracerDataGuid);
+		break;
+	case EMnhTracerCommandType::Stop:
+		TracerData->ChangeTracerState(false, true);
+		DetachAnimationPoseSource(*TracerData);
+		break;
+	case EMnhTracerCommandType::StopDelayed:
+		TracerData->ChangeTracerState(false, false);
+		DetachAnimationPoseSource(*TracerData);
+		break;
+	case EMnhTracerCommandType::Update:
+		TracerData->PendingChanges.Merge(Command.Changes);
+		if (EnumHasAnyFlags(Command.Changes.DirtyFlags, EMnhTracerDataDirtyFlags::Attachment | EMnhTracerDataDirtyFlags::TickPolicy))
+		{
+			PendingPoseSourceBinds.Emplace(Command.TracerDataIdx, Command.TracerDataGuid);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+FMnhTracerData* FMissNoHitModule::FindTracerData(const int TracerDataIdx, const FGuid& Guid)
+{
+	if (TracerDataIdx >= 0 && TracerDataIdx < NumActiveTracerDatas && TracerDatas[TracerDataIdx].Guid == Guid)
+	{
+		return &TracerDatas[TracerDataIdx];
+	}
+
+	// Index hint is stale, the tracer was moved by a removal after the call was made
+	for (int Idx = 0; Idx < NumActiveTracerDatas; Idx++)
+	{
+		if (TracerDatas[Idx].Guid == Guid)
+		{
+			return &TracerDatas[Idx];
+		}
+	}
+	return nullptr;
+}
+
 int FMissNoHitModule::RequestNewTracerData()
 {
-	FScopeLock ScopeLock(&CriticalSection);
-	return TracerDatas.AddDefaulted();
+	return RequestNewTracerDataRange(1);
+}
+
+int FMissNoHitModule::RequestNewTracerDataRange(const int32 Count)
+{
+	// Other threads go through the tracer command queue, so the pool is only touched by the game thread
+	check(IsInGameThread());
+	const int FirstTracerDataIdx = NumActiveTracerDatas;
+	if (NumActiveTracerDatas + Count > TracerDatas.Num())
+	{
+		LLM_SCOPE_BYTAG(MissNoHit_Registry);
+		TracerDatas.SetNum(NumActiveTracerDatas + Count, EAllowShrinking::No);
+	}
+	NumActiveTracerDatas += Count;
+
+	if (NumActiveTracerDatas > FMnhConsoleVariables::InitialTracerPoolSize && !bWarnedTracerPoolGrowth)
+	{
+		bWarnedTracerPoolGrowth = true;
+		FMnhHelpers::Mnh_Log(FString::Printf(TEXT("MissNoHit Warning: %d tracers are registered, more than"
+			" MissNoHit.InitialTracerPoolSize (%d), the tracer data pool had to grow"), NumActiveTracerDatas, FMnhConsoleVariables::InitialTracerPoolSize));
+	}
+	return FirstTracerDataIdx;
+}
+
+void FMissNoHitModule::ReturnTracerDataRange(const int FirstTracerDataIdx, const int32 Count)
+{
+	check(IsInGameThread());
+	check(FirstTracerDataIdx + Count == NumActiveTracerDatas);
+	for (int TracerDataIdx = FirstTracerDataIdx; TracerDataIdx < NumActiveTracerDatas; TracerDataIdx++)
+	{
+		TracerDatas[TracerDataIdx].ResetForReuse();
+	}
+	NumActiveTracerDatas = FirstTracerDataIdx;
+}
+
+SIZE_T FMissNoHitModule::GetAllocatedSize() const
+{
+	SIZE_T AllocatedSize = TracerDatas.GetAllocatedSize();
+	for (const auto& TracerData : TracerDatas)
+	{
+		AllocatedSize += TracerData.GetAllocatedSize();
+	}
+	return AllocatedSize;
+}
+
+FGuid FMissNoHitModule::NewTracerDataGuid()
+{
+	// Only needs to be unique among tracer datas of this session, so a counter is enough
+	TracerDataSerial++;
+	return FGuid(0, 1, uint32(TracerDataSerial >> 32), uint32(TracerDataSerial));
+}
+
+void FMissNoHitModule::WarmUpTracerDataPool(const int32 NumTracerDatas, const int32 SubstepsPerTracer, const int32 HitsPerSubstep)
+{
+	check(IsInGameThread());
+	const int32 RequiredNum = NumActiveTracerDatas + NumTracerDatas;
+	if (TracerDatas.Num() < RequiredNum)
+	{
+		LLM_SCOPE_BYTAG(MissNoHit_Registry);
+		TracerDatas.Reserve(RequiredNum);
+		TracerDatas.SetNum(RequiredNum, EAllowShrinking::No);
+	}
+	
+	for (int32 TracerDataIdx = NumActiveTracerDatas; TracerDataIdx < RequiredNum; TracerDataIdx++)
+	{
+		TracerDatas[TracerDataIdx].ReserveHitBuffers(SubstepsPerTracer, HitsPerSubstep);
+	}
 }
 
 UWorld* FMissNoHitModule::GetTickableGameObjectWorld() const
 {
 	// Hacky way to get the world
-	if (TracerDatas.Num() > 0)
+	if (NumActiveTracerDatas > 0)
 	{
 		return TracerDatas[0].World;
 	}
@@ -2,8 +2,17 @@
 
 #include "MissNoHitBPLibrary.h"
 
+#include "MissNoHit.h"
+#include "MnhTracer.h"
+
 UMissNoHitBPLibrary::UMissNoHitBPLibrary(const FObjectInitializer& ObjectInitializer)
 : Super(ObjectInitializer)
 {
 
 }
+
+void UMissNoHitBPLibrary::WarmUpTracerPool(const int32 TracerCount, const int32 SubstepsPerTracer, const int32 HitsPerSubstep)
+{
+	FMissNoHitModule& MnhModule = FMissNoHitModule::Get();
+	MnhModule.WarmUpTracerDataPool(TracerCount, SubstepsPerTracer, HitsPerSubstep);
+}
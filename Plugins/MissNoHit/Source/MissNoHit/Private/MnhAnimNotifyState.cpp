@@ -4,28 +4,117 @@
 
 #include "Animation/AnimSequence.h"
 #include "Animation/AnimMontage.h"
+#include "Engine/World.h"
+#include "MissNoHit.h"
+#include "MnhConsoleVariables.h"
+#include "MnhDebugDraw.h"
 #include "MnhTracer.h"
 #include "MnhTracerComponent.h"
 #include "Kismet/KismetMathLibrary.h"
 #include "Runtime/Launch/Resources/Version.h"
 
 
-UMnhTracerComponent* UMnhAnimNotifyState::FindMnhTracerComponent(const USkeletalMeshComponent* MeshComp)
+FMnhAnimNotifyBinding& UMnhAnimNotifyBindingSubsystem::FindOrResolveBinding(const USkeletalMeshComponent* MeshComp)
 {
+	check(IsInGameThread());
+	const TObjectKey<USkeletalMeshComponent> MeshKey(MeshComp);
+	if (const auto Binding = Bindings.Find(MeshKey))
+	{
+		return *Binding;
+	}
+
+	// Meshes of actors without a tracer component are never invalidated, stale keys are dropped whenever the map doubles
+	if (Bindings.Num() >= FMath::Max(2 * NumBindingsAfterPrune, 64))
+	{
+		PruneStaleBindings();
+	}
+
+	auto& Binding = Bindings.Add(MeshKey);
 	if (const auto OwnerActor = MeshComp->GetOwner())
 	{
-		return OwnerActor->FindComponentByClass<UMnhTracerComponent>();
+		Binding.TracerComponent = OwnerActor->FindComponentByClass<UMnhTracerComponent>();
+	}
+	return Binding;
+}
+
+void UMnhAnimNotifyBindingSubsystem::InvalidateBindings(const AActor* Owner)
+{
+	check(IsInGameThread());
+	if (!Owner || Bindings.Num() == 0)
+	{
+		return;
+	}
+	
+	Owner->ForEachComponent<USkeletalMeshComponent>(false, [this](const USkeletalMeshComponent* MeshComp)
+	{
+		Bindings.Remove(TObjectKey<USkeletalMeshComponent>(MeshComp));
+	});
+}
+
+void UMnhAnimNotifyBindingSubsystem::PruneStaleBindings()
+{
+	for (auto It = Bindings.CreateIterator(); It; ++It)
+	{
+		if (!It->Key.ResolveObjectPtr())
+		{
+			It.RemoveCurrent();
+		}
 	}
-	return nullptr;
+	NumBindingsAfterPrune = Bindings.Num();
+}
+
+FMnhAnimNotifyBinding* UMnhAnimNotifyState::FindOrResolveBinding(const USkeletalMeshComponent* MeshComp)
+{
+	const UWorld* World = MeshComp->GetWorld();
+	const auto BindingSubsystem = World ? World->GetSubsystem<UMnhAnimNotifyBindingSubsystem>() : nullptr;
+	return BindingSubsystem ? &BindingSubsystem->FindOrResolveBinding(MeshComp) : nullptr;
+}
+
+void UMnhAnimNotifyState::InvalidateBindings(const AActor* Owner)
+{
+	const UWorld* World = Owner ? Owner->GetWorld() : nullptr;
+	if (const auto BindingSubsystem = World ? World->GetSubsystem<UMnhAnimNotifyBindingSubsystem>() : nullptr)
+	{
+		BindingSubsystem->InvalidateBindings(Owner);
+	}
+}
+
+UMnhTracerComponent* UMnhAnimNotifyState::FindMnhTracerComponent(const USkeletalMeshComponent* MeshComp)
+{
+	if (const auto Binding = FindOrResolveBinding(MeshComp))
+	{
+		return Binding->TracerComponent.Get();
+	}
+	const auto OwnerActor = MeshComp->GetOwner();
+	return OwnerActor ? OwnerActor->FindComponentByClass<UMnhTracerComponent>() : nullptr;
 }
 
 int UMnhAnimNotifyState::FindTracerConfigIdx(const USkeletalMeshComponent* MeshComp, const FGameplayTag TracerTag)
 {
-	if (const auto TracerComp = FindMnhTracerComponent(MeshComp))
+	const auto BindingPtr = FindOrResolveBinding(MeshComp);
+	if (!BindingPtr)
+	{
+		const auto TracerComp = FindMnhTracerComponent(MeshComp);
+		return TracerComp ? TracerComp->FindTracerConfig(TracerTag) : -1;
+	}
+	
+	auto& Binding = *BindingPtr;
+	const auto TracerComp = Binding.TracerComponent.Get();
+	if (!TracerComp)
 	{
-		return TracerComp->FindTracerConfig(TracerTag);
+		return -1;
 	}
-	return -1;
+	
+	if (Binding.TracerConfigsRevision != TracerComp->GetTracerConfigsRevision())
+	{
+		Binding.TracerConfigIndices.Reset();
+		Binding.TracerConfigsRevision = TracerComp->GetTracerConfigsRevision();
+	}
+	if (const auto TracerConfigIdx = Binding.TracerConfigIndices.Find(TracerTag))
+	{
+		return *TracerConfigIdx;
+	}
+	return Binding.TracerConfigIndices.Add(TracerTag, TracerComp->FindTracerConfig(TracerTag));
 }
 
 void UMnhActivateTracer::NotifyBegin(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, float TotalDuration,
@@ -59,11 +148,11 @@ void UMnhAnimNotifyTracer::NotifyBegin(USkeletalMeshComponent* MeshComp, UAnimSe
 	Super::NotifyBegin(MeshComp, Animation, TotalDuration, EventReference);
 	if (const auto TracerComp = FindMnhTracerComponent(MeshComp))
 	{
-		const auto TracerConfigIdx = TracerComp->FindTracerConfig(TracerTag);
+		const auto TracerConfigIdx = FindTracerConfigIdx(MeshComp, TracerTag);
 		if (TracerConfigIdx != -1)
 		{
 			auto& TracerConfig = TracerComp->TracerConfigs[TracerConfigIdx];
-			if (TracerConfig.TraceSource != EMnhTraceSource::AnimNotify)
+			if (TracerConfig.GetTraceSource() != EMnhTraceSource::AnimNotify)
 			{
 				const FString DebugMessage = FString::Printf(TEXT("MissNoHit Warning: "
 														   "AnimNotifyTracer must have matching AnimNotify Tracer Setup with Tag [%s]"
@@ -77,7 +166,7 @@ void UMnhAnimNotifyTracer::NotifyBegin(USkeletalMeshComponent* MeshComp, UAnimSe
 				TracerConfig.SocketOrBoneName = AttachedSocketOrBoneName;
 				TracerConfig.ShapeData = ShapeData;
 				TracerConfig.SourceComponent = MeshComp;
-				TracerConfig.UpdateTracerData();
+				TracerConfig.UpdateTracerData(EMnhTracerDataDirtyFlags::Shape | EMnhTracerDataDirtyFlags::Attachment);
 				TracerComp->StartTracersInternal(FGameplayTagContainer{TracerTag}, bResetHitCacheOnActivation, true);
 			}
 			else
@@ -219,11 +308,12 @@ void UMnhAnimNotifyTracer::NotifyTick(USkeletalMeshComponent* MeshComp, UAnimSeq
 
 	CurrentTimeInNotify += FrameDeltaTime;
 
+	const auto TracerComp = FindMnhTracerComponent(MeshComp);
 	const auto TracerConfigIdx = FindTracerConfigIdx(MeshComp, TracerTag);
 	
-	if(TracerConfigIdx != -1)
+	if(TracerComp && TracerConfigIdx != -1)
 	{
-		auto& TracerConfig = FindMnhTracerComponent(MeshComp)->TracerConfigs[TracerConfigIdx];
+		auto& TracerConfig = TracerComp->TracerConfigs[TracerConfigIdx];
 		TickIdx ++;
 		
 		const auto NotifyFrameCount = FMath::CeilToInt(FrameDeltaTime * PrecomputeFps);
@@ -251,19 +341,22 @@ void UMnhAnimNotifyTracer::NotifyTick(USkeletalMeshComponent* MeshComp, UAnimSeq
 				0.5, ELerpInterpolationMode::DualQuatInterp);
 			AverageTransform.SetScale3D(FVector::OneVector);
 	
+			const auto& TracerDefinition = TracerConfig.GetDefinition();
 			TArray<FHitResult> OutHits;
 			FMnhHelpers::PerformTrace(
 				CurrentPoseTransform, NextPoseTransform, AverageTransform,
 				OutHits,
 				MeshComp->GetWorld(),
-				TracerConfig.TraceSettings,
+				TracerDefinition.TraceSettings,
 				ShapeData,
-				TracerConfig.CollisionParams, FCollisionResponseParams(), TracerConfig.ObjectQueryParams
+				TracerComp->GetIgnoreSet()->GetCollisionParams(TracerDefinition.TraceSettings.bTraceComplex),
+				FCollisionResponseParams(), TracerDefinition.ObjectQueryParams
 			);
+			FMnhHelpers::SelectBestHitPerActor(OutHits, TracerDefinition.HitSelection, FMnhHelpers::GetTracerTipLocation(NextPoseTransform, ShapeData));
 			
-			if (TracerConfig.DrawDebugType != EDrawDebugTrace::None)
+			if (TracerDefinition.DrawDebugType != EDrawDebugTrace::None && FMnhConsoleVariables::bDebugDraw)
 			{
-				FMnhHelpers::DrawDebug(
+				FMissNoHitModule::Get().GetDebugDrawBatcher().AddSweep(
 					CurrentPoseTransform.GetLocation(),
 					NextPoseTransform.GetLocation(),
 					FVector::OneVector,
@@ -271,18 +364,16 @@ void UMnhAnimNotifyTracer::NotifyTick(USkeletalMeshComponent* MeshComp, UAnimSeq
 					OutHits,
 					ShapeData,
 					MeshComp->GetWorld(),
-					TracerConfig.DrawDebugType,
-					TracerConfig.DebugDrawTime,
-					TracerConfig.DebugTraceColor,
-					TracerConfig.DebugTraceBlockColor,
-					TracerConfig.DebugTraceHitColor
+					TracerDefinition.DrawDebugType,
+					TracerDefinition.DebugDrawTime,
+					TracerDefinition.DebugTraceColor,
+					TracerDefinition.DebugTraceBlockColor,
+					TracerDefinition.DebugTraceHitColor,
+					MeshComp->GetOwner() == FMissNoHitModule::Get().GetDebugDrawBatcher().GetPriorityActor()
 				);
 			}
 	
-			if (const auto TracerComp = FindMnhTracerComponent(MeshComp))
-			{
-				TracerComp->OnTracerHitDetected(TracerTag, OutHits, FrameDeltaTime / NotifyFrameCount, TickIdx);
-			}
+			TracerComp->OnTracerHitDetected(TracerTag, OutHits, FrameDeltaTime / NotifyFrameCount, TickIdx);
 		}
 	}
 }
@@ -0,0 +1,628 @@
+﻿// Copyright 2024 Eren Balatkan. All Rights Reserved.
+
+#include "MnhCapture.h"
+
+#include "MissNoHit.h"
+#include "MnhTracerComponent.h"
+#include "Async/ParallelFor.h"
+#include "EngineUtils.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Async/MappedFileHandle.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "UObject/UObjectArray.h"
+
+namespace
+{
+	void ToCaptureTransform(const FTransform& Transform, FMnhCaptureTransform& OutTransform)
+	{
+		const FVector Location = Transform.GetLocation();
+		const FQuat Rotation = Transform.GetRotation();
+		const FVector Scale = Transform.GetScale3D();
+		OutTransform = {
+			{float(Location.X), float(Location.Y), float(Location.Z)},
+			{float(Rotation.X), float(Rotation.Y), float(Rotation.Z), float(Rotation.W)},
+			{float(Scale.X), float(Scale.Y), float(Scale.Z)}};
+	}
+
+	FTransform FromCaptureTransform(const FMnhCaptureTransform& Transform)
+	{
+		return FTransform(
+			FQuat(Transform.Rotation[0], Transform.Rotation[1], Transform.Rotation[2], Transform.Rotation[3]),
+			FVector(Transform.Location[0], Transform.Location[1], Transform.Location[2]),
+			FVector(Transform.Scale[0], Transform.Scale[1], Transform.Scale[2]));
+	}
+
+	uint32 GetActorNameHash(const FHitResult& HitResult)
+	{
+		const AActor* Actor = HitResult.GetActor();
+		return Actor ? FCrc::StrCrc32(*Actor->GetName()) : 0;
+	}
+
+	uint64 GetHitKey(const uint32 SubstepIdx, const uint32 ActorNameHash)
+	{
+		return uint64(SubstepIdx) << 32 | ActorNameHash;
+	}
+
+	FMnhCaptureTracerRecord MakeTracerRecord(const uint32 TracerKey, const FMnhTracerData& TracerData)
+	{
+		const auto& Definition = *TracerData.Definition;
+		const auto& TraceSettings = Definition.TraceSettings;
+		const auto& ShapeData = TracerData.ShapeData;
+
+		FMnhCaptureTracerRecord Tracer;
+		Tracer.TracerKey = TracerKey;
+		Tracer.TracerTickType = uint8(TracerData.TracerTickType);
+		Tracer.TraceShape = uint8(ShapeData.TraceShape);
+		Tracer.TraceType = uint8(TraceSettings.TraceType);
+		Tracer.bTraceComplex = TraceSettings.bTraceComplex;
+		Tracer.TraceChannel = TraceSettings.TraceChannel;
+		Tracer.HitSelectionRule = uint8(Definition.HitSelection.SelectionRule);
+		for (const auto ObjectType : TraceSettings.ObjectTypes)
+		{
+			Tracer.ObjectTypesMask |= 1u << ObjectType;
+		}
+		Tracer.TickInterval = TracerData.TickInterval;
+		Tracer.ShapeOffset[0] = ShapeData.Offset.X;
+		Tracer.ShapeOffset[1] = ShapeData.Offset.Y;
+		Tracer.ShapeOffset[2] = ShapeData.Offset.Z;
+		Tracer.Radius = ShapeData.Radius;
+		Tracer.HalfHeight = ShapeData.HalfHeight;
+		Tracer.HalfSize[0] = ShapeData.HalfSize.X;
+		Tracer.HalfSize[1] = ShapeData.HalfSize.Y;
+		Tracer.HalfSize[2] = ShapeData.HalfSize.Z;
+		Tracer.Orientation[0] = ShapeData.Orientation.Pitch;
+		Tracer.Orientation[1] = ShapeData.Orientation.Yaw;
+		Tracer.Orientation[2] = ShapeData.Orientation.Roll;
+		return Tracer;
+	}
+
+	const AActor* GetTracerOwner(const FMnhTracerData& TracerData)
+	{
+		return TracerData.OwnerTracerComponent ? TracerData.OwnerTracerComponent->GetOwner() : nullptr;
+	}
+
+	// Records are copied out instead of cast in place, mapped memory is not guaranteed to be aligned for them
+	struct FMnhCaptureReader
+	{
+		TConstArrayView<uint8> Data;
+		int64 Offset = 0;
+
+		template <typename RecordType>
+		bool Read(RecordType& OutRecord)
+		{
+			if (Offset + int64(sizeof(RecordType)) > Data.Num())
+			{
+				return false;
+			}
+			FMemory::Memcpy(&OutRecord, Data.GetData() + Offset, sizeof(RecordType));
+			Offset += sizeof(RecordType);
+			return true;
+		}
+
+		bool ReadString(FString& OutString)
+		{
+			uint32 Length;
+			if (!Read(Length) || Offset + Length > Data.Num())
+			{
+				return false;
+			}
+			OutString = FString(FUTF8ToTCHAR(reinterpret_cast<const ANSICHAR*>(Data.GetData() + Offset), Length));
+			Offset += Align(Length, 4);
+			return true;
+		}
+	};
+}
+
+FMnhCaptureRecorder::~FMnhCaptureRecorder()
+{
+	Close();
+}
+
+bool FMnhCaptureRecorder::Open(const FString& FilePath)
+{
+	Close();
+	IFileManager::Get().MakeDirectory(*FPaths::GetPath(FilePath), true);
+	File.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*FilePath));
+	if (!File)
+	{
+		FMnhHelpers::Mnh_Log(FString::Printf(TEXT("MissNoHit Warning: Could not open capture file [%s]"), *FilePath));
+		return false;
+	}
+
+	Write(FMnhCaptureFileHeader());
+	Flush();
+	return true;
+}
+
+void FMnhCaptureRecorder::Close()
+{
+	if (File)
+	{
+		Flush();
+		File.Reset();
+	}
+	RecordedTracers.Reset();
+}
+
+void FMnhCaptureRecorder::RecordFrame(const uint32 TickIdx, const float DeltaTime, const TConstArrayView<FMnhTracerData> TracerDatas)
+{
+	LLM_SCOPE_BYTAG(MissNoHit_Debug);
+	if (!File)
+	{
+		return;
+	}
+
+	// Tracers are described before the first frame referencing them, and again before the first frame after a change
+	uint32 NumTracers = 0;
+	for (const auto& TracerData : TracerDatas)
+	{
+		if (TracerData.TracerState == EMnhTracerState::Stopped && !TracerData.bShouldTickThisFrame)
+		{
+			continue;
+		}
+		NumTracers++;
+
+		FRecordedTracer* RecordedTracer = RecordedTracers.Find(TracerData.Guid);
+		const bool bIsNewTracer = RecordedTracer == nullptr;
+		if (bIsNewTracer)
+		{
+			const uint32 TracerKey = RecordedTracers.Num();
+			RecordedTracer = &RecordedTracers.Add(TracerData.Guid);
+			RecordedTracer->TracerKey = TracerKey;
+		}
+
+		const FMnhCaptureTracerRecord Record = MakeTracerRecord(RecordedTracer->TracerKey, TracerData);
+		const FName ProfileName = TracerData.Definition->TraceSettings.ProfileName;
+		const FMnhIgnoreSet* IgnoreSet = TracerData.IgnoreSet.Get();
+		const uint32 IgnoreSetRevision = IgnoreSet ? IgnoreSet->GetRevision() : 0;
+		if (bIsNewTracer
+			|| FMemory::Memcmp(&Record, &RecordedTracer->Record, sizeof(Record)) != 0
+			|| RecordedTracer->Definition != TracerData.Definition
+			|| RecordedTracer->ProfileName != ProfileName
+			|| RecordedTracer->IgnoreSet != IgnoreSet
+			|| RecordedTracer->IgnoreSetRevision != IgnoreSetRevision)
+		{
+			RecordedTracer->Record = Record;
+			RecordedTracer->Definition = TracerData.Definition;
+			RecordedTracer->ProfileName = ProfileName;
+			RecordedTracer->IgnoreSet = IgnoreSet;
+			RecordedTracer->IgnoreSetRevision = IgnoreSetRevision;
+			WriteTracer(Record, TracerData);
+		}
+	}
+
+	int32 ChunkOffset;
+	WriteChunkHeader(MnhCapture::EChunkType::Frame, ChunkOffset);
+	Write(FMnhCaptureFrameRecord{TickIdx, DeltaTime, NumTracers});
+	for (const auto& TracerData : TracerDatas)
+	{
+		if (TracerData.TracerState == EMnhTracerState::Stopped && !TracerData.bShouldTickThisFrame)
+		{
+			continue;
+		}
+
+		const auto SubstepHits = TracerData.bShouldTickThisFrame ? TracerData.GetSubstepHits() : TConstArrayView<FMnhMultiTraceResultContainer>();
+		FMnhCaptureTracerFrameRecord TracerFrame;
+		TracerFrame.TracerKey = RecordedTracers[TracerData.Guid].TracerKey;
+		TracerFrame.bTicked = TracerData.bShouldTickThisFrame && TracerData.TracerTransformsOverTime.Num() > 1;
+		TracerFrame.TracerState = uint8(TracerData.TracerState);
+		TracerFrame.Substeps = uint8(SubstepHits.Num());
+		for (const auto& SubstepResults : SubstepHits)
+		{
+			TracerFrame.NumHits += SubstepResults.HitResults.Num();
+		}
+		Write(TracerFrame);
+
+		if (TracerFrame.bTicked)
+		{
+			FMnhCaptureTransform Transform;
+			ToCaptureTransform(TracerData.TracerTransformsOverTime[0], Transform);
+			Write(Transform);
+			ToCaptureTransform(TracerData.TracerTransformsOverTime.Last(), Transform);
+			Write(Transform);
+		}
+
+		for (int32 SubstepIdx = 0; SubstepIdx < SubstepHits.Num(); SubstepIdx++)
+		{
+			for (const auto& HitResult : SubstepHits[SubstepIdx].HitResults)
+			{
+				FMnhCaptureHitRecord Hit;
+				Hit.ActorNameHash = GetActorNameHash(HitResult);
+				Hit.SubstepIdx = SubstepIdx;
+				Hit.ImpactPoint[0] = HitResult.ImpactPoint.X;
+				Hit.ImpactPoint[1] = HitResult.ImpactPoint.Y;
+				Hit.ImpactPoint[2] = HitResult.ImpactPoint.Z;
+				Write(Hit);
+			}
+		}
+	}
+	FinishChunk(ChunkOffset);
+
+	if (Buffer.Num() >= 256 * 1024)
+	{
+		Flush();
+	}
+}
+
+void FMnhCaptureRecorder::WriteTracer(const FMnhCaptureTracerRecord& Record, const FMnhTracerData& TracerData)
+{
+	const auto& Definition = *TracerData.Definition;
+	const AActor* Owner = GetTracerOwner(TracerData);
+
+	int32 ChunkOffset;
+	WriteChunkHeader(MnhCapture::EChunkType::Tracer, ChunkOffset);
+	Write(Record);
+	// Transient definitions are rebuilt from the record
+	WriteString(Definition.HasAnyFlags(RF_Transient) ? FString() : Definition.GetPathName());
+	WriteString(Definition.TraceSettings.ProfileName.ToString());
+	WriteString(Owner ? Owner->GetName() : FString());
+
+	// Ignore sets only know unique IDs, which are object array indices and mean nothing in another session
+	TArray<const UObject*, TInlineAllocator<8>> IgnoredActors;
+	if (TracerData.IgnoreSet)
+	{
+		for (const uint32 ActorId : TracerData.IgnoreSet->GetIgnoredActorIds())
+		{
+			const FUObjectItem* ObjectItem = GUObjectArray.IndexToObject(int32(ActorId));
+			const UObject* Actor = ObjectItem ? static_cast<const UObject*>(ObjectItem->Object) : nullptr;
+			if (Actor && Actor != Owner)
+			{
+				IgnoredActors.Add(Actor);
+			}
+		}
+	}
+	Write(uint32(IgnoredActors.Num()));
+	for (const UObject* Actor : IgnoredActors)
+	{
+		WriteString(Actor->GetName());
+	}
+	FinishChunk(ChunkOffset);
+}
+
+void FMnhCaptureRecorder::WriteChunkHeader(const MnhCapture::EChunkType Type, int32& OutChunkOffset)
+{
+	OutChunkOffset = Buffer.Num();
+	Write(FMnhCaptureChunkHeader{Type, 0});
+}
+
+void FMnhCaptureRecorder::FinishChunk(const int32 ChunkOffset)
+{
+	const uint32 Size = Buffer.Num() - ChunkOffset - sizeof(FMnhCaptureChunkHeader);
+	FMemory::Memcpy(Buffer.GetData() + ChunkOffset + offsetof(FMnhCaptureChunkHeader, Size), &Size, sizeof(Size));
+}
+
+void FMnhCaptureRecorder::WriteString(const FString& String)
+{
+	const FTCHARToUTF8 Utf8String(*String);
+	const uint32 Length = Utf8String.Length();
+	Write(Length);
+	Buffer.Append(reinterpret_cast<const uint8*>(Utf8String.Get()), Length);
+	Buffer.AddZeroed(Align(Length, 4) - Length);
+}
+
+void FMnhCaptureRecorder::Flush()
+{
+	if (File && Buffer.Num() > 0)
+	{
+		File->Write(Buffer.GetData(), Buffer.Num());
+		File->Flush();
+	}
+	Buffer.Reset();
+}
+
+FMnhCapturePlayer::~FMnhCapturePlayer()
+{
+	// Region has to be released before the file it maps
+	MappedRegion.Reset();
+	MappedFile.Reset();
+}
+
+bool FMnhCapturePlayer::Open(const FString& FilePath)
+{
+	MappedRegion.Reset();
+	MappedFile.Reset();
+	FileData.Reset();
+
+	MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*FilePath));
+	if (MappedFile)
+	{
+		MappedRegion.Reset(MappedFile->MapRegion());
+	}
+	if (MappedRegion)
+	{
+		Data = TConstArrayView<uint8>(MappedRegion->GetMappedPtr(), MappedRegion->GetMappedSize());
+	}
+	else if (FFileHelper::LoadFileToArray(FileData, *FilePath))
+	{
+		Data = FileData;
+	}
+	else
+	{
+		FMnhHelpers::Mnh_Log(FString::Printf(TEXT("MissNoHit Warning: Could not open capture file [%s]"), *FilePath));
+		return false;
+	}
+
+	FMnhCaptureReader Reader{Data};
+	FMnhCaptureFileHeader Header;
+	if (!Reader.Read(Header) || Header.Magic != MnhCapture::Magic || Header.Version != MnhCapture::Version)
+	{
+		FMnhHelpers::Mnh_Log(FString::Printf(TEXT("MissNoHit Warning: [%s] is not a supported capture file"), *FilePath));
+		Data = {};
+		return false;
+	}
+	return true;
+}
+
+bool FMnhCapturePlayer::Replay(UWorld* World, FMnhCaptureReplayStats& OutStats)
+{
+	OutStats = FMnhCaptureReplayStats();
+	if (Data.Num() == 0 || !World)
+	{
+		return false;
+	}
+
+	Tracers.Reset();
+	TracerIndicesByKey.Reset();
+	Definitions.Reset();
+	ActorsByName.Reset();
+	for (TActorIterator<AActor> It(World); It; ++It)
+	{
+		ActorsByName.Add(It->GetFName(), *It);
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	FMnhCaptureReader Reader{Data, sizeof(FMnhCaptureFileHeader)};
+	FMnhCaptureChunkHeader ChunkHeader;
+	while (Reader.Read(ChunkHeader))
+	{
+		if (Reader.Offset + ChunkHeader.Size > Data.Num())
+		{
+			// Capture was cut short while writing this chunk
+			break;
+		}
+
+		const auto Payload = Data.Slice(Reader.Offset, ChunkHeader.Size);
+		Reader.Offset += ChunkHeader.Size;
+		switch (ChunkHeader.Type)
+		{
+		case MnhCapture::EChunkType::Tracer:
+			if (!ReadTracer(Payload, World))
+			{
+				return false;
+			}
+			break;
+		case MnhCapture::EChunkType::Frame:
+			if (!ReplayFrame(Payload, OutStats))
+			{
+				return false;
+			}
+			break;
+		default:
+			// Chunks added by newer versions are skipped
+			break;
+		}
+	}
+
+	OutStats.NumTracers = Tracers.Num();
+	OutStats.TotalSeconds = FPlatformTime::Seconds() - StartTime;
+	return true;
+}
+
+bool FMnhCapturePlayer::ReadTracer(const TConstArrayView<uint8> Payload, UWorld* World)
+{
+	FMnhCaptureReader Reader{Payload};
+	FMnhCaptureTracerRecord Record;
+	FString DefinitionPath, ProfileName, OwnerName;
+	uint32 NumIgnoredActors;
+	if (!Reader.Read(Record) || !Reader.ReadString(DefinitionPath) || !Reader.ReadString(ProfileName)
+		|| !Reader.ReadString(OwnerName) || !Reader.Read(NumIgnoredActors))
+	{
+		return false;
+	}
+
+	// Tracers always ignore their owner, actors missing from the replay world are left out
+	const auto IgnoreSet = MakeShared<FMnhIgnoreSet>();
+	const auto AddIgnoredActor = [this, &IgnoreSet](const FString& ActorName)
+	{
+		if (AActor* const* Actor = ActorsByName.Find(FName(*ActorName)))
+		{
+			IgnoreSet->AddIgnoredActor(*Actor);
+		}
+	};
+	if (!OwnerName.IsEmpty())
+	{
+		AddIgnoredActor(OwnerName);
+	}
+	for (uint32 Idx = 0; Idx < NumIgnoredActors; Idx++)
+	{
+		FString ActorName;
+		if (!Reader.ReadString(ActorName))
+		{
+			return false;
+		}
+		AddIgnoredActor(ActorName);
+	}
+
+	UMnhTracerDefinition* Definition = nullptr;
+	if (!DefinitionPath.IsEmpty())
+	{
+		Definition = Cast<UMnhTracerDefinition>(FSoftObjectPath(DefinitionPath).TryLoad());
+	}
+	if (!Definition)
+	{
+		Definition = NewObject<UMnhTracerDefinition>(GetTransientPackage(), NAME_None, RF_Transient);
+		auto& TraceSettings = Definition->TraceSettings;
+		TraceSettings.TraceType = EMnhTraceType(Record.TraceType);
+		TraceSettings.TraceChannel = ECollisionChannel(Record.TraceChannel);
+		TraceSettings.ProfileName = FName(ProfileName);
+		TraceSettings.bTraceComplex = Record.bTraceComplex != 0;
+		for (int32 Channel = 0; Channel < 32; Channel++)
+		{
+			if (Record.ObjectTypesMask & (1u << Channel))
+			{
+				TraceSettings.ObjectTypes.Add(ECollisionChannel(Channel));
+			}
+		}
+		Definition->HitSelection.SelectionRule = EMnhHitSelectionRule(Record.HitSelectionRule);
+		Definition->UpdateDerivedData();
+	}
+	Definitions.Emplace(Definition);
+
+	// A tracer recorded again after a change keeps its slot and transforms
+	const int32* ExistingTracerIdx = TracerIndicesByKey.Find(Record.TracerKey);
+	auto& TracerData = ExistingTracerIdx ? Tracers[*ExistingTracerIdx] : Tracers.AddDefaulted_GetRef();
+	TracerData.Definition = Definition;
+	TracerData.TracerTickType = EMnhTracerTickType(Record.TracerTickType);
+	TracerData.TickInterval = Record.TickInterval;
+	TracerData.ShapeData.TraceShape = EMnhTraceShape(Record.TraceShape);
+	TracerData.ShapeData.Offset = FVector(Record.ShapeOffset[0], Record.ShapeOffset[1], Record.ShapeOffset[2]);
+	TracerData.ShapeData.Radius = Record.Radius;
+	TracerData.ShapeData.HalfHeight = Record.HalfHeight;
+	TracerData.ShapeData.HalfSize = FVector(Record.HalfSize[0], Record.HalfSize[1], Record.HalfSize[2]);
+	TracerData.ShapeData.Orientation = FRotator(Record.Orientation[0], Record.Orientation[1], Record.Orientation[2]);
+	TracerData.World = World;
+	TracerData.IgnoreSet = IgnoreSet;
+	TracerData.TracerState = EMnhTracerState::Active;
+	if (!ExistingTracerIdx)
+	{
+		TracerIndicesByKey.Add(Record.TracerKey, Tracers.Num() - 1);
+	}
+	return true;
+}
+
+bool FMnhCapturePlayer::ReplayFrame(const TConstArrayView<uint8> Payload, FMnhCaptureReplayStats& OutStats)
+{
+	struct FTickedTracer
+	{
+		int32 TracerIdx;
+		uint32 Substeps;
+		int32 FirstRecordedHit;
+		int32 NumRecordedHits;
+	};
+	TArray<FTickedTracer, TInlineAllocator<64>> TickedTracers;
+	TArray<FMnhCaptureHitRecord> RecordedHits;
+
+	FMnhCaptureReader Reader{Payload};
+	FMnhCaptureFrameRecord Frame;
+	if (!Reader.Read(Frame))
+	{
+		return false;
+	}
+	for (uint32 Idx = 0; Idx < Frame.NumTracers; Idx++)
+	{
+		FMnhCaptureTracerFrameRecord TracerFrame;
+		if (!Reader.Read(TracerFrame))
+		{
+			return false;
+		}
+		const int32* TracerIdx = TracerIndicesByKey.Find(TracerFrame.TracerKey);
+		if (!TracerIdx)
+		{
+			return false;
+		}
+
+		FTickedTracer TickedTracer{*TracerIdx, TracerFrame.Substeps, RecordedHits.Num(), int32(TracerFrame.NumHits)};
+		if (TracerFrame.bTicked)
+		{
+			FMnhCaptureTransform PreviousTransform, CurrentTransform;
+			if (!Reader.Read(PreviousTransform) || !Reader.Read(CurrentTransform))
+			{
+				return false;
+			}
+			auto& TracerData = Tracers[*TracerIdx];
+			TracerData.TracerTransformsOverTime.Reset();
+			TracerData.TracerTransformsOverTime.Add(FromCaptureTransform(PreviousTransform));
+			TracerData.TracerTransformsOverTime.Add(FromCaptureTransform(CurrentTransform));
+		}
+		for (uint32 HitIdx = 0; HitIdx < TracerFrame.NumHits; HitIdx++)
+		{
+			if (!Reader.Read(RecordedHits.AddDefaulted_GetRef()))
+			{
+				return false;
+			}
+		}
+		if (TracerFrame.bTicked && TracerFrame.Substeps > 0)
+		{
+			TickedTracers.Add(TickedTracer);
+		}
+	}
+
+	// Recorded substep counts are used as is, so results only differ where sweeps differ
+	const double TraceStartTime = FPlatformTime::Seconds();
+	ParallelFor(TickedTracers.Num(), [&](const int32 Idx)
+	{
+		Tracers[TickedTracers[Idx].TracerIdx].DoTrace(TickedTracers[Idx].Substeps, Frame.TickIdx);
+	});
+	OutStats.TraceSeconds += FPlatformTime::Seconds() - TraceStartTime;
+
+	TMap<uint64, int32> RecordedHitCounts;
+	for (const auto& TickedTracer : TickedTracers)
+	{
+		RecordedHitCounts.Reset();
+		for (const auto& Hit : MakeArrayView(RecordedHits.GetData() + TickedTracer.FirstRecordedHit, TickedTracer.NumRecordedHits))
+		{
+			RecordedHitCounts.FindOrAdd(GetHitKey(Hit.SubstepIdx, Hit.ActorNameHash))++;
+		}
+		OutStats.NumRecordedHits += TickedTracer.NumRecordedHits;
+
+		const auto SubstepHits = Tracers[TickedTracer.TracerIdx].GetSubstepHits();
+		OutStats.NumSweeps += SubstepHits.Num();
+		for (int32 SubstepIdx = 0; SubstepIdx < SubstepHits.Num(); SubstepIdx++)
+		{
+			for (const auto& HitResult : SubstepHits[SubstepIdx].HitResults)
+			{
+				OutStats.NumReplayedHits++;
+				int32* RecordedHitCount = RecordedHitCounts.Find(GetHitKey(SubstepIdx, GetActorNameHash(HitResult)));
+				if (RecordedHitCount && *RecordedHitCount > 0)
+				{
+					(*RecordedHitCount)--;
+					OutStats.NumMatchedHits++;
+				}
+			}
+		}
+	}
+
+	OutStats.NumFrames++;
+	return true;
+}
+
+static FAutoConsoleCommand MnhCaptureStartCommand(
+	TEXT("MissNoHit.Capture.Start"),
+	TEXT("Starts capturing tracer transforms and hits. Usage: MissNoHit.Capture.Start [FilePath]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const FString FilePath = Args.Num() > 0 ? Args[0]
+			: FPaths::ProfilingDir() / TEXT("MissNoHit") / FString::Printf(TEXT("Capture_%s.mnhcap"), *FDateTime::Now().ToString());
+		if (FMissNoHitModule::Get().StartCapture(FilePath))
+		{
+			UE_LOG(LogMnh, Log, TEXT("MissNoHit capture started: %s"), *FilePath);
+		}
+	}));
+
+static FAutoConsoleCommand MnhCaptureStopCommand(
+	TEXT("MissNoHit.Capture.Stop"),
+	TEXT("Stops the running MissNoHit capture"),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		FMissNoHitModule::Get().StopCapture();
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs MnhCaptureReplayCommand(
+	TEXT("MissNoHit.Capture.Replay"),
+	TEXT("Replays the sweeps of a capture against the current world. Usage: MissNoHit.Capture.Replay FilePath"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		FMnhCapturePlayer Player;
+		FMnhCaptureReplayStats Stats;
+		if (Args.Num() == 0 || !Player.Open(Args[0]) || !Player.Replay(World, Stats))
+		{
+			UE_LOG(LogMnh, Warning, TEXT("MissNoHit capture replay failed"));
+			return;
+		}
+		UE_LOG(LogMnh, Log, TEXT("MissNoHit capture replay: %d frames, %d tracers, %lld sweeps in %.3f ms (%.3f ms total), ")
+			TEXT("hits recorded %lld, replayed %lld, matched %lld"),
+			Stats.NumFrames, Stats.NumTracers, Stats.NumSweeps, Stats.TraceSeconds * 1000.0, Stats.TotalSeconds * 1000.0,
+			Stats.NumRecordedHits, Stats.NumReplayedHits, Stats.NumMatchedHits);
+	}));
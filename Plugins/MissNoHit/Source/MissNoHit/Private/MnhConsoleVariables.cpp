@@ -0,0 +1,100 @@
+﻿// Copyright 2024 Eren Balatkan. All Rights Reserved.
+
+#include "MnhConsoleVariables.h"
+
+#include "HAL/IConsoleManager.h"
+
+int32 FMnhConsoleVariables::MaxSubsteps = FMnhCoreScheduling::DefaultMaxSubsteps;
+int32 FMnhConsoleVariables::InitialTracerPoolSize = 4096;
+int32 FMnhConsoleVariables::HitCacheCap = 2048;
+int32 FMnhConsoleVariables::ParallelBatchSize = 1;
+int32 FMnhConsoleVariables::ParallelSerialThreshold = 0;
+bool FMnhConsoleVariables::bDebugDraw = true;
+int32 FMnhConsoleVariables::TickTypeOverride = -1;
+int32 FMnhConsoleVariables::TickTypeOverrideTargetFps = 30;
+int32 FMnhConsoleVariables::TickTypeOverrideTickDistance = 30;
+float FMnhConsoleVariables::TraceRateScale = 1;
+
+static FAutoConsoleVariableRef CVarMnhMaxSubsteps(
+	TEXT("MissNoHit.MaxSubsteps"),
+	FMnhConsoleVariables::MaxSubsteps,
+	TEXT("Maximum number of sweeps a tracer splits one tick into"));
+
+static FAutoConsoleVariableRef CVarMnhInitialTracerPoolSize(
+	TEXT("MissNoHit.InitialTracerPoolSize"),
+	FMnhConsoleVariables::InitialTracerPoolSize,
+	TEXT("Tracer data slots reserved when the module starts. Not a limit, the pool grows when more tracers are registered"
+		" and a warning is logged once"));
+
+static FAutoConsoleVariableRef CVarMnhHitCacheCap(
+	TEXT("MissNoHit.HitCacheCap"),
+	FMnhConsoleVariables::HitCacheCap,
+	TEXT("Number of hit cache records a Tracer Component keeps before the cache is reset"));
+
+static FAutoConsoleVariableRef CVarMnhParallelBatchSize(
+	TEXT("MissNoHit.ParallelBatchSize"),
+	FMnhConsoleVariables::ParallelBatchSize,
+	TEXT("Minimum number of tracers processed by one worker task when updating and sweeping tracers"));
+
+static FAutoConsoleVariableRef CVarMnhParallelSerialThreshold(
+	TEXT("MissNoHit.ParallelSerialThreshold"),
+	FMnhConsoleVariables::ParallelSerialThreshold,
+	TEXT("Tracers are updated and swept on the game thread while fewer than this many are active, 0 always uses workers"));
+
+static FAutoConsoleVariableRef CVarMnhDebugDraw(
+	TEXT("MissNoHit.DebugDraw"),
+	FMnhConsoleVariables::bDebugDraw,
+	TEXT("Set to 0 to skip tracer debug drawing regardless of the Draw Debug Type of each tracer"));
+
+static FAutoConsoleVariableRef CVarMnhTickTypeOverride(
+	TEXT("MissNoHit.TickTypeOverride"),
+	FMnhConsoleVariables::TickTypeOverride,
+	TEXT("Tick type used by every tracer, -1: Per tracer, 0: Match Game Tick, 1: Fixed Rate Tick, 2: Tick by Distance Traveled,"
+		" 3: Tick on Animation Finalized"));
+
+static FAutoConsoleVariableRef CVarMnhTickTypeOverrideTargetFps(
+	TEXT("MissNoHit.TickTypeOverride.TargetFps"),
+	FMnhConsoleVariables::TickTypeOverrideTargetFps,
+	TEXT("Target fps of tracers when MissNoHit.TickTypeOverride is 1"));
+
+static FAutoConsoleVariableRef CVarMnhTickTypeOverrideTickDistance(
+	TEXT("MissNoHit.TickTypeOverride.TickDistance"),
+	FMnhConsoleVariables::TickTypeOverrideTickDistance,
+	TEXT("Distance traveled between ticks of tracers when MissNoHit.TickTypeOverride is 2"));
+
+static FAutoConsoleVariableRef CVarMnhTraceRateScale(
+	TEXT("MissNoHit.TraceRateScale"),
+	FMnhConsoleVariables::TraceRateScale,
+	TEXT("Multiplies the tick rate of Fixed Rate and Distance Traveled tracers, 0.5 sweeps half as often"));
+
+void FMnhConsoleVariables::GetTickSchedule(const EMnhTracerTickType TracerTickType, const float TickInterval,
+	EMnhCoreTickType& OutTickType, float& OutTickInterval)
+{
+	OutTickType = EMnhCoreTickType(TracerTickType);
+	OutTickInterval = TickInterval;
+	switch (TickTypeOverride)
+	{
+	case int32(EMnhTracerTickType::MatchGameTick):
+		OutTickType = EMnhCoreTickType::MatchGameTick;
+		break;
+	case int32(EMnhTracerTickType::FixedRateTick):
+		OutTickType = EMnhCoreTickType::FixedRateTick;
+		OutTickInterval = 1.f / FMath::Max(TickTypeOverrideTargetFps, 1);
+		break;
+	case int32(EMnhTracerTickType::DistanceTick):
+		OutTickType = EMnhCoreTickType::DistanceTick;
+		OutTickInterval = FMath::Max(TickTypeOverrideTickDistance, 1);
+		break;
+	case int32(EMnhTracerTickType::AnimationFinalized):
+		OutTickType = EMnhCoreTickType::AnimationFinalized;
+		break;
+	default:
+		break;
+	}
+	OutTickInterval = FMnhCoreScheduling::GetScaledTickInterval(OutTickType, OutTickInterval, TraceRateScale);
+}
+
+EParallelForFlags FMnhConsoleVariables::GetParallelForFlags(const int32 Num)
+{
+	return Num < ParallelSerialThreshold ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None;
+}
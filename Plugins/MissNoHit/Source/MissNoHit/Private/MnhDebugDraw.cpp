@@ -0,0 +1,366 @@
+﻿// Copyright 2024 Eren Balatkan. All Rights Reserved.
+
+#include "MnhDebugDraw.h"
+
+#include "MnhConsoleVariables.h"
+#include "MnhTracer.h"
+#include "MnhTracerComponent.h"
+#include "Engine/World.h"
+#include "VisualLogger/VisualLogger.h"
+
+static int32 GMnhDebugDrawMaxPrimitives = 4096;
+static FAutoConsoleVariableRef CVarMnhDebugDrawMaxPrimitives(
+	TEXT("MissNoHit.DebugDraw.MaxPrimitives"),
+	GMnhDebugDrawMaxPrimitives,
+	TEXT("Maximum number of tracer debug shapes drawn per frame, shapes of the priority actor are drawn first"));
+
+namespace
+{
+	constexpr int32 CircleSegments = 16;
+	// Hit points are drawn as three axis crosses so they go through the same DrawLines call as the sweeps
+	constexpr double PointCrossHalfSize = 5;
+
+	// Whole budget up front so the first frame after enabling debug draw is not dropped, nothing where shapes are never drawn
+	int32 GetQueueCapacity()
+	{
+		return ENABLE_DRAW_DEBUG && !IsRunningDedicatedServer() ? FMath::Max(GMnhDebugDrawMaxPrimitives, 0) : 0;
+	}
+
+	ULineBatchComponent* GetLineBatcher(const UWorld* World, const bool bPersistent, const float LifeTime)
+	{
+		return bPersistent || LifeTime > 0 ? World->PersistentLineBatcher : World->LineBatcher;
+	}
+
+	float GetLineLifeTime(const ULineBatchComponent* LineBatcher, const float LifeTime, const bool bPersistent)
+	{
+		return bPersistent ? -1.f : LifeTime > 0 ? LifeTime : LineBatcher->DefaultLifeTime;
+	}
+
+	// Same wireframe as DrawDebugCapsule, two rings joined by half circles and four lines
+	void AppendCapsuleLines(TArray<FBatchedLine>& Lines, const FVector& Center, const float HalfHeight, const float Radius, const FQuat& Rotation,
+		const FColor& Color, const float LifeTime)
+	{
+		const FVector AxisX = Rotation.GetAxisX();
+		const FVector AxisY = Rotation.GetAxisY();
+		const FVector AxisZ = Rotation.GetAxisZ();
+		const double HalfAxis = FMath::Max<double>(HalfHeight - Radius, 1);
+		const FVector TopEnd = Center + HalfAxis * AxisZ;
+		const FVector BottomEnd = Center - HalfAxis * AxisZ;
+
+		const auto AppendArc = [&](const FVector& Base, const FVector& X, const FVector& Y, const int32 NumSegments, const double ArcAngle)
+		{
+			const double AngleStep = ArcAngle / NumSegments;
+			FVector Previous = Base + Radius * X;
+			for (int32 SegmentIdx = 1; SegmentIdx <= NumSegments; SegmentIdx++)
+			{
+				double Sin, Cos;
+				FMath::SinCos(&Sin, &Cos, AngleStep * SegmentIdx);
+				const FVector Next = Base + Radius * (Cos * X + Sin * Y);
+				Lines.Emplace(Previous, Next, Color, LifeTime, 0.f, SDPG_World);
+				Previous = Next;
+			}
+		};
+
+		AppendArc(TopEnd, AxisX, AxisY, CircleSegments, UE_DOUBLE_TWO_PI);
+		AppendArc(BottomEnd, AxisX, AxisY, CircleSegments, UE_DOUBLE_TWO_PI);
+		AppendArc(TopEnd, AxisY, AxisZ, CircleSegments / 2, UE_DOUBLE_PI);
+		AppendArc(TopEnd, AxisX, AxisZ, CircleSegments / 2, UE_DOUBLE_PI);
+		AppendArc(BottomEnd, AxisY, -AxisZ, CircleSegments / 2, UE_DOUBLE_PI);
+		AppendArc(BottomEnd, AxisX, -AxisZ, CircleSegments / 2, UE_DOUBLE_PI);
+
+		Lines.Emplace(TopEnd + Radius * AxisX, BottomEnd + Radius * AxisX, Color, LifeTime, 0.f, SDPG_World);
+		Lines.Emplace(TopEnd - Radius * AxisX, BottomEnd - Radius * AxisX, Color, LifeTime, 0.f, SDPG_World);
+		Lines.Emplace(TopEnd + Radius * AxisY, BottomEnd + Radius * AxisY, Color, LifeTime, 0.f, SDPG_World);
+		Lines.Emplace(TopEnd - Radius * AxisY, BottomEnd - Radius * AxisY, Color, LifeTime, 0.f, SDPG_World);
+	}
+
+	void GetBoxVertices(const FVector& Center, const FQuat& Rotation, const FVector& HalfSize, FVector (&OutVertices)[8])
+	{
+		for (int32 VertexIdx = 0; VertexIdx < 8; VertexIdx++)
+		{
+			const FVector Corner((VertexIdx & 4) ? HalfSize.X : -HalfSize.X, (VertexIdx & 1) ? HalfSize.Y : -HalfSize.Y,
+				(VertexIdx & 2) ? HalfSize.Z : -HalfSize.Z);
+			OutVertices[VertexIdx] = Center + Rotation.RotateVector(Corner);
+		}
+	}
+
+	void AppendBoxLines(TArray<FBatchedLine>& Lines, const FVector (&Vertices)[8], const FColor& Color, const float LifeTime)
+	{
+		// Vertices differing in exactly one bit of their index share an edge
+		for (int32 VertexIdx = 0; VertexIdx < 8; VertexIdx++)
+		{
+			for (const int32 AxisBit : {1, 2, 4})
+			{
+				if (!(VertexIdx & AxisBit))
+				{
+					Lines.Emplace(Vertices[VertexIdx], Vertices[VertexIdx | AxisBit], Color, LifeTime, 0.f, SDPG_World);
+				}
+			}
+		}
+	}
+}
+
+void FMnhVisualLogger::LogTracerSweeps(const FMnhTracerData& TracerData)
+{
+#if ENABLE_VISUAL_LOG
+	const AActor* Owner = TracerData.OwnerTracerComponent ? TracerData.OwnerTracerComponent->GetOwner() : nullptr;
+	if (!Owner)
+	{
+		return;
+	}
+
+	const FString TracerTag = TracerData.GetTracerTag().ToString();
+	const auto& ShapeData = TracerData.ShapeData;
+	const auto SubstepHits = TracerData.GetSubstepHits();
+	for (int32 SubstepIdx = 0; SubstepIdx < SubstepHits.Num(); SubstepIdx++)
+	{
+		const auto& SubstepResults = SubstepHits[SubstepIdx];
+		const FColor Color = SubstepResults.HitResults.Num() > 0 ? FColor::Red : FColor::Green;
+		UE_VLOG_SEGMENT(Owner, LogMnh, Log, SubstepResults.StartLocation, SubstepResults.EndLocation, Color,
+			TEXT("%s substep %d/%d, %d hits"), *TracerTag, SubstepIdx + 1, SubstepHits.Num(), SubstepResults.HitResults.Num());
+
+		switch (ShapeData.TraceShape)
+		{
+		case EMnhTraceShape::Sphere:
+			{
+				// Swept sphere as a single capsule, the Visual Logger places capsules by their base
+				const FVector TraceVec = SubstepResults.EndLocation - SubstepResults.StartLocation;
+				const FQuat Rotation = FRotationMatrix::MakeFromZ(TraceVec).ToQuat();
+				const float HalfHeight = TraceVec.Size() * 0.5f + ShapeData.Radius;
+				const FVector Center = SubstepResults.StartLocation + TraceVec * 0.5;
+				UE_VLOG_CAPSULE(Owner, LogMnh, Verbose, Center - Rotation.GetAxisZ() * HalfHeight, HalfHeight, ShapeData.Radius, Rotation, Color, TEXT(""));
+				break;
+			}
+		case EMnhTraceShape::Capsule:
+			{
+				const float HalfHeight = ShapeData.HalfHeight * SubstepResults.Scale.X;
+				UE_VLOG_CAPSULE(Owner, LogMnh, Verbose, SubstepResults.EndLocation - SubstepResults.Rotation.GetAxisZ() * HalfHeight, HalfHeight,
+					ShapeData.Radius, SubstepResults.Rotation, Color, TEXT(""));
+				break;
+			}
+		case EMnhTraceShape::Box:
+			{
+				UE_VLOG_OBOX(Owner, LogMnh, Verbose, FBox(-ShapeData.HalfSize, ShapeData.HalfSize),
+					FQuatRotationTranslationMatrix(SubstepResults.Rotation, SubstepResults.EndLocation), Color, TEXT(""));
+				break;
+			}
+		default:
+			break;
+		}
+
+		for (const auto& HitResult : SubstepResults.HitResults)
+		{
+			const AActor* HitActor = HitResult.GetActor();
+			UE_VLOG_LOCATION(Owner, LogMnh, Log, HitResult.ImpactPoint, 8.f, FColor::Red, TEXT("%s hit %s"), *TracerTag,
+				HitActor ? *HitActor->GetName() : TEXT("None"));
+		}
+	}
+#endif
+}
+
+FMnhDebugDrawBatcher::FMnhDebugDrawBatcher()
+{
+	LLM_SCOPE_BYTAG(MissNoHit_Debug);
+	PriorityPrimitives.Reset(GetQueueCapacity());
+	Primitives.Reset(GetQueueCapacity());
+}
+
+void FMnhDebugDrawBatcher::Submit()
+{
+	SCOPE_CYCLE_COUNTER(STAT_MnhTracerDebugDraw)
+	LLM_SCOPE_BYTAG(MissNoHit_Debug);
+	check(IsInGameThread());
+
+	const int32 NumPriorityRequested = PriorityPrimitives.GetNumRequested();
+	const int32 NumRequested = Primitives.GetNumRequested();
+	const auto PriorityView = PriorityPrimitives.Drain();
+	const auto View = Primitives.Drain();
+
+	const int32 MaxPrimitives = FMath::Max(GMnhDebugDrawMaxPrimitives, 0);
+	const int32 NumPriority = FMath::Min(PriorityView.Num(), MaxPrimitives);
+	const int32 NumOther = FMath::Min(View.Num(), MaxPrimitives - NumPriority);
+	NumDrawnLastFrame = NumPriority + NumOther;
+	NumDroppedLastFrame = NumPriorityRequested + NumRequested - NumDrawnLastFrame;
+	SET_DWORD_STAT(STAT_MnhDebugPrimitivesDrawn, NumDrawnLastFrame);
+	SET_DWORD_STAT(STAT_MnhDebugPrimitivesDropped, NumDroppedLastFrame);
+
+	if (NumDrawnLastFrame > 0)
+	{
+		for (auto& [LineBatcher, Lines] : LinesByBatcher)
+		{
+			Lines.Reset();
+		}
+		for (const auto& Primitive : PriorityView.Left(NumPriority))
+		{
+			AppendLines(Primitive);
+		}
+		for (const auto& Primitive : View.Left(NumOther))
+		{
+			AppendLines(Primitive);
+		}
+
+		for (auto It = LinesByBatcher.CreateIterator(); It; ++It)
+		{
+			// Batchers of unloaded worlds are dropped once they stop receiving lines
+			if (It->Value.Num() == 0)
+			{
+				It.RemoveCurrent();
+				continue;
+			}
+			It->Key->DrawLines(It->Value);
+		}
+	}
+
+	// Drain already emptied the queues, they are only resized when MissNoHit.DebugDraw.MaxPrimitives changed
+	const int32 Capacity = GetQueueCapacity();
+	if (PriorityPrimitives.GetCapacity() != Capacity)
+	{
+		PriorityPrimitives.Reset(Capacity);
+		Primitives.Reset(Capacity);
+	}
+}
+
+void FMnhDebugDrawBatcher::AddSweep(const FVector& Start, const FVector& End, const FVector& Scale, const FQuat& Rotation,
+	const TConstArrayView<FHitResult> Hits, const FMnhShapeData& ShapeData, const UWorld* World, const EDrawDebugTrace::Type DrawDebugType,
+	const float DebugDrawTime, const FColor& DebugTraceColor, const FColor& DebugTraceBlockColor, const FColor& DebugTraceHitColor,
+	const bool bIsPriority)
+{
+	if (!ENABLE_DRAW_DEBUG || !World || DrawDebugType == EDrawDebugTrace::None || World->GetNetMode() == NM_DedicatedServer)
+	{
+		return;
+	}
+
+	if (Hits.Num() > 0)
+	{
+		const FHitResult& FirstHit = Hits[0];
+		AddTrace(Start, FirstHit.Location, Scale, Rotation, DebugTraceColor, ShapeData, World, DrawDebugType, DebugDrawTime, bIsPriority);
+
+		if (Hits.Last().bBlockingHit)
+		{
+			if (Hits.Num() == 1)
+			{
+				AddTrace(FirstHit.Location, End, Scale, Rotation, DebugTraceBlockColor, ShapeData, World, DrawDebugType, DebugDrawTime, bIsPriority);
+			}
+			else
+			{
+				AddTrace(FirstHit.Location, Hits.Last().Location, Scale, Rotation, DebugTraceHitColor, ShapeData, World, DrawDebugType, DebugDrawTime, bIsPriority);
+				AddTrace(Hits.Last().Location, End, Scale, Rotation, DebugTraceBlockColor, ShapeData, World, DrawDebugType, DebugDrawTime, bIsPriority);
+			}
+		}
+		else
+		{
+			AddTrace(FirstHit.Location, End, Scale, Rotation, DebugTraceHitColor, ShapeData, World, DrawDebugType, DebugDrawTime, bIsPriority);
+		}
+	}
+	else
+	{
+		AddTrace(Start, End, Scale, Rotation, DebugTraceColor, ShapeData, World, DrawDebugType, DebugDrawTime, bIsPriority);
+	}
+
+	for (const FHitResult& Hit : Hits)
+	{
+		FMnhDebugPrimitive Point;
+		Point.World = World;
+		Point.Start = Hit.ImpactPoint;
+		Point.Color = Hit.bBlockingHit ? DebugTraceColor : DebugTraceHitColor;
+		Point.LifeTime = DebugDrawTime;
+		Point.bPersistent = DrawDebugType == EDrawDebugTrace::Persistent;
+		Point.bIsPoint = true;
+		AddPrimitive(Point, bIsPriority);
+	}
+}
+
+SIZE_T FMnhDebugDrawBatcher::GetAllocatedSize() const
+{
+	SIZE_T AllocatedSize = PriorityPrimitives.GetAllocatedSize() + Primitives.GetAllocatedSize() + LinesByBatcher.GetAllocatedSize();
+	for (const auto& [LineBatcher, Lines] : LinesByBatcher)
+	{
+		AllocatedSize += Lines.GetAllocatedSize();
+	}
+	return AllocatedSize;
+}
+
+void FMnhDebugDrawBatcher::AddTrace(const FVector& Start, const FVector& End, const FVector& Scale, const FQuat& Rotation, const FColor& Color,
+	const FMnhShapeData& ShapeData, const UWorld* World, const EDrawDebugTrace::Type DrawDebugType, const float DebugDrawTime, const bool bIsPriority)
+{
+	FMnhDebugPrimitive Primitive;
+	Primitive.World = World;
+	Primitive.Start = Start;
+	Primitive.End = End;
+	Primitive.Rotation = Rotation;
+	Primitive.HalfSize = FVector3f(ShapeData.HalfSize);
+	Primitive.Radius = ShapeData.Radius;
+	Primitive.HalfHeight = ShapeData.HalfHeight * Scale.X;
+	Primitive.LifeTime = DebugDrawTime;
+	Primitive.Color = Color;
+	Primitive.TraceShape = ShapeData.TraceShape;
+	Primitive.bPersistent = DrawDebugType == EDrawDebugTrace::Persistent;
+	AddPrimitive(Primitive, bIsPriority);
+}
+
+void FMnhDebugDrawBatcher::AddPrimitive(const FMnhDebugPrimitive& Primitive, const bool bIsPriority)
+{
+	// Primitives past the budget are counted and dropped
+	if (bIsPriority)
+	{
+		PriorityPrimitives.Enqueue(Primitive);
+	}
+	else
+	{
+		Primitives.Enqueue(Primitive);
+	}
+}
+
+void FMnhDebugDrawBatcher::AppendLines(const FMnhDebugPrimitive& Primitive)
+{
+	ULineBatchComponent* LineBatcher = GetLineBatcher(Primitive.World, Primitive.bPersistent, Primitive.LifeTime);
+	if (!LineBatcher)
+	{
+		return;
+	}
+	const float LifeTime = GetLineLifeTime(LineBatcher, Primitive.LifeTime, Primitive.bPersistent);
+	auto& Lines = LinesByBatcher.FindOrAdd(LineBatcher);
+	if (Primitive.bIsPoint)
+	{
+		for (const FVector& Axis : {FVector::XAxisVector, FVector::YAxisVector, FVector::ZAxisVector})
+		{
+			Lines.Emplace(Primitive.Start - Axis * PointCrossHalfSize, Primitive.Start + Axis * PointCrossHalfSize, Primitive.Color,
+				LifeTime, 0.f, SDPG_World);
+		}
+		return;
+	}
+
+	switch (Primitive.TraceShape)
+	{
+	case EMnhTraceShape::Sphere:
+		{
+			const FVector TraceVec = Primitive.End - Primitive.Start;
+			AppendCapsuleLines(Lines, Primitive.Start + TraceVec * 0.5, TraceVec.Size() * 0.5 + Primitive.Radius, Primitive.Radius,
+				FRotationMatrix::MakeFromZ(TraceVec).ToQuat(), Primitive.Color, LifeTime);
+			break;
+		}
+	case EMnhTraceShape::Box:
+		{
+			FVector StartVertices[8];
+			FVector EndVertices[8];
+			GetBoxVertices(Primitive.Start, Primitive.Rotation, FVector(Primitive.HalfSize), StartVertices);
+			GetBoxVertices(Primitive.End, Primitive.Rotation, FVector(Primitive.HalfSize), EndVertices);
+			AppendBoxLines(Lines, StartVertices, Primitive.Color, LifeTime);
+			AppendBoxLines(Lines, EndVertices, Primitive.Color, LifeTime);
+			for (int32 VertexIdx = 0; VertexIdx < 8; VertexIdx++)
+			{
+				Lines.Emplace(StartVertices[VertexIdx], EndVertices[VertexIdx], Primitive.Color, LifeTime, 0.f, SDPG_World);
+			}
+			break;
+		}
+	case EMnhTraceShape::Capsule:
+		{
+			AppendCapsuleLines(Lines, Primitive.Start, Primitive.HalfHeight, Primitive.Radius, Primitive.Rotation, Primitive.Color, LifeTime);
+			AppendCapsuleLines(Lines, Primitive.End, Primitive.HalfHeight, Primitive.Radius, Primitive.Rotation, Primitive.Color, LifeTime);
+			Lines.Emplace(Primitive.Start, Primitive.End, Primitive.Color, LifeTime, 0.f, SDPG_World);
+			break;
+		}
+	default:
+		break;
+	}
+}
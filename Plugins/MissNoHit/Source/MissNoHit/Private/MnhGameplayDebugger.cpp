@@ -0,0 +1,103 @@
+﻿// Copyright 2024 Eren Balatkan. All Rights Reserved.
+
+#include "MnhGameplayDebugger.h"
+
+#if WITH_GAMEPLAY_DEBUGGER
+#include "MissNoHit.h"
+#include "MnhConsoleVariables.h"
+#include "MnhDebugDraw.h"
+#include "MnhTracer.h"
+#include "MnhTracerComponent.h"
+#include "MnhTracerStats.h"
+
+namespace
+{
+	// Most recent records are listed, the count of the rest is summarized
+	constexpr int32 MaxListedHitCacheRecords = 8;
+}
+
+FGameplayDebuggerCategory_MissNoHit::FGameplayDebuggerCategory_MissNoHit()
+{
+	bShowOnlyWithDebugActor = true;
+}
+
+TSharedRef<FGameplayDebuggerCategory> FGameplayDebuggerCategory_MissNoHit::MakeInstance()
+{
+	return MakeShareable(new FGameplayDebuggerCategory_MissNoHit());
+}
+
+void FGameplayDebuggerCategory_MissNoHit::CollectData(APlayerController* OwnerPC, AActor* DebugActor)
+{
+	FMissNoHitModule& MnhModule = FMissNoHitModule::Get();
+	MnhModule.GetDebugDrawBatcher().SetPriorityActor(DebugActor);
+	if (!DebugActor)
+	{
+		return;
+	}
+
+	AddTextLine(FString::Printf(TEXT("{white}Tracers of {yellow}%s"), *DebugActor->GetName()));
+	int32 NumTracers = 0;
+	for (const auto& TracerData : MnhModule.GetActiveTracerDatas())
+	{
+		if (!TracerData.OwnerTracerComponent || TracerData.OwnerTracerComponent->GetOwner() != DebugActor)
+		{
+			continue;
+		}
+		NumTracers++;
+
+		EMnhCoreTickType TickType;
+		float TickInterval;
+		FMnhConsoleVariables::GetTickSchedule(TracerData.TracerTickType, TracerData.TickInterval, TickType, TickInterval);
+		const FString TickSchedule = TickType == EMnhCoreTickType::FixedRateTick ? FString::Printf(TEXT("%s %.0f Hz"),
+				*UEnum::GetDisplayValueAsText(EMnhTracerTickType(TickType)).ToString(), TickInterval > 0 ? 1.f / TickInterval : 0.f)
+			: TickType == EMnhCoreTickType::DistanceTick ? FString::Printf(TEXT("%s %.0f"),
+				*UEnum::GetDisplayValueAsText(EMnhTracerTickType(TickType)).ToString(), TickInterval)
+			: UEnum::GetDisplayValueAsText(EMnhTracerTickType(TickType)).ToString();
+		const bool bIsRunning = TracerData.TracerState != EMnhTracerState::Stopped;
+
+		FString Cost;
+#if MNH_WITH_TRACER_STATS
+		const auto& Counters = TracerData.Counters;
+		const double SweepMicroseconds = Counters.GetSweepMicroseconds();
+		Cost = FString::Printf(TEXT(" {white}sweeps %llu, hits %llu, filtered %llu, %.2f us/sweep"), Counters.NumSweeps, Counters.NumHits,
+			Counters.NumFilteredHits, Counters.NumSweeps > 0 ? SweepMicroseconds / Counters.NumSweeps : 0.0);
+#endif
+		AddTextLine(FString::Printf(TEXT("  {cyan}%s {%s}%s {white}%s, %d substeps%s"), *TracerData.GetTracerTag().ToString(),
+			bIsRunning ? TEXT("green") : TEXT("grey"), *UEnum::GetDisplayValueAsText(TracerData.TracerState).ToString(),
+			*TickSchedule, TracerData.NumSubstepHits, *Cost));
+
+		if (bIsRunning)
+		{
+			for (const auto& SubstepResults : TracerData.GetSubstepHits())
+			{
+				AddShape(FGameplayDebuggerShape::MakeSegment(SubstepResults.StartLocation, SubstepResults.EndLocation, 2.f, FColor::Cyan));
+			}
+		}
+	}
+	if (NumTracers == 0)
+	{
+		AddTextLine(TEXT("  {grey}No registered tracers"));
+	}
+
+	TInlineComponentArray<UMnhTracerComponent*> TracerComponents(DebugActor);
+	for (const UMnhTracerComponent* TracerComponent : TracerComponents)
+	{
+		const auto& HitCache = TracerComponent->HitCache;
+		AddTextLine(FString::Printf(TEXT("{white}Hit cache of {yellow}%s{white}, %s, %d records"), *TracerComponent->GetName(),
+			*UEnum::GetDisplayValueAsText(TracerComponent->FilterType).ToString(), HitCache.Num()));
+		const int32 FirstListedIdx = FMath::Max(HitCache.Num() - MaxListedHitCacheRecords, 0);
+		if (FirstListedIdx > 0)
+		{
+			AddTextLine(FString::Printf(TEXT("  {grey}%d older records"), FirstListedIdx));
+		}
+		for (int32 RecordIdx = FirstListedIdx; RecordIdx < HitCache.Num(); RecordIdx++)
+		{
+			const auto& Record = HitCache[RecordIdx];
+			const AActor* HitActor = Record.HitResult.GetActor();
+			AddTextLine(FString::Printf(TEXT("  {cyan}%s {white}%s at tick %d"), *Record.TracerTag.ToString(),
+				HitActor ? *HitActor->GetName() : TEXT("None"), Record.TickIdx));
+			AddShape(FGameplayDebuggerShape::MakePoint(Record.HitResult.ImpactPoint, 8.f, FColor::Red));
+		}
+	}
+}
+#endif
@@ -2,3 +2,8 @@
 
 #include "MnhHelpers.h"
 
+LLM_DEFINE_TAG(MissNoHit);
+LLM_DEFINE_TAG(MissNoHit_Registry);
+LLM_DEFINE_TAG(MissNoHit_HitBuffers);
+LLM_DEFINE_TAG(MissNoHit_HitCache);
+LLM_DEFINE_TAG(MissNoHit_Debug);
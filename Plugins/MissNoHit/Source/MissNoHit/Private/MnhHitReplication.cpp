@@ -0,0 +1,87 @@
+﻿// Copyright 2024 Eren Balatkan. All Rights Reserved.
+
+#include "MnhHitReplication.h"
+
+#include "MnhTracerComponent.h"
+
+bool FMnhReplicatedHitBatch::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	bOutSuccess = true;
+
+	uint32 NumHits = Hits.Num();
+	Ar.SerializeIntPacked(NumHits);
+	if (Ar.IsLoading())
+	{
+		if (NumHits > MaxHits)
+		{
+			Ar.SetError();
+			bOutSuccess = false;
+			return false;
+		}
+		Hits.SetNum(NumHits);
+	}
+	
+	uint8 IncludesTimestamp = bIncludesTimestamp;
+	Ar.SerializeBits(&IncludesTimestamp, 1);
+	bIncludesTimestamp = IncludesTimestamp != 0;
+	if (bIncludesTimestamp)
+	{
+		Ar << Timestamp;
+		Ar << FrameDeltaTime;
+	}
+
+	for (auto& Hit : Hits)
+	{
+		UObject* HitActor = Hit.HitActor.Get();
+		bOutSuccess &= Map->SerializeObject(Ar, AActor::StaticClass(), HitActor);
+		if (Ar.IsLoading())
+		{
+			Hit.HitActor = Cast<AActor>(HitActor);
+		}
+
+		bool bSuccess = true;
+		Hit.ImpactPoint.NetSerialize(Ar, Map, bSuccess);
+		bOutSuccess &= bSuccess;
+		Hit.ImpactNormal.NetSerialize(Ar, Map, bSuccess);
+		bOutSuccess &= bSuccess;
+
+		Hit.TracerTag.NetSerialize(Ar, Map, bSuccess);
+		bOutSuccess &= bSuccess;
+		Ar << Hit.SweepTime;
+		Ar << Hit.DeltaTime;
+	}
+	return true;
+}
+
+FMnhReplicatedHit FMnhReplicatedHitBatch::Pack(const FMnhHitEvent& HitEvent)
+{
+	const auto& HitResult = HitEvent.GetHitResult();
+	FMnhReplicatedHit Hit;
+	Hit.ImpactPoint = HitResult.ImpactPoint;
+	Hit.ImpactNormal = HitResult.ImpactNormal;
+	Hit.HitActor = HitResult.GetActor();
+	Hit.TracerTag = HitEvent.TracerTag;
+	Hit.SweepTime = uint8(FMath::RoundToInt(FMath::Clamp(HitResult.Time, 0.f, 1.f) * 255.f));
+	Hit.DeltaTime = uint16(FMath::Clamp(FMath::RoundToInt(HitEvent.DeltaTime * 10000.f), 0, MAX_uint16));
+	return Hit;
+}
+
+bool FMnhReplicatedHitBatch::Unpack(const FMnhReplicatedHit& Hit, FHitResult& OutHitResult, float& OutDeltaTime)
+{
+	AActor* HitActor = Hit.HitActor.Get();
+	if (!HitActor)
+	{
+		return false;
+	}
+
+	OutHitResult = FHitResult();
+	OutHitResult.HitObjectHandle = FActorInstanceHandle(HitActor);
+	OutHitResult.Component = Cast<UPrimitiveComponent>(HitActor->GetRootComponent());
+	OutHitResult.Location = Hit.ImpactPoint;
+	OutHitResult.ImpactPoint = Hit.ImpactPoint;
+	OutHitResult.Normal = Hit.ImpactNormal;
+	OutHitResult.ImpactNormal = Hit.ImpactNormal;
+	OutHitResult.Time = Hit.SweepTime / 255.f;
+	OutDeltaTime = Hit.DeltaTime / 10000.f;
+	return true;
+}
@@ -0,0 +1,639 @@
+﻿// Copyright 2024 Eren Balatkan. All Rights Reserved.
+
+#include "MnhLagCompensation.h"
+
+#include "MissNoHit.h"
+#include "MnhTracerComponent.h"
+#include "MnhTracerDefinition.h"
+#include "Components/BoxComponent.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/SphereComponent.h"
+#include "Engine/NetConnection.h"
+
+namespace
+{
+	FMnhRewoundShape MakeTracerShape(const FMnhShapeData& ShapeData, const FTransform& Transform)
+	{
+		FMnhRewoundShape Shape;
+		Shape.Shape = ShapeData.TraceShape;
+		Shape.Center = Transform.GetLocation();
+		Shape.Rotation = Transform.GetRotation();
+		Shape.bIsValid = true;
+		switch (ShapeData.TraceShape)
+		{
+		case EMnhTraceShape::Sphere:
+			Shape.Extent = FVector3f(ShapeData.Radius, 0, 0);
+			break;
+		case EMnhTraceShape::Box:
+			Shape.Extent = FVector3f(ShapeData.HalfSize);
+			break;
+		case EMnhTraceShape::Capsule:
+			// Skeletal mesh socket tracers stretch their capsule through the scale, see FMnhShapeData::GetTracerShape
+			Shape.Extent = FVector3f(ShapeData.Radius, ShapeData.HalfHeight * Transform.GetScale3D().X, 0);
+			break;
+		}
+		return Shape;
+	}
+
+	// Spheres and capsules are every point within Extent.X of this segment
+	void GetCoreSegment(const FMnhRewoundShape& Shape, FVector& OutStart, FVector& OutEnd)
+	{
+		const FVector AxisExtent = Shape.Shape == EMnhTraceShape::Capsule
+			? Shape.Rotation.GetUpVector() * FMath::Max(Shape.Extent.Y - Shape.Extent.X, 0.f)
+			: FVector::ZeroVector;
+		OutStart = Shape.Center - AxisExtent;
+		OutEnd = Shape.Center + AxisExtent;
+	}
+
+	double SegmentBoxDistSquared(const FMnhRewoundShape& Box, const FVector& Start, const FVector& End)
+	{
+		const FVector Extent(Box.Extent);
+		const FVector LocalStart = Box.Rotation.UnrotateVector(Start - Box.Center);
+		const FVector LocalEnd = Box.Rotation.UnrotateVector(End - Box.Center);
+
+		// Alternating projections between two convex sets converge to their closest points, never under-estimating the distance
+		FVector SegmentPoint = FMath::ClosestPointOnSegment(FVector::ZeroVector, LocalStart, LocalEnd);
+		FVector BoxPoint = SegmentPoint.BoundToBox(-Extent, Extent);
+		for (int32 Iteration = 0; Iteration < 16 && BoxPoint != SegmentPoint; Iteration++)
+		{
+			SegmentPoint = FMath::ClosestPointOnSegment(BoxPoint, LocalStart, LocalEnd);
+			BoxPoint = SegmentPoint.BoundToBox(-Extent, Extent);
+		}
+		return FVector::DistSquared(BoxPoint, SegmentPoint);
+	}
+
+	bool BoxesOverlap(const FMnhRewoundShape& A, const FMnhRewoundShape& B, const float Tolerance)
+	{
+		const FVector AxesA[3] = {A.Rotation.GetAxisX(), A.Rotation.GetAxisY(), A.Rotation.GetAxisZ()};
+		const FVector AxesB[3] = {B.Rotation.GetAxisX(), B.Rotation.GetAxisY(), B.Rotation.GetAxisZ()};
+		const FVector Delta = B.Center - A.Center;
+		const auto IsSeparatingAxis = [&](const FVector& Axis)
+		{
+			// Cross products of parallel edges, already covered by the face axes
+			const double AxisSize = Axis.Size();
+			if (AxisSize < UE_KINDA_SMALL_NUMBER)
+			{
+				return false;
+			}
+			double Projection = Tolerance * AxisSize;
+			for (int32 AxisIdx = 0; AxisIdx < 3; AxisIdx++)
+			{
+				Projection += A.Extent[AxisIdx] * FMath::Abs(AxesA[AxisIdx] | Axis) + B.Extent[AxisIdx] * FMath::Abs(AxesB[AxisIdx] | Axis);
+			}
+			return FMath::Abs(Delta | Axis) > Projection;
+		};
+
+		for (int32 AxisIdx = 0; AxisIdx < 3; AxisIdx++)
+		{
+			if (IsSeparatingAxis(AxesA[AxisIdx]) || IsSeparatingAxis(AxesB[AxisIdx]))
+			{
+				return false;
+			}
+		}
+		for (int32 AxisIdxA = 0; AxisIdxA < 3; AxisIdxA++)
+		{
+			for (int32 AxisIdxB = 0; AxisIdxB < 3; AxisIdxB++)
+			{
+				if (IsSeparatingAxis(AxesA[AxisIdxA] ^ AxesB[AxisIdxB]))
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	bool ShapesOverlap(const FMnhRewoundShape& A, const FMnhRewoundShape& B, const float Tolerance)
+	{
+		if (A.Shape == EMnhTraceShape::Box && B.Shape == EMnhTraceShape::Box)
+		{
+			return BoxesOverlap(A, B, Tolerance);
+		}
+		if (A.Shape == EMnhTraceShape::Box || B.Shape == EMnhTraceShape::Box)
+		{
+			const auto& Box = A.Shape == EMnhTraceShape::Box ? A : B;
+			const auto& Round = A.Shape == EMnhTraceShape::Box ? B : A;
+			FVector Start, End;
+			GetCoreSegment(Round, Start, End);
+			return SegmentBoxDistSquared(Box, Start, End) <= FMath::Square(Round.Extent.X + Tolerance);
+		}
+
+		FVector StartA, EndA, StartB, EndB, PointA, PointB;
+		GetCoreSegment(A, StartA, EndA);
+		GetCoreSegment(B, StartB, EndB);
+		FMath::SegmentDistToSegmentSafe(StartA, EndA, StartB, EndB, PointA, PointB);
+		return FVector::DistSquared(PointA, PointB) <= FMath::Square(A.Extent.X + B.Extent.X + Tolerance);
+	}
+}
+
+void FMnhHurtboxFrame::SetNum(const int32 NumHurtboxes)
+{
+	LocationX.SetNumUninitialized(NumHurtboxes);
+	LocationY.SetNumUninitialized(NumHurtboxes);
+	LocationZ.SetNumUninitialized(NumHurtboxes);
+	RotationX.SetNumUninitialized(NumHurtboxes);
+	RotationY.SetNumUninitialized(NumHurtboxes);
+	RotationZ.SetNumUninitialized(NumHurtboxes);
+	RotationW.SetNumUninitialized(NumHurtboxes);
+}
+
+bool UMnhLagCompensationSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	if (!Super::ShouldCreateSubsystem(Outer))
+	{
+		return false;
+	}
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld() && World->GetNetMode() != NM_Client;
+}
+
+void UMnhLagCompensationSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	Frames.SetNum(HistoryFrameCount);
+}
+
+void UMnhLagCompensationSubsystem::Tick(const float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	SampleHurtboxes(GetWorld()->GetTimeSeconds());
+	SampleTracers();
+}
+
+TStatId UMnhLagCompensationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UMnhLagCompensationSubsystem, STATGROUP_MISSNOHIT);
+}
+
+void UMnhLagCompensationSubsystem::RegisterHurtbox(UPrimitiveComponent* Component)
+{
+	if (!Component || HurtboxSlotsByComponent.Contains(Component))
+	{
+		return;
+	}
+	LLM_SCOPE_BYTAG(MissNoHit);
+
+	const int32 SlotIdx = FreeHurtboxSlots.Num() > 0 ? FreeHurtboxSlots.Pop(EAllowShrinking::No) : Hurtboxes.AddDefaulted();
+	auto& Hurtbox = Hurtboxes[SlotIdx];
+	Hurtbox.Component = Component;
+	Hurtbox.ComponentKey = Component;
+	Hurtbox.bIsRegistered = true;
+	GetHurtboxShape(Component, Hurtbox.Shape, Hurtbox.Extent);
+	HurtboxSlotsByComponent.Add(Component, SlotIdx);
+}
+
+void UMnhLagCompensationSubsystem::UnregisterHurtbox(UPrimitiveComponent* Component)
+{
+	int32 SlotIdx;
+	if (HurtboxSlotsByComponent.RemoveAndCopyValue(Component, SlotIdx))
+	{
+		Hurtboxes[SlotIdx] = FMnhHurtbox();
+		FreeHurtboxSlots.Add(SlotIdx);
+	}
+}
+
+void UMnhLagCompensationSubsystem::RegisterTracerComponent(UMnhTracerComponent* TracerComponent)
+{
+	if (!TracerComponent || TracerHistories.Contains(TracerComponent))
+	{
+		return;
+	}
+	LLM_SCOPE_BYTAG(MissNoHit);
+	TracerHistories.Add(TracerComponent).TracerComponent = TracerComponent;
+}
+
+void UMnhLagCompensationSubsystem::UnregisterTracerComponent(UMnhTracerComponent* TracerComponent)
+{
+	TracerHistories.Remove(TracerComponent);
+}
+
+void UMnhLagCompensationSubsystem::GetHurtboxShape(const UPrimitiveComponent* Component, EMnhTraceShape& OutShape, FVector3f& OutExtent)
+{
+	if (const auto Sphere = Cast<USphereComponent>(Component))
+	{
+		OutShape = EMnhTraceShape::Sphere;
+		OutExtent = FVector3f(Sphere->GetScaledSphereRadius(), 0, 0);
+	}
+	else if (const auto Box = Cast<UBoxComponent>(Component))
+	{
+		OutShape = EMnhTraceShape::Box;
+		OutExtent = FVector3f(Box->GetScaledBoxExtent());
+	}
+	else if (const auto Capsule = Cast<UCapsuleComponent>(Component))
+	{
+		OutShape = EMnhTraceShape::Capsule;
+		OutExtent = FVector3f(Capsule->GetScaledCapsuleRadius(), Capsule->GetScaledCapsuleHalfHeight(), 0);
+	}
+	else
+	{
+		// Bounds are not centered on the component, grow the sphere so it still contains them
+		const auto LocalBounds = Component->CalcBounds(FTransform(FQuat::Identity, FVector::ZeroVector, Component->GetComponentScale()));
+		OutShape = EMnhTraceShape::Sphere;
+		OutExtent = FVector3f(LocalBounds.Origin.Size() + LocalBounds.SphereRadius, 0, 0);
+	}
+}
+
+void UMnhLagCompensationSubsystem::SampleHurtboxes(const double Time)
+{
+	SCOPE_CYCLE_COUNTER(STAT_MnhLagCompensationSample);
+	LLM_SCOPE_BYTAG(MissNoHit);
+	NewestFrameIdx = (NewestFrameIdx + 1) % HistoryFrameCount;
+	NumFrames = FMath::Min(NumFrames + 1, HistoryFrameCount);
+
+	auto& Frame = Frames[NewestFrameIdx];
+	Frame.Time = Time;
+	Frame.SetNum(Hurtboxes.Num());
+	for (int32 SlotIdx = 0; SlotIdx < Hurtboxes.Num(); SlotIdx++)
+	{
+		auto& Hurtbox = Hurtboxes[SlotIdx];
+		const UPrimitiveComponent* Component = Hurtbox.Component.Get();
+		if (!Component)
+		{
+			if (Hurtbox.bIsRegistered)
+			{
+				// Destroyed without being unregistered
+				HurtboxSlotsByComponent.Remove(Hurtbox.ComponentKey);
+				Hurtbox = FMnhHurtbox();
+				FreeHurtboxSlots.Add(SlotIdx);
+			}
+			continue;
+		}
+		if (Hurtbox.FirstSampleTime < 0)
+		{
+			Hurtbox.FirstSampleTime = Time;
+		}
+		const auto& Transform = Component->GetComponentTransform();
+		const FVector3f Location(Transform.GetLocation());
+		const FQuat4f Rotation(Transform.GetRotation());
+		Frame.LocationX[SlotIdx] = Location.X;
+		Frame.LocationY[SlotIdx] = Location.Y;
+		Frame.LocationZ[SlotIdx] = Location.Z;
+		Frame.RotationX[SlotIdx] = Rotation.X;
+		Frame.RotationY[SlotIdx] = Rotation.Y;
+		Frame.RotationZ[SlotIdx] = Rotation.Z;
+		Frame.RotationW[SlotIdx] = Rotation.W;
+	}
+}
+
+void UMnhLagCompensationSubsystem::SampleTracers()
+{
+	SCOPE_CYCLE_COUNTER(STAT_MnhLagCompensationSample);
+	LLM_SCOPE_BYTAG(MissNoHit);
+	FMissNoHitModule& MnhModule = FMissNoHitModule::Get();
+	for (auto It = TracerHistories.CreateIterator(); It; ++It)
+	{
+		auto& History = It->Value;
+		UMnhTracerComponent* TracerComponent = History.TracerComponent.Get();
+		if (!TracerComponent)
+		{
+			It.RemoveCurrent();
+			continue;
+		}
+
+		// Samples of a Tracer Config list that changed can not be trusted anymore
+		if (History.NumTracerConfigs != TracerComponent->TracerConfigs.Num())
+		{
+			History.NumTracerConfigs = TracerComponent->TracerConfigs.Num();
+			History.Samples.Reset();
+			History.Samples.SetNum(History.NumTracerConfigs * HistoryFrameCount);
+		}
+
+		for (int32 TracerConfigIdx = 0; TracerConfigIdx < History.NumTracerConfigs; TracerConfigIdx++)
+		{
+			const auto& TracerConfig = TracerComponent->TracerConfigs[TracerConfigIdx];
+			auto& Sample = History.Samples[TracerConfigIdx * HistoryFrameCount + NewestFrameIdx];
+			Sample = FMnhRewoundShape();
+			if (TracerConfig.TracerDataIdx < 0 || TracerConfig.TracerDataIdx >= MnhModule.GetNumActiveTracerDatas())
+			{
+				continue;
+			}
+			
+			// Only swings the server is running itself are trusted
+			auto& TracerData = MnhModule.GetTracerDataAt(TracerConfig.TracerDataIdx);
+			if (TracerData.Guid != TracerConfig.TracerDataGuid || TracerData.TracerState == EMnhTracerState::Stopped
+				|| !TracerData.Definition || !IsValid(TracerData.SourceComponent))
+			{
+				continue;
+			}
+			const FTransform Transform = TracerData.GetCurrentTracerTransform();
+			Sample = MakeTracerShape(TracerData.ShapeData, Transform);
+		}
+	}
+}
+
+bool UMnhLagCompensationSubsystem::FindFramesAround(const double Timestamp, int32& OutOlderIdx, int32& OutNewerIdx, float& OutAlpha) const
+{
+	if (NumFrames == 0)
+	{
+		return false;
+	}
+
+	// Newest frame is used as is when the timestamp is ahead of it
+	OutOlderIdx = INDEX_NONE;
+	OutNewerIdx = NewestFrameIdx;
+	for (int32 Age = 0; Age < NumFrames; Age++)
+	{
+		const int32 FrameIdx = (NewestFrameIdx - Age + HistoryFrameCount) % HistoryFrameCount;
+		if (Frames[FrameIdx].Time <= Timestamp)
+		{
+			OutOlderIdx = FrameIdx;
+			break;
+		}
+		OutNewerIdx = FrameIdx;
+	}
+	if (OutOlderIdx == INDEX_NONE)
+	{
+		return false;
+	}
+
+	const double OlderTime = Frames[OutOlderIdx].Time;
+	const double NewerTime = Frames[OutNewerIdx].Time;
+	OutAlpha = NewerTime > OlderTime ? float((Timestamp - OlderTime) / (NewerTime - OlderTime)) : 0.f;
+	return true;
+}
+
+bool UMnhLagCompensationSubsystem::RewindTo(const double Timestamp)
+{
+	int32 OlderIdx, NewerIdx;
+	float Alpha;
+	if (!FindFramesAround(Timestamp, OlderIdx, NewerIdx, Alpha))
+	{
+		return false;
+	}
+	const FMnhHurtboxFrame* Older = &Frames[OlderIdx];
+	const FMnhHurtboxFrame* Newer = &Frames[NewerIdx];
+
+	const int32 Num = FMath::Min(Older->LocationX.Num(), Newer->LocationX.Num());
+	RewoundFrame.Time = Older->Time;
+	RewoundFrame.SetNum(Num);
+
+	// Plain loops over separate arrays so the compiler can vectorize them
+	for (int32 Idx = 0; Idx < Num; Idx++)
+	{
+		RewoundFrame.LocationX[Idx] = FMath::Lerp(Older->LocationX[Idx], Newer->LocationX[Idx], Alpha);
+		RewoundFrame.LocationY[Idx] = FMath::Lerp(Older->LocationY[Idx], Newer->LocationY[Idx], Alpha);
+		RewoundFrame.LocationZ[Idx] = FMath::Lerp(Older->LocationZ[Idx], Newer->LocationZ[Idx], Alpha);
+	}
+	for (int32 Idx = 0; Idx < Num; Idx++)
+	{
+		// Normalized lerp along the shortest arc, samples are a server tick apart so the error is negligible
+		const float Dot = Older->RotationX[Idx] * Newer->RotationX[Idx] + Older->RotationY[Idx] * Newer->RotationY[Idx]
+			+ Older->RotationZ[Idx] * Newer->RotationZ[Idx] + Older->RotationW[Idx] * Newer->RotationW[Idx];
+		const float NewerWeight = Dot >= 0.f ? Alpha : -Alpha;
+		const float OlderWeight = 1.f - Alpha;
+		const float X = Older->RotationX[Idx] * OlderWeight + Newer->RotationX[Idx] * NewerWeight;
+		const float Y = Older->RotationY[Idx] * OlderWeight + Newer->RotationY[Idx] * NewerWeight;
+		const float Z = Older->RotationZ[Idx] * OlderWeight + Newer->RotationZ[Idx] * NewerWeight;
+		const float W = Older->RotationW[Idx] * OlderWeight + Newer->RotationW[Idx] * NewerWeight;
+		const float InvSize = FMath::InvSqrt(FMath::Max(X * X + Y * Y + Z * Z + W * W, UE_SMALL_NUMBER));
+		RewoundFrame.RotationX[Idx] = X * InvSize;
+		RewoundFrame.RotationY[Idx] = Y * InvSize;
+		RewoundFrame.RotationZ[Idx] = Z * InvSize;
+		RewoundFrame.RotationW[Idx] = W * InvSize;
+	}
+	return true;
+}
+
+bool UMnhLagCompensationSubsystem::RewindSweep(const FVector& Start, const FVector& End, const float SweepRadius,
+	const double Timestamp, TArray<FMnhRewindHit>& OutHits, const AActor* IgnoredActor)
+{
+	SCOPE_CYCLE_COUNTER(STAT_MnhLagCompensationRewind);
+	OutHits.Reset();
+	if (!RewindTo(Timestamp))
+	{
+		return false;
+	}
+
+	const FVector SweepDelta = End - Start;
+	const double SweepLengthSquared = FMath::Max(SweepDelta.SizeSquared(), UE_SMALL_NUMBER);
+	const auto GetSweepTime = [&](const FVector& Point)
+	{
+		return float(FMath::Clamp(FVector::DotProduct(Point - Start, SweepDelta) / SweepLengthSquared, 0.0, 1.0));
+	};
+
+	for (int32 SlotIdx = 0; SlotIdx < RewoundFrame.LocationX.Num(); SlotIdx++)
+	{
+		const auto& Hurtbox = Hurtboxes[SlotIdx];
+		const UPrimitiveComponent* Component = Hurtbox.Component.Get();
+		if (!Component || Hurtbox.FirstSampleTime < 0 || Hurtbox.FirstSampleTime > RewoundFrame.Time
+			|| (IgnoredActor && Component->GetOwner() == IgnoredActor))
+		{
+			continue;
+		}
+
+		const FVector Center(RewoundFrame.LocationX[SlotIdx], RewoundFrame.LocationY[SlotIdx], RewoundFrame.LocationZ[SlotIdx]);
+		const FQuat Rotation(RewoundFrame.RotationX[SlotIdx], RewoundFrame.RotationY[SlotIdx],
+			RewoundFrame.RotationZ[SlotIdx], RewoundFrame.RotationW[SlotIdx]);
+
+		FMnhRewindHit Hit;
+		bool bIsHit = false;
+		switch (Hurtbox.Shape)
+		{
+		case EMnhTraceShape::Sphere:
+			{
+				const FVector SweepPoint = FMath::ClosestPointOnSegment(Center, Start, End);
+				const float Radius = Hurtbox.Extent.X;
+				if (FVector::DistSquared(SweepPoint, Center) <= FMath::Square(Radius + SweepRadius))
+				{
+					bIsHit = true;
+					Hit.ImpactPoint = Center + (SweepPoint - Center).GetSafeNormal() * Radius;
+					Hit.Time = GetSweepTime(SweepPoint);
+				}
+				break;
+			}
+		case EMnhTraceShape::Capsule:
+			{
+				const float Radius = Hurtbox.Extent.X;
+				const FVector AxisExtent = Rotation.GetUpVector() * FMath::Max(Hurtbox.Extent.Y - Radius, 0.f);
+				FVector AxisPoint, SweepPoint;
+				FMath::SegmentDistToSegmentSafe(Center - AxisExtent, Center + AxisExtent, Start, End, AxisPoint, SweepPoint);
+				if (FVector::DistSquared(AxisPoint, SweepPoint) <= FMath::Square(Radius + SweepRadius))
+				{
+					bIsHit = true;
+					Hit.ImpactPoint = AxisPoint + (SweepPoint - AxisPoint).GetSafeNormal() * Radius;
+					Hit.Time = GetSweepTime(SweepPoint);
+				}
+				break;
+			}
+		case EMnhTraceShape::Box:
+			{
+				const FVector Extent(Hurtbox.Extent);
+				const FVector LocalStart = Rotation.UnrotateVector(Start - Center);
+				const FVector LocalEnd = Rotation.UnrotateVector(End - Center);
+				FVector HitLocation, HitNormal;
+				float HitTime;
+				if (FMath::LineExtentBoxIntersection(FBox(-Extent, Extent), LocalStart, LocalEnd, FVector(SweepRadius),
+					HitLocation, HitNormal, HitTime))
+				{
+					bIsHit = true;
+					Hit.ImpactPoint = Center + Rotation.RotateVector(HitLocation.BoundToBox(-Extent, Extent));
+					Hit.Time = HitTime;
+				}
+				break;
+			}
+		}
+
+		if (bIsHit)
+		{
+			Hit.Component = const_cast<UPrimitiveComponent*>(Component);
+			OutHits.Add(Hit);
+		}
+	}
+
+	OutHits.Sort([](const FMnhRewindHit& A, const FMnhRewindHit& B) { return A.Time < B.Time; });
+	return true;
+}
+
+FMnhRewoundShape UMnhLagCompensationSubsystem::RewindHurtbox(const int32 SlotIdx, const double Timestamp) const
+{
+	FMnhRewoundShape Shape;
+	int32 OlderIdx, NewerIdx;
+	float Alpha;
+	const auto& Hurtbox = Hurtboxes[SlotIdx];
+	if (!FindFramesAround(Timestamp, OlderIdx, NewerIdx, Alpha) || Hurtbox.FirstSampleTime < 0
+		|| Hurtbox.FirstSampleTime > Frames[OlderIdx].Time)
+	{
+		return Shape;
+	}
+	const auto& Older = Frames[OlderIdx];
+	const auto& Newer = Frames[NewerIdx];
+	if (SlotIdx >= Older.LocationX.Num() || SlotIdx >= Newer.LocationX.Num())
+	{
+		return Shape;
+	}
+
+	Shape.Shape = Hurtbox.Shape;
+	Shape.Extent = Hurtbox.Extent;
+	Shape.Center = FMath::Lerp(FVector(Older.LocationX[SlotIdx], Older.LocationY[SlotIdx], Older.LocationZ[SlotIdx]),
+		FVector(Newer.LocationX[SlotIdx], Newer.LocationY[SlotIdx], Newer.LocationZ[SlotIdx]), double(Alpha));
+	Shape.Rotation = FQuat::Slerp(FQuat(Older.RotationX[SlotIdx], Older.RotationY[SlotIdx], Older.RotationZ[SlotIdx], Older.RotationW[SlotIdx]),
+		FQuat(Newer.RotationX[SlotIdx], Newer.RotationY[SlotIdx], Newer.RotationZ[SlotIdx], Newer.RotationW[SlotIdx]), Alpha);
+	Shape.bIsValid = true;
+	return Shape;
+}
+
+FMnhRewoundShape UMnhLagCompensationSubsystem::RewindTracer(const FMnhTracerHistory& History, const int32 TracerConfigIdx,
+	const double Timestamp) const
+{
+	int32 OlderIdx, NewerIdx;
+	float Alpha;
+	if (!FindFramesAround(Timestamp, OlderIdx, NewerIdx, Alpha))
+	{
+		return FMnhRewoundShape();
+	}
+	const auto& Older = History.Samples[TracerConfigIdx * HistoryFrameCount + OlderIdx];
+	const auto& Newer = History.Samples[TracerConfigIdx * HistoryFrameCount + NewerIdx];
+	if (!Older.bIsValid || !Newer.bIsValid)
+	{
+		return FMnhRewoundShape();
+	}
+
+	// Shape changes between samples, e.g. a new anim notify, are not blended
+	FMnhRewoundShape Shape = Alpha < 0.5f ? Older : Newer;
+	Shape.Center = FMath::Lerp(Older.Center, Newer.Center, double(Alpha));
+	Shape.Rotation = FQuat::Slerp(Older.Rotation, Newer.Rotation, Alpha);
+	return Shape;
+}
+
+bool UMnhLagCompensationSubsystem::ValidateHit(UMnhTracerComponent* TracerComponent, const FGameplayTag TracerTag,
+	const double Timestamp, const float SweepDuration, AActor* HitActor, const float Tolerance)
+{
+	SCOPE_CYCLE_COUNTER(STAT_MnhLagCompensationRewind);
+	if (!TracerComponent || !HitActor)
+	{
+		return false;
+	}
+
+	const FMnhTracerHistory* History = TracerHistories.Find(TracerComponent);
+	const int TracerConfigIdx = TracerComponent->FindTracerConfig(TracerTag);
+	if (!History || TracerConfigIdx == -1 || TracerConfigIdx >= History->NumTracerConfigs)
+	{
+		const auto Message = FString::Printf(TEXT("MissNoHit Warning: Lag compensated hit validation failed, Tracer with tag [%s] on [%s] is not sampled"),
+			*TracerTag.ToString(), *TracerComponent->GetOwner()->GetName());
+		FMnhHelpers::Mnh_Log(Message);
+		return false;
+	}
+
+	// A client can not have seen the world further in the past than its connection lags behind
+	const double ServerTime = GetWorld()->GetTimeSeconds();
+	const UNetConnection* Connection = TracerComponent->GetOwner()->GetNetConnection();
+	const double MaxRewindTime = (Connection ? double(Connection->AvgLag) : 0.0) + RewindSlackTime;
+	const double EndTime = FMath::Clamp(Timestamp, ServerTime - MaxRewindTime, ServerTime);
+
+	// Fixed rate tracers sweep everything since their last tick, which can be longer than the client's frame
+	float TracerSweepDuration = SweepDuration;
+	const auto& TracerConfig = TracerComponent->TracerConfigs[TracerConfigIdx];
+	if (TracerConfig.ActiveDefinition && TracerConfig.ActiveDefinition->TracerTickType == EMnhTracerTickType::FixedRateTick)
+	{
+		TracerSweepDuration = FMath::Max(TracerSweepDuration, TracerConfig.ActiveDefinition->TickInterval);
+	}
+	const double StartTime = EndTime - FMath::Clamp(TracerSweepDuration, 0.f, MaxSweepDuration);
+
+	TArray<int32, TInlineAllocator<8>> HitActorSlots;
+	for (int32 SlotIdx = 0; SlotIdx < Hurtboxes.Num(); SlotIdx++)
+	{
+		const UPrimitiveComponent* Component = Hurtboxes[SlotIdx].Component.Get();
+		if (Component && Component->GetOwner() == HitActor)
+		{
+			HitActorSlots.Add(SlotIdx);
+		}
+	}
+	if (HitActorSlots.Num() == 0)
+	{
+		return false;
+	}
+
+	// Sweep is split at every server sample within it, then again so no step moves the tracer further than its own size
+	TArray<double, TInlineAllocator<8>> SampleTimes;
+	SampleTimes.Add(StartTime);
+	for (int32 Age = NumFrames - 1; Age >= 0; Age--)
+	{
+		const double FrameTime = Frames[(NewestFrameIdx - Age + HistoryFrameCount) % HistoryFrameCount].Time;
+		if (FrameTime > StartTime && FrameTime < EndTime)
+		{
+			SampleTimes.Add(FrameTime);
+		}
+	}
+	SampleTimes.Add(EndTime);
+
+	bool bWasTracerSampled = false;
+	for (int32 SegmentIdx = 0; SegmentIdx + 1 < SampleTimes.Num(); SegmentIdx++)
+	{
+		const FMnhRewoundShape SegmentStart = RewindTracer(*History, TracerConfigIdx, SampleTimes[SegmentIdx]);
+		const FMnhRewoundShape SegmentEnd = RewindTracer(*History, TracerConfigIdx, SampleTimes[SegmentIdx + 1]);
+		if (!SegmentStart.bIsValid || !SegmentEnd.bIsValid)
+		{
+			continue;
+		}
+		bWasTracerSampled = true;
+
+		const float TracerSize = SegmentEnd.Shape == EMnhTraceShape::Box ? SegmentEnd.Extent.GetMin() : SegmentEnd.Extent.X;
+		const int32 NumSteps = FMath::Clamp(FMath::CeilToInt32(FVector::Dist(SegmentStart.Center, SegmentEnd.Center)
+			/ FMath::Max(TracerSize, 1.f)), 1, 16);
+		for (int32 StepIdx = 0; StepIdx <= NumSteps; StepIdx++)
+		{
+			const double StepTime = FMath::Lerp(SampleTimes[SegmentIdx], SampleTimes[SegmentIdx + 1], double(StepIdx) / NumSteps);
+			const FMnhRewoundShape TracerShape = RewindTracer(*History, TracerConfigIdx, StepTime);
+			if (!TracerShape.bIsValid)
+			{
+				continue;
+			}
+			for (const int32 SlotIdx : HitActorSlots)
+			{
+				const FMnhRewoundShape HurtboxShape = RewindHurtbox(SlotIdx, StepTime);
+				if (HurtboxShape.bIsValid && ShapesOverlap(TracerShape, HurtboxShape, Tolerance))
+				{
+					return true;
+				}
+			}
+		}
+	}
+
+	if (!bWasTracerSampled)
+	{
+		const auto Message = FString::Printf(TEXT("MissNoHit Warning: Lag compensated hit validation failed, Tracer [%s] was not running on the server at [%f]"),
+			*TracerTag.ToString(), EndTime);
+		FMnhHelpers::Mnh_Log(Message, false);
+	}
+	return false;
+}
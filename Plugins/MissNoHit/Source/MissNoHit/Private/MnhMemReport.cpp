@@ -0,0 +1,126 @@
+﻿// Copyright 2024 Eren Balatkan. All Rights Reserved.
+
+#include "MissNoHit.h"
+#include "MnhCapture.h"
+#include "MnhDebugDraw.h"
+#include "MnhTracer.h"
+#include "MnhTracerComponent.h"
+#include "MnhTracerStats.h"
+#include "UObject/UObjectIterator.h"
+
+namespace
+{
+	struct FMnhMemReportRow
+	{
+		int32 NumComponents = 0;
+		int32 NumTracerDatas = 0;
+		FMnhMemoryUsage Usage;
+
+		void Add(const FMnhMemReportRow& Other)
+		{
+			NumComponents += Other.NumComponents;
+			NumTracerDatas += Other.NumTracerDatas;
+			Usage.Add(Other.Usage);
+		}
+	};
+
+	double ToKilobytes(const SIZE_T Bytes)
+	{
+		return Bytes / 1024.0;
+	}
+
+	void DumpRows(FOutputDevice& Ar, const TCHAR* GroupName, TMap<FString, FMnhMemReportRow>& Rows)
+	{
+		Rows.ValueSort([](const FMnhMemReportRow& A, const FMnhMemReportRow& B)
+		{
+			return A.Usage.GetTotal() > B.Usage.GetTotal();
+		});
+
+		Ar.Logf(TEXT("%-48s %10s %10s %12s %12s %12s %12s"), GroupName, TEXT("Components"), TEXT("Tracers"),
+			TEXT("Registry KB"), TEXT("Hits KB"), TEXT("Cache KB"), TEXT("Total KB"));
+		for (const auto& [Name, Row] : Rows)
+		{
+			Ar.Logf(TEXT("%-48s %10d %10d %12.1f %12.1f %12.1f %12.1f"), *Name, Row.NumComponents, Row.NumTracerDatas,
+				ToKilobytes(Row.Usage.Registry), ToKilobytes(Row.Usage.HitBuffers), ToKilobytes(Row.Usage.HitCache),
+				ToKilobytes(Row.Usage.GetTotal()));
+		}
+	}
+}
+
+void FMissNoHitModule::DumpMemReport(FOutputDevice& Ar) const
+{
+	check(IsInGameThread());
+
+	// Hit buffers of active slots are charged to the owning component, pooled slots to the module
+	TMap<const UMnhTracerComponent*, FMnhMemReportRow> TracerDataRows;
+	SIZE_T PooledHitBuffers = 0;
+	for (int32 TracerDataIdx = 0; TracerDataIdx < TracerDatas.Num(); TracerDataIdx++)
+	{
+		const auto& TracerData = TracerDatas[TracerDataIdx];
+		const UMnhTracerComponent* OwnerComponent = TracerData.OwnerTracerComponent
+			? TracerData.OwnerTracerComponent.Get()
+			: TracerData.OwnerTracer ? TracerData.OwnerTracer->OwnerComponent.Get() : nullptr;
+		if (TracerDataIdx >= NumActiveTracerDatas || !OwnerComponent)
+		{
+			PooledHitBuffers += TracerData.GetAllocatedSize();
+			continue;
+		}
+		auto& Row = TracerDataRows.FindOrAdd(OwnerComponent);
+		Row.NumTracerDatas++;
+		Row.Usage.HitBuffers += TracerData.GetAllocatedSize();
+	}
+
+	TMap<FString, FMnhMemReportRow> RowsByClass;
+	TMap<FString, FMnhMemReportRow> RowsByWorld;
+	FMnhMemReportRow ComponentsTotal;
+	for (TObjectIterator<UMnhTracerComponent> It; It; ++It)
+	{
+		const UMnhTracerComponent* TracerComponent = *It;
+		if (TracerComponent->IsTemplate())
+		{
+			continue;
+		}
+
+		FMnhMemReportRow Row;
+		if (const auto TracerDataRow = TracerDataRows.Find(TracerComponent))
+		{
+			Row = *TracerDataRow;
+		}
+		Row.NumComponents = 1;
+		TracerComponent->GetMemoryUsage(Row.Usage);
+
+		const UWorld* World = TracerComponent->GetWorld();
+		RowsByClass.FindOrAdd(TracerComponent->GetClass()->GetName()).Add(Row);
+		RowsByWorld.FindOrAdd(World ? World->GetName() : TEXT("None")).Add(Row);
+		ComponentsTotal.Add(Row);
+	}
+
+	const SIZE_T StatsSize = FMnhTracerStats::Get().GetAllocatedSize();
+	const SIZE_T CaptureSize = CaptureRecorder.IsValid() ? CaptureRecorder->GetAllocatedSize() : 0;
+	const SIZE_T PoolSize = TracerDatas.GetAllocatedSize();
+	FMnhMemoryUsage ModuleUsage;
+	ModuleUsage.Registry = PoolSize;
+	ModuleUsage.HitBuffers = PooledHitBuffers;
+	ModuleUsage.Debug = StatsSize + CaptureSize + DebugDrawBatcher->GetAllocatedSize();
+
+	Ar.Logf(TEXT("MissNoHit memory report, live LLM numbers are under the MissNoHit tags of stat LLMFULL"));
+	Ar.Logf(TEXT("Tracer data pool: %d slots, %d active, %.1f KB slots, %.1f KB pooled hit buffers"),
+		TracerDatas.Num(), NumActiveTracerDatas, ToKilobytes(PoolSize), ToKilobytes(PooledHitBuffers));
+	Ar.Logf(TEXT("Debug: %.1f KB tracer stats, %.1f KB capture, %.1f KB debug draw"), ToKilobytes(StatsSize), ToKilobytes(CaptureSize),
+		ToKilobytes(DebugDrawBatcher->GetAllocatedSize()));
+	Ar.Logf(TEXT(""));
+	DumpRows(Ar, TEXT("Component Class"), RowsByClass);
+	Ar.Logf(TEXT(""));
+	DumpRows(Ar, TEXT("World"), RowsByWorld);
+	Ar.Logf(TEXT(""));
+	Ar.Logf(TEXT("Total: %.1f KB in %d components, %.1f KB module"), ToKilobytes(ComponentsTotal.Usage.GetTotal()),
+		ComponentsTotal.NumComponents, ToKilobytes(ModuleUsage.GetTotal()));
+}
+
+static FAutoConsoleCommandWithOutputDevice MnhMemReportCommand(
+	TEXT("MissNoHit.MemReport"),
+	TEXT("Prints MissNoHit memory per tracer component class and per world, split into registry, hit buffers and hit cache"),
+	FConsoleCommandWithOutputDeviceDelegate::CreateLambda([](FOutputDevice& Ar)
+	{
+		FMissNoHitModule::Get().DumpMemReport(Ar);
+	}));
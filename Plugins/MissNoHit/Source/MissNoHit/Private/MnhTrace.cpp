@@ -0,0 +1,136 @@
+﻿// Copyright 2024 Eren Balatkan. All Rights Reserved.
+
+#include "MnhTrace.h"
+
+#if MNH_TRACE_ENABLED
+
+#include "MnhTracer.h"
+#include "MnhTracerComponent.h"
+#include "ObjectTrace.h"
+
+UE_TRACE_CHANNEL_DEFINE(MissNoHitChannel)
+
+UE_TRACE_EVENT_BEGIN(MissNoHit, TracerStarted)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint64, TracerId)
+	UE_TRACE_EVENT_FIELD(uint64, OwnerId)
+	UE_TRACE_EVENT_FIELD(uint8, TraceSource)
+	UE_TRACE_EVENT_FIELD(uint8, TracerTickType)
+	UE_TRACE_EVENT_FIELD(uint8, TraceShape)
+	UE_TRACE_EVENT_FIELD(UE::Trace::WideString, TracerTag)
+	UE_TRACE_EVENT_FIELD(UE::Trace::WideString, OwnerName)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(MissNoHit, TracerStopped)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint64, TracerId)
+	UE_TRACE_EVENT_FIELD(bool, bStopImmediate)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(MissNoHit, TickDecision)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint64, TracerId)
+	UE_TRACE_EVENT_FIELD(bool, bTicked)
+	UE_TRACE_EVENT_FIELD(uint8, Reason)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(MissNoHit, Sweep)
+	UE_TRACE_EVENT_FIELD(uint64, StartCycle)
+	UE_TRACE_EVENT_FIELD(uint64, EndCycle)
+	UE_TRACE_EVENT_FIELD(uint64, TracerId)
+	UE_TRACE_EVENT_FIELD(uint32, ThreadId)
+	UE_TRACE_EVENT_FIELD(uint8, SubstepIdx)
+	UE_TRACE_EVENT_FIELD(uint8, TraceShape)
+	UE_TRACE_EVENT_FIELD(float, SweepLength)
+	UE_TRACE_EVENT_FIELD(uint16, NumHits)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(MissNoHit, HitDispatched)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint64, TracerId)
+	UE_TRACE_EVENT_FIELD(uint64, HitActorId)
+	UE_TRACE_EVENT_FIELD(uint8, SubstepIdx)
+	UE_TRACE_EVENT_FIELD(float, ImpactPointX)
+	UE_TRACE_EVENT_FIELD(float, ImpactPointY)
+	UE_TRACE_EVENT_FIELD(float, ImpactPointZ)
+UE_TRACE_EVENT_END()
+
+namespace
+{
+	uint64 GetTracerId(const FMnhTracerData& TracerData)
+	{
+		// Guids are built from a serial, see FMissNoHitModule::NewTracerDataGuid
+		return uint64(TracerData.Guid.C) << 32 | TracerData.Guid.D;
+	}
+
+	uint64 GetObjectId(const UObject* Object)
+	{
+#if OBJECT_TRACE_ENABLED
+		TRACE_OBJECT(Object);
+		return FObjectTrace::GetObjectId(Object);
+#else
+		return Object ? Object->GetUniqueID() : 0;
+#endif
+	}
+}
+
+void FMnhTraceEvents::TracerStarted(const FMnhTracerData& TracerData)
+{
+	const AActor* Owner = TracerData.OwnerTracerComponent ? TracerData.OwnerTracerComponent->GetOwner() : nullptr;
+	const FString TracerTag = TracerData.GetTracerTag().ToString();
+	const FString OwnerName = Owner ? Owner->GetName() : FString();
+	UE_TRACE_LOG(MissNoHit, TracerStarted, MissNoHitChannel)
+		<< TracerStarted.Cycle(FPlatformTime::Cycles64())
+		<< TracerStarted.TracerId(GetTracerId(TracerData))
+		<< TracerStarted.OwnerId(GetObjectId(Owner))
+		<< TracerStarted.TraceSource(uint8(TracerData.Definition ? TracerData.Definition->TraceSource : EMnhTraceSource::MnhShapeComponent))
+		<< TracerStarted.TracerTickType(uint8(TracerData.TracerTickType))
+		<< TracerStarted.TraceShape(uint8(TracerData.ShapeData.TraceShape))
+		<< TracerStarted.TracerTag(*TracerTag, TracerTag.Len())
+		<< TracerStarted.OwnerName(*OwnerName, OwnerName.Len());
+}
+
+void FMnhTraceEvents::TracerStopped(const FMnhTracerData& TracerData, const bool bStopImmediate)
+{
+	UE_TRACE_LOG(MissNoHit, TracerStopped, MissNoHitChannel)
+		<< TracerStopped.Cycle(FPlatformTime::Cycles64())
+		<< TracerStopped.TracerId(GetTracerId(TracerData))
+		<< TracerStopped.bStopImmediate(bStopImmediate);
+}
+
+void FMnhTraceEvents::TickDecision(const FMnhTracerData& TracerData, const bool bTicked, const EMnhTraceTickReason Reason)
+{
+	UE_TRACE_LOG(MissNoHit, TickDecision, MissNoHitChannel)
+		<< TickDecision.Cycle(FPlatformTime::Cycles64())
+		<< TickDecision.TracerId(GetTracerId(TracerData))
+		<< TickDecision.bTicked(bTicked)
+		<< TickDecision.Reason(uint8(Reason));
+}
+
+void FMnhTraceEvents::Sweep(const FMnhTracerData& TracerData, const uint32 SubstepIdx, const float SweepLength,
+	const uint32 NumHits, const uint64 StartCycle, const uint64 EndCycle)
+{
+	UE_TRACE_LOG(MissNoHit, Sweep, MissNoHitChannel)
+		<< Sweep.StartCycle(StartCycle)
+		<< Sweep.EndCycle(EndCycle)
+		<< Sweep.TracerId(GetTracerId(TracerData))
+		<< Sweep.ThreadId(FPlatformTLS::GetCurrentThreadId())
+		<< Sweep.SubstepIdx(uint8(SubstepIdx))
+		<< Sweep.TraceShape(uint8(TracerData.ShapeData.TraceShape))
+		<< Sweep.SweepLength(SweepLength)
+		<< Sweep.NumHits(uint16(FMath::Min(NumHits, uint32(MAX_uint16))));
+}
+
+void FMnhTraceEvents::HitDispatched(const FMnhTracerData& TracerData, const uint32 SubstepIdx, const FHitResult& HitResult)
+{
+	UE_TRACE_LOG(MissNoHit, HitDispatched, MissNoHitChannel)
+		<< HitDispatched.Cycle(FPlatformTime::Cycles64())
+		<< HitDispatched.TracerId(GetTracerId(TracerData))
+		<< HitDispatched.HitActorId(GetObjectId(HitResult.GetActor()))
+		<< HitDispatched.SubstepIdx(uint8(SubstepIdx))
+		<< HitDispatched.ImpactPointX(float(HitResult.ImpactPoint.X))
+		<< HitDispatched.ImpactPointY(float(HitResult.ImpactPoint.Y))
+		<< HitDispatched.ImpactPointZ(float(HitResult.ImpactPoint.Z));
+}
+
+#endif
@@ -6,13 +6,13 @@
 #include "DrawDebugHelpers.h"
 #include "MnhComponents.h"
 #include "MnhHelpers.h"
+#include "MnhTrace.h"
 #include "MnhTracerComponent.h"
 #include "Components/BoxComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "Components/SphereComponent.h"
 #include "Components/SkeletalMeshComponent.h"
 #include "Components/StaticMeshComponent.h"
-#include "Kismet/KismetMathLibrary.h"
 #include "PhysicsEngine/BodySetup.h"
 
 class FMissNoHitModule;
@@ -34,14 +34,8 @@ void UMnhTracer::InitializeParameters(UPrimitiveComponent* SourceComponentArg)
 	
 	this->SourceComponent = SourceComponentArg;
 
-	CollisionParams.AddIgnoredActor(SourceComponent->GetOwner());
-	CollisionParams.bReturnPhysicalMaterial = true;
-	CollisionParams.bTraceComplex = TraceSettings.bTraceComplex;
+	OwnerComponent->GetIgnoreSet()->AddIgnoredActor(SourceComponent->GetOwner());
 	
-	for (const auto& ObjectType : TraceSettings.ObjectTypes)
-	{
-		ObjectQueryParams.AddObjectTypesToQuery(ObjectType);
-	}
 	switch (TraceSource)
 	{
 	case EMnhTraceSource::PhysicsAsset:
@@ -60,7 +54,7 @@ void UMnhTracer::InitializeParameters(UPrimitiveComponent* SourceComponentArg)
 		break;
 	}
 	
-	UpdateTracerData();
+	UpdateTracerData(EMnhTracerDataDirtyFlags::Shape | EMnhTracerDataDirtyFlags::Attachment);
 }
 
 void UMnhTracer::InitializeFromPhysicAsset()
@@ -190,62 +184,85 @@ bool UMnhTracer::IsTracerActive() const
 void UMnhTracer::ChangeTracerState(const bool bIsTracerActiveArg, const bool bStopImmediate)
 {
 	bIsTracerActive = bIsTracerActiveArg;
-	GetTracerData().ChangeTracerState(bIsTracerActiveArg, bStopImmediate);
+	FMissNoHitModule::Get().ChangeTracerState(TracerDataIdx, TracerDataGuid, bIsTracerActiveArg, bStopImmediate);
 }
 
 void UMnhTracer::RegisterTracerData()
+{
+	FMissNoHitModule& MnhModule = FMissNoHitModule::Get();
+	RegisterTracerDataAt(MnhModule.RequestNewTracerData());
+}
+
+void UMnhTracer::RegisterTracerDataAt(const int TracerDataIdxArg)
 {
 	SCOPE_CYCLE_COUNTER(STAT_MnhAddTracer)
-	FMissNoHitModule& MnhModule = FModuleManager::LoadModuleChecked<FMissNoHitModule>("MissNoHit");
-	TracerDataIdx = MnhModule.RequestNewTracerData();
-	TracerDataGuid = FGuid::NewGuid();
-	UpdateTracerData();
+	FMissNoHitModule& MnhModule = FMissNoHitModule::Get();
+	TracerDataIdx = TracerDataIdxArg;
+	TracerDataGuid = MnhModule.NewTracerDataGuid();
+	ActiveDefinition = UMnhTracerDefinition::FindOrCreateShared(*this);
+	WriteTracerData();
 }
 
-void UMnhTracer::UpdateTracerData()
+void UMnhTracer::UpdateTracerData(const EMnhTracerDataDirtyFlags DirtyFlags)
 {
-	float TickInterval = 0;
-	if (TracerTickType == EMnhTracerTickType::DistanceTick)
+	FMnhTracerDataChangeSet Changes;
+	Changes.DirtyFlags = DirtyFlags;
+	if (EnumHasAnyFlags(DirtyFlags, EMnhTracerDataDirtyFlags::Shape))
 	{
-		TickInterval = TickDistanceTraveled;
+		Changes.ShapeData = ShapeData;
 	}
-	else if (TracerTickType == EMnhTracerTickType::FixedRateTick)
+	if (EnumHasAnyFlags(DirtyFlags, EMnhTracerDataDirtyFlags::Attachment))
 	{
-		TickInterval = 1.0f/float(TargetFps);
+		Changes.SourceComponent = SourceComponent;
+		Changes.SocketOrBoneName = SocketOrBoneName;
 	}
-	
-	FMissNoHitModule& MnhModule = FModuleManager::LoadModuleChecked<FMissNoHitModule>("MissNoHit");
+	if (EnumHasAnyFlags(DirtyFlags, EMnhTracerDataDirtyFlags::TraceSettings))
+	{
+		Changes.Definition = ActiveDefinition;
+	}
+	if (EnumHasAnyFlags(DirtyFlags, EMnhTracerDataDirtyFlags::QueryParams))
+	{
+		Changes.IgnoreSet = OwnerComponent->GetIgnoreSet();
+	}
+	if (EnumHasAnyFlags(DirtyFlags, EMnhTracerDataDirtyFlags::TickPolicy))
+	{
+		Changes.TracerTickType = ActiveDefinition->TracerTickType;
+		Changes.TickInterval = ActiveDefinition->TickInterval;
+	}
+	FMissNoHitModule::Get().UpdateTracerData(TracerDataIdx, TracerDataGuid, Changes);
+}
+
+void UMnhTracer::WriteTracerData()
+{
+	FMissNoHitModule& MnhModule = FMissNoHitModule::Get();
 	auto& TracerData = MnhModule.GetTracerDataAt(TracerDataIdx);
 	TracerData.OwnerTracer = this;
 	TracerData.Guid = TracerDataGuid;
-	TracerData.TraceSource = TraceSource;
+	TracerData.Definition = ActiveDefinition;
 	TracerData.ShapeData = ShapeData;
 	TracerData.SocketOrBoneName = SocketOrBoneName;
-	TracerData.MeshSocket_1 = MeshSocket_1;
-	TracerData.MeshSocket_2 = MeshSocket_2;
-	TracerData.TraceSettings = TraceSettings;
 	TracerData.SourceComponent = SourceComponent;
 	TracerData.OwnerTracerComponent = OwnerComponent;
 	TracerData.TracerState = EMnhTracerState::Stopped;
 	TracerData.DeltaTimeLastTick = 0;
-	TracerData.TracerTickType = TracerTickType;
-	TracerData.TickInterval = TickInterval;
+	TracerData.TracerTickType = ActiveDefinition->TracerTickType;
+	TracerData.TickInterval = ActiveDefinition->TickInterval;
 	TracerData.bShouldTickThisFrame = false;
-	TracerData.CollisionParams = CollisionParams;
-	TracerData.ObjectQueryParams = ObjectQueryParams;
+	TracerData.IgnoreSet = OwnerComponent->GetIgnoreSet();
+	TracerData.PendingChanges = FMnhTracerDataChangeSet();
 	TracerData.bUsesTracerConfig = false;
 	TracerData.World = GetWorld();
 }
 
 void UMnhTracer::MarkTracerDataForRemoval() const
 {
-	FMissNoHitModule& MnhModule = FModuleManager::LoadModuleChecked<FMissNoHitModule>("MissNoHit");
+	FMissNoHitModule& MnhModule = FMissNoHitModule::Get();
 	MnhModule.MarkTracerDataForRemoval(TracerDataIdx, TracerDataGuid);
 }
 
 FMnhTracerData& UMnhTracer::GetTracerData() const
 {
-	FMissNoHitModule& MnhModule = FModuleManager::LoadModuleChecked<FMissNoHitModule>("MissNoHit");
+	FMissNoHitModule& MnhModule = FMissNoHitModule::Get();
 	auto& TracerData = MnhModule.GetTracerDataAt(TracerDataIdx);
 	if (TracerData.Guid != TracerDataGuid)
 	{
@@ -254,16 +271,59 @@ FMnhTracerData& UMnhTracer::GetTracerData() const
 	return TracerData;
 }
 
+void FMnhTracerData::ApplyPendingChanges()
+{
+	const auto DirtyFlags = PendingChanges.DirtyFlags;
+	if (DirtyFlags == EMnhTracerDataDirtyFlags::None)
+	{
+		return;
+	}
+	
+	if (EnumHasAnyFlags(DirtyFlags, EMnhTracerDataDirtyFlags::Shape))
+	{
+		ShapeData = PendingChanges.ShapeData;
+	}
+	if (EnumHasAnyFlags(DirtyFlags, EMnhTracerDataDirtyFlags::Attachment))
+	{
+		SourceComponent = PendingChanges.SourceComponent;
+		SocketOrBoneName = PendingChanges.SocketOrBoneName;
+		PendingChanges.SourceComponent = nullptr;
+	}
+	if (EnumHasAnyFlags(DirtyFlags, EMnhTracerDataDirtyFlags::TraceSettings))
+	{
+		Definition = PendingChanges.Definition;
+	}
+	if (EnumHasAnyFlags(DirtyFlags, EMnhTracerDataDirtyFlags::QueryParams))
+	{
+		IgnoreSet = MoveTemp(PendingChanges.IgnoreSet);
+	}
+	if (EnumHasAnyFlags(DirtyFlags, EMnhTracerDataDirtyFlags::TickPolicy))
+	{
+		TracerTickType = PendingChanges.TracerTickType;
+		TickInterval = PendingChanges.TickInterval;
+	}
+	PendingChanges.DirtyFlags = EMnhTracerDataDirtyFlags::None;
+}
+
 void FMnhTracerData::ChangeTracerState(const bool bIsTracerActiveArg, const bool bStopImmediate)
 {
 	if (bIsTracerActiveArg)
 	{
+		// Starting needs the current transform, which depends on the staged shape and attachment
+		ApplyPendingChanges();
 		this->TracerState = EMnhTracerState::Active;
 		this->DeltaTimeLastTick = 0;
+#if MNH_WITH_TRACER_STATS
+		const AActor* Owner = OwnerTracerComponent ? OwnerTracerComponent->GetOwner() : nullptr;
+		StatsEntry = FMnhTracerStats::Get().FindOrAddEntry({GetTracerTag(), Owner ? Owner->GetClass()->GetFName() : NAME_None, TracerTickType});
+#endif
 		if (SourceComponent)
 		{
 			UpdatePreviousTransform(GetCurrentTracerTransform());
 		}
+		// The pose sampled above is already swept
+		LastSweptPoseSerial = AnimationPoseSource ? AnimationPoseSource->GetPoseSerial() : 0;
+		MNH_TRACE(TracerStarted(*this));
 	}
 	else
 	{
@@ -275,17 +335,31 @@ void FMnhTracerData::ChangeTracerState(const bool bIsTracerActiveArg, const bool
 		{
 			this->TracerState = EMnhTracerState::Stopped;
 		}
+		MNH_TRACE(TracerStopped(*this, bStopImmediate));
 	}
 }
 
+FGameplayTag FMnhTracerData::GetTracerTag() const
+{
+	return bUsesTracerConfig
+		? OwnerTracerComponent->TracerConfigs[OwnerTracerConfigIdx].TracerTag
+		: OwnerTracer->TracerTag;
+}
+
 void FMnhTracerData::DoTrace(const uint32 Substeps, const uint32 TickIdx)
 {
-	SubstepHits.Reset();
+	LLM_SCOPE_BYTAG(MissNoHit_HitBuffers);
+	NumSubstepHits = 0;
+	if (SubstepHits.Num() < int32(Substeps))
+	{
+		SubstepHits.SetNum(Substeps, EAllowShrinking::No);
+	}
+	
 	if (TracerTransformsOverTime.Num() > 1)
 	{
-		const float SubstepRatio = 1.0 / Substeps;
-		const FTransform CurrentTransform = TracerTransformsOverTime.Last();
-		const FTransform PreviousTransform = TracerTransformsOverTime[0];
+		const FMnhCoreTransform CurrentTransform = FMnhCoreAdapter::ToCore(TracerTransformsOverTime.Last());
+		const FMnhCoreTransform PreviousTransform = FMnhCoreAdapter::ToCore(TracerTransformsOverTime[0]);
+		const auto& CollisionParams = IgnoreSet->GetCollisionParams(Definition->TraceSettings.bTraceComplex);
 
 		for (uint32 i = 0; i<Substeps; i++)
 		{
@@ -295,22 +369,28 @@ void FMnhTracerData::DoTrace(const uint32 Substeps, const uint32 TickIdx)
 				break;
 			}
 			
-			const FTransform& StartTransform = UKismetMathLibrary::TLerp(PreviousTransform, CurrentTransform, SubstepRatio * i, ELerpInterpolationMode::DualQuatInterp);
-			const FTransform& EndTransform = UKismetMathLibrary::TLerp(PreviousTransform, CurrentTransform, SubstepRatio * (i+1), ELerpInterpolationMode::DualQuatInterp);
-			const auto& AverageTransform = UKismetMathLibrary::TLerp(StartTransform, EndTransform, 0.5, ELerpInterpolationMode::DualQuatInterp);
+			const FMnhCoreSubstepTransforms SubstepTransforms = FMnhCoreScheduling::GetSubstepTransforms(PreviousTransform, CurrentTransform, i, Substeps);
+			const FTransform StartTransform = FMnhCoreAdapter::ToUnreal(SubstepTransforms.Start);
+			const FTransform EndTransform = FMnhCoreAdapter::ToUnreal(SubstepTransforms.End);
+			const FTransform AverageTransform = FMnhCoreAdapter::ToUnreal(SubstepTransforms.Average);
 			
-			TArray<FHitResult> OutHits;
-			FMnhHelpers::PerformTrace(StartTransform, EndTransform, AverageTransform,
-				OutHits, World, TraceSettings, ShapeData, CollisionParams, FCollisionResponseParams(), ObjectQueryParams);
+			auto& SubstepResults = SubstepHits[NumSubstepHits++];
+			SubstepResults.StartLocation = StartTransform.GetLocation();
+			SubstepResults.EndLocation = EndTransform.GetLocation();
+			SubstepResults.Scale = AverageTransform.GetScale3D();
+			SubstepResults.Rotation = AverageTransform.GetRotation();
 			
-			SubstepHits.Add(
-				{
-					StartTransform.GetLocation(),
-					EndTransform.GetLocation(),
-					AverageTransform.GetScale3D(),
-					AverageTransform.GetRotation(),
-					OutHits
-				});
+			auto& OutHits = SubstepResults.HitResults;
+			OutHits.Reset();
+#if MNH_TRACE_ENABLED
+			MNH_TRACE_SCOPE("MissNoHit Sweep");
+			const uint64 SweepStartCycle = FMnhTraceEvents::IsEnabled() ? FPlatformTime::Cycles64() : 0;
+#endif
+			FMnhHelpers::PerformTrace(StartTransform, EndTransform, AverageTransform,
+				OutHits, World, Definition->TraceSettings, ShapeData, CollisionParams, FCollisionResponseParams(), Definition->ObjectQueryParams);
+			FMnhHelpers::SelectBestHitPerActor(OutHits, Definition->HitSelection, FMnhHelpers::GetTracerTipLocation(EndTransform, ShapeData));
+			MNH_TRACE(Sweep(*this, i, (SubstepResults.EndLocation - SubstepResults.StartLocation).Length(), OutHits.Num(),
+				SweepStartCycle, FPlatformTime::Cycles64()));
 		}
 	}
 	else
@@ -321,6 +401,55 @@ void FMnhTracerData::DoTrace(const uint32 Substeps, const uint32 TickIdx)
 }
 
 
+void FMnhTracerData::ReserveHitBuffers(const int32 Substeps, const int32 HitsPerSubstep)
+{
+	LLM_SCOPE_BYTAG(MissNoHit_HitBuffers);
+	if (SubstepHits.Num() < Substeps)
+	{
+		SubstepHits.SetNum(Substeps, EAllowShrinking::No);
+	}
+	for (auto& SubstepResults : SubstepHits)
+	{
+		SubstepResults.HitResults.Reserve(HitsPerSubstep);
+	}
+}
+
+SIZE_T FMnhTracerData::GetAllocatedSize() const
+{
+	SIZE_T AllocatedSize = SubstepHits.GetAllocatedSize();
+	for (const auto& SubstepResults : SubstepHits)
+	{
+		AllocatedSize += SubstepResults.HitResults.GetAllocatedSize();
+	}
+	return AllocatedSize;
+}
+
+void FMnhTracerData::ResetForReuse()
+{
+	// Everything except the hit buffers, so a recycled slot does not allocate on its first traces
+	Definition = nullptr;
+	SocketOrBoneName = NAME_None;
+	ShapeData = FMnhShapeData();
+	bUsesTracerConfig = true;
+	DeltaTimeLastTick = 0;
+	Guid.Invalidate();
+	World = nullptr;
+	SourceComponent = nullptr;
+	OwnerTracer = nullptr;
+	OwnerTracerConfigIdx = -1;
+	OwnerTracerComponent = nullptr;
+	TracerState = EMnhTracerState::Stopped;
+	IgnoreSet.Reset();
+	PendingChanges = FMnhTracerDataChangeSet();
+	AnimationPoseSource.Reset();
+	LastSweptPoseSerial = 0;
+	NumSubstepHits = 0;
+	Counters = FMnhTracerCounters();
+	StatsEntry = nullptr;
+	TracerTransformsOverTime.Reset();
+	bShouldTickThisFrame = false;
+	IsPendingRemoval = false;
+}
 
 void FMnhTracerConfig::InitializeParameters(UPrimitiveComponent* SourceComponentArg)
 {
@@ -333,16 +462,11 @@ void FMnhTracerConfig::InitializeParameters(UPrimitiveComponent* SourceComponent
 	
 	this->SourceComponent = SourceComponentArg;
 
-	CollisionParams.AddIgnoredActor(SourceComponent->GetOwner());
-	CollisionParams.AddIgnoredActor(OwnerTracerComponent->GetOwner());
-	CollisionParams.bReturnPhysicalMaterial = true;
-	CollisionParams.bTraceComplex = TraceSettings.bTraceComplex;
+	const auto& IgnoreSet = OwnerTracerComponent->GetIgnoreSet();
+	IgnoreSet->AddIgnoredActor(SourceComponent->GetOwner());
+	IgnoreSet->AddIgnoredActor(OwnerTracerComponent->GetOwner());
 	
-	for (const auto& ObjectType : TraceSettings.ObjectTypes)
-	{
-		ObjectQueryParams.AddObjectTypesToQuery(ObjectType);
-	}
-	switch (TraceSource)
+	switch (GetDefinition().TraceSource)
 	{
 	case EMnhTraceSource::PhysicsAsset:
 		InitializeFromPhysicAsset();
@@ -360,7 +484,7 @@ void FMnhTracerConfig::InitializeParameters(UPrimitiveComponent* SourceComponent
 		break;
 	}
 	
-	UpdateTracerData();
+	UpdateTracerData(EMnhTracerDataDirtyFlags::Shape | EMnhTracerDataDirtyFlags::Attachment);
 }
 
 void FMnhTracerConfig::InitializeFromPhysicAsset()
@@ -446,9 +570,11 @@ void FMnhTracerConfig::InitializeFromStaticMeshSockets()
 {
 	if (const auto StaticMeshSource = Cast<UStaticMeshComponent>(SourceComponent))
 	{
-		const auto Socket1Transform = StaticMeshSource->GetSocketTransform(MeshSocket_1, RTS_Component);
-		const auto Socket2Transform = StaticMeshSource->GetSocketTransform(MeshSocket_2, RTS_Component);
-		this->ShapeData = FMnhHelpers::GetCapsuleShapeDataFromTransforms(Socket1Transform, Socket2Transform, MeshSocketTracerLengthOffset, MeshSocketTracerRadius);
+		const auto& TracerDefinition = GetDefinition();
+		const auto Socket1Transform = StaticMeshSource->GetSocketTransform(TracerDefinition.MeshSocket_1, RTS_Component);
+		const auto Socket2Transform = StaticMeshSource->GetSocketTransform(TracerDefinition.MeshSocket_2, RTS_Component);
+		this->ShapeData = FMnhHelpers::GetCapsuleShapeDataFromTransforms(Socket1Transform, Socket2Transform,
+			TracerDefinition.MeshSocketTracerLengthOffset, TracerDefinition.MeshSocketTracerRadius);
 	}
 	else
 	{
@@ -465,11 +591,12 @@ void FMnhTracerConfig::InitializeFromSkeletalMeshSockets()
 {
 	if(const auto SkeletalMeshSource= Cast<USkeletalMeshComponent>(SourceComponent))
 	{
-		const auto Socket1Transform = SkeletalMeshSource->GetSocketTransform(MeshSocket_1, RTS_Component);
-		const auto Socket2Transform = SkeletalMeshSource->GetSocketTransform(MeshSocket_2, RTS_Component);
+		const auto& TracerDefinition = GetDefinition();
+		const auto Socket1Transform = SkeletalMeshSource->GetSocketTransform(TracerDefinition.MeshSocket_1, RTS_Component);
+		const auto Socket2Transform = SkeletalMeshSource->GetSocketTransform(TracerDefinition.MeshSocket_2, RTS_Component);
 		this->ShapeData = FMnhHelpers::GetCapsuleShapeDataFromTransforms(
-			Socket1Transform, Socket2Transform, MeshSocketTracerLengthOffset, MeshSocketTracerRadius);
-		this->ShapeData.HalfSize.X = MeshSocketTracerLengthOffset;
+			Socket1Transform, Socket2Transform, TracerDefinition.MeshSocketTracerLengthOffset, TracerDefinition.MeshSocketTracerRadius);
+		this->ShapeData.HalfSize.X = TracerDefinition.MeshSocketTracerLengthOffset;
 	}
 	else
 	{
@@ -485,7 +612,7 @@ void FMnhTracerConfig::InitializeFromSkeletalMeshSockets()
 void FMnhTracerConfig::ChangeTracerState(bool bIsTracerActiveArg, bool bStopImmediate)
 {
 	bIsTracerActive = bIsTracerActiveArg;
-	GetTracerData().ChangeTracerState(bIsTracerActiveArg, bStopImmediate);
+	FMissNoHitModule::Get().ChangeTracerState(TracerDataIdx, TracerDataGuid, bIsTracerActiveArg, bStopImmediate);
 }
 
 bool FMnhTracerConfig::IsTracerActive() const
@@ -494,57 +621,93 @@ bool FMnhTracerConfig::IsTracerActive() const
 }
 
 void FMnhTracerConfig::RegisterTracerData()
+{
+	FMissNoHitModule& MnhModule = FMissNoHitModule::Get();
+	RegisterTracerDataAt(MnhModule.RequestNewTracerData());
+}
+
+void FMnhTracerConfig::RegisterTracerDataAt(const int TracerDataIdxArg)
 {
 	SCOPE_CYCLE_COUNTER(STAT_MnhAddTracer)
-	FMissNoHitModule& MnhModule = FModuleManager::LoadModuleChecked<FMissNoHitModule>("MissNoHit");
-	TracerDataIdx = MnhModule.RequestNewTracerData();
-	TracerDataGuid = FGuid::NewGuid();
-	UpdateTracerData();
+	FMissNoHitModule& MnhModule = FMissNoHitModule::Get();
+	TracerDataIdx = TracerDataIdxArg;
+	TracerDataGuid = MnhModule.NewTracerDataGuid();
+	ResolveDefinition();
+	WriteTracerData();
 }
 
-void FMnhTracerConfig::UpdateTracerData() const
+void FMnhTracerConfig::ResolveDefinition()
 {
-	float TickInterval = 0;
-	if (TracerTickType == EMnhTracerTickType::DistanceTick)
+	if (Definition)
 	{
-		TickInterval = TickDistanceTraveled;
+		ActiveDefinition = Definition;
+		SocketOrBoneName = Definition->SocketOrBoneName;
 	}
-	else if (TracerTickType == EMnhTracerTickType::FixedRateTick)
+	else
 	{
-		TickInterval = 1.0f/float(TargetFps);
+		ActiveDefinition = UMnhTracerDefinition::FindOrCreateShared(*this);
 	}
-	
-	FMissNoHitModule& MnhModule = FModuleManager::LoadModuleChecked<FMissNoHitModule>("MissNoHit");
+}
+
+void FMnhTracerConfig::UpdateTracerData(const EMnhTracerDataDirtyFlags DirtyFlags) const
+{
+	FMnhTracerDataChangeSet Changes;
+	Changes.DirtyFlags = DirtyFlags;
+	if (EnumHasAnyFlags(DirtyFlags, EMnhTracerDataDirtyFlags::Shape))
+	{
+		Changes.ShapeData = ShapeData;
+	}
+	if (EnumHasAnyFlags(DirtyFlags, EMnhTracerDataDirtyFlags::Attachment))
+	{
+		Changes.SourceComponent = SourceComponent;
+		Changes.SocketOrBoneName = SocketOrBoneName;
+	}
+	if (EnumHasAnyFlags(DirtyFlags, EMnhTracerDataDirtyFlags::TraceSettings))
+	{
+		Changes.Definition = ActiveDefinition;
+	}
+	if (EnumHasAnyFlags(DirtyFlags, EMnhTracerDataDirtyFlags::QueryParams))
+	{
+		Changes.IgnoreSet = OwnerTracerComponent->GetIgnoreSet();
+	}
+	if (EnumHasAnyFlags(DirtyFlags, EMnhTracerDataDirtyFlags::TickPolicy))
+	{
+		Changes.TracerTickType = ActiveDefinition->TracerTickType;
+		Changes.TickInterval = ActiveDefinition->TickInterval;
+	}
+	FMissNoHitModule::Get().UpdateTracerData(TracerDataIdx, TracerDataGuid, Changes);
+}
+
+void FMnhTracerConfig::WriteTracerData() const
+{
+	FMissNoHitModule& MnhModule = FMissNoHitModule::Get();
 	auto& TracerData = MnhModule.GetTracerDataAt(TracerDataIdx);
 	TracerData.OwnerTracerConfigIdx = OwnerTracerConfigIdx;
 	TracerData.Guid = TracerDataGuid;
-	TracerData.TraceSource = TraceSource;
+	TracerData.Definition = ActiveDefinition;
 	TracerData.ShapeData = ShapeData;
 	TracerData.SocketOrBoneName = SocketOrBoneName;
-	TracerData.MeshSocket_1 = MeshSocket_1;
-	TracerData.MeshSocket_2 = MeshSocket_2;
-	TracerData.TraceSettings = TraceSettings;
 	TracerData.SourceComponent = SourceComponent;
 	TracerData.OwnerTracerComponent = OwnerTracerComponent;
 	TracerData.DeltaTimeLastTick = 0;
-	TracerData.TracerTickType = TracerTickType;
-	TracerData.TickInterval = TickInterval;
+	TracerData.TracerTickType = ActiveDefinition->TracerTickType;
+	TracerData.TickInterval = ActiveDefinition->TickInterval;
 	TracerData.bShouldTickThisFrame = false;
 	TracerData.TracerState = EMnhTracerState::Stopped;
-	TracerData.CollisionParams = CollisionParams;
-	TracerData.ObjectQueryParams = ObjectQueryParams;
+	TracerData.IgnoreSet = OwnerTracerComponent->GetIgnoreSet();
+	TracerData.PendingChanges = FMnhTracerDataChangeSet();
 	TracerData.World = OwnerTracerComponent->GetOwner()->GetWorld();
 }
 
 void FMnhTracerConfig::MarkTracerDataForRemoval() const
 {
-	FMissNoHitModule& MnhModule = FModuleManager::LoadModuleChecked<FMissNoHitModule>("MissNoHit");
+	FMissNoHitModule& MnhModule = FMissNoHitModule::Get();
 	MnhModule.MarkTracerDataForRemoval(TracerDataIdx, TracerDataGuid);
 }
 
 FMnhTracerData& FMnhTracerConfig::GetTracerData() const
 {
-	FMissNoHitModule& MnhModule = FModuleManager::LoadModuleChecked<FMissNoHitModule>("MissNoHit");
+	FMissNoHitModule& MnhModule = FMissNoHitModule::Get();
 	auto& TracerData = MnhModule.GetTracerDataAt(TracerDataIdx);
 	if (TracerData.Guid != TracerDataGuid)
 	{
@@ -4,7 +4,12 @@
 #include "MnhTracerComponent.h"
 
 #include "GameplayTagContainer.h"
+#include "MissNoHit.h"
+#include "MnhAnimNotifyState.h"
+#include "MnhConsoleVariables.h"
+#include "MnhLagCompensation.h"
 #include "MnhTracer.h"
+#include "GameFramework/GameStateBase.h"
 
 DEFINE_LOG_CATEGORY(LogMnh)
 
@@ -13,6 +18,35 @@ class FMissNoHitModule;
 UMnhTracerComponent::UMnhTracerComponent()
 {
 	PrimaryComponentTick.bCanEverTick = false;
+	// Carries the hit replication RPCs, has no replicated properties
+	SetIsReplicatedByDefault(true);
+}
+
+void UMnhTracerComponent::PostInitProperties()
+{
+	Super::PostInitProperties();
+	if (!HasAnyFlags(RF_ClassDefaultObject))
+	{
+		LLM_SCOPE_BYTAG(MissNoHit_Registry);
+		RebuildTracerTagIndices();
+	}
+}
+
+void UMnhTracerComponent::OnRegister()
+{
+	Super::OnRegister();
+	{
+		// Rebuilt here as well since serialized tracers are only loaded after PostInitProperties
+		LLM_SCOPE_BYTAG(MissNoHit_Registry);
+		RebuildTracerTagIndices();
+	}
+	UMnhAnimNotifyState::InvalidateBindings(GetOwner());
+}
+
+void UMnhTracerComponent::OnUnregister()
+{
+	UMnhAnimNotifyState::InvalidateBindings(GetOwner());
+	Super::OnUnregister();
 }
 
 void UMnhTracerComponent::OnComponentDestroyed(const bool bDestroyingHierarchy)
@@ -67,28 +101,16 @@ void UMnhTracerComponent::InitializeTracers(const FGameplayTagContainer TracerTa
 	}
 
 	int InitializedTracerCount = 0;
-	for (const auto Tracer : Tracers)
+	ForEachTracer(TracerTags, [&](UMnhTracer* Tracer)
 	{
-		if (!Tracer) // Skip null tracers
-		{
-			FMnhHelpers::Mnh_Log("MissNoHit Warning: Null Tracer Found during initialization of actor:"
-						" " + GetOwner()->GetName() + ", skipping...", true);
-			continue;
-		}
-		if(TracerTags.HasTagExact(Tracer->TracerTag))
-		{
-			Tracer->InitializeParameters(TracerSource);
-			InitializedTracerCount++;
-		}
-	}
-	for (auto& TracerConfig : TracerConfigs)
+		Tracer->InitializeParameters(TracerSource);
+		InitializedTracerCount++;
+	});
+	ForEachTracerConfig(TracerTags, [&](FMnhTracerConfig& TracerConfig)
 	{
-		if(TracerTags.HasTagExact(TracerConfig.TracerTag))
-		{
-			TracerConfig.InitializeParameters(TracerSource);
-			InitializedTracerCount++;
-		}
-	}
+		TracerConfig.InitializeParameters(TracerSource);
+		InitializedTracerCount++;
+	});
 	if (InitializedTracerCount == 0)
 	{
 		const FString Message = FString::Printf(TEXT("MissNoHit Warning: No Tracer with Tag [%s] found during initialization"), *TracerTags.ToString());
@@ -99,6 +121,8 @@ void UMnhTracerComponent::InitializeTracers(const FGameplayTagContainer TracerTa
 
 void UMnhTracerComponent::StopAllTracers()
 {
+	// Listeners may add tracers, so every state is changed before anything is broadcast
+	TArray<FGameplayTag, TInlineAllocator<8>> StoppedTracerTags;
 	for (const auto Tracer : Tracers)
 	{
 		if (!Tracer) // Skip null tracers
@@ -108,13 +132,18 @@ void UMnhTracerComponent::StopAllTracers()
 		}
 		
 		Tracer->ChangeTracerState(false);
-		OnTracerStopped.Broadcast(Tracer->TracerTag);
+		StoppedTracerTags.Add(Tracer->TracerTag);
 	}
 
 	for (auto& TracerConfig : TracerConfigs)
 	{
 		TracerConfig.ChangeTracerState(false);
-		OnTracerStopped.Broadcast(TracerConfig.TracerTag);
+		StoppedTracerTags.Add(TracerConfig.TracerTag);
+	}
+	
+	for (const auto& TracerTag : StoppedTracerTags)
+	{
+		OnTracerStopped.Broadcast(TracerTag);
 	}
 }
 
@@ -130,22 +159,17 @@ void UMnhTracerComponent::AddToIgnoredActors(const FGameplayTagContainer TracerT
 		FMnhHelpers::Mnh_Log("MissNoHit Warning: Actor is null, cannot add to ignored actors");
 		return;
 	}
-	for (auto Tracer : Tracers)
-	{
-		if (!Tracer)
-		{
-			FMnhHelpers::Mnh_Log("MissNoHit Warning: Null Tracer Found during adding to ignored actors, skipping...");
-			continue;
-		}
-		if (TracerTags.HasTagExact(Tracer->TracerTag))
-		{
-			Tracer->CollisionParams.AddIgnoredActor(Actor);
-		}
-	}
-	for (auto& TracerConfig: TracerConfigs)
+	FMissNoHitModule::Get().AddIgnoredActor(IgnoreSet, Actor);
+}
+
+void UMnhTracerComponent::RemoveFromIgnoredActors(AActor* Actor)
+{
+	if (Actor == nullptr)
 	{
-		TracerConfig.CollisionParams.AddIgnoredActor(Actor);
+		FMnhHelpers::Mnh_Log("MissNoHit Warning: Actor is null, cannot remove from ignored actors");
+		return;
 	}
+	FMissNoHitModule::Get().RemoveIgnoredActor(IgnoreSet, Actor);
 }
 
 void UMnhTracerComponent::AddToIgnoredActorsArray(const FGameplayTagContainer TracerTags, TArray<AActor*> Actors)
@@ -175,6 +199,16 @@ int UMnhTracerComponent::AddNewTracer(const FGameplayTag TracerTag, const EMnhTr
 			return -1;
 		}
 	}
+	if (const int ExistingTracerConfigIdx = FindTracerConfig(TracerTag); ExistingTracerConfigIdx != -1)
+	{
+		if (TracerConfigs[ExistingTracerConfigIdx].GetTraceSource() != TraceSource)
+		{
+			const FString Message = FString::Printf(TEXT("MissNoHit Warning: Tracer Config with Tag [%s] already exists with different Trace Source."
+												"You can only have multiple tracers with same tag if they also have same trace sources"), *TracerTag.ToString());
+			FMnhHelpers::Mnh_Log(Message);
+			return -1;
+		}
+	}
 
 	const auto TracerConfigIdx = TracerConfigs.AddDefaulted();
 	auto& TracerConfig = TracerConfigs[TracerConfigIdx];
@@ -188,9 +222,31 @@ int UMnhTracerComponent::AddNewTracer(const FGameplayTag TracerTag, const EMnhTr
 	TracerConfig.DrawDebugType = DrawDebugType;
 	TracerConfig.DebugDrawTime = DrawDebugLifetime;
 	TracerConfig.OwnerTracerComponent = this;
+	TracerConfigIndicesByTag.FindOrAdd(TracerTag).Add(TracerConfigIdx);
+	TracerConfigsRevision++;
 	return TracerConfigIdx;
 }
 
+void UMnhTracerComponent::AddNewTracerFromDefinition(const FGameplayTag TracerTag, UMnhTracerDefinition* Definition)
+{
+	if (!Definition)
+	{
+		const FString Message = FString::Printf(TEXT("MissNoHit Warning: Tracer Definition is null for Tracer with Tag [%s]"), *TracerTag.ToString());
+		FMnhHelpers::Mnh_Log(Message);
+		return;
+	}
+	
+	const auto TracerIdx =
+		AddNewTracer(TracerTag, Definition->TraceSource, Definition->TraceSettings, Definition->TracerTickType,
+			Definition->TargetFps, Definition->TickDistanceTraveled, Definition->DrawDebugType, Definition->DebugDrawTime);
+	if (TracerIdx != -1)
+	{
+		auto& TracerConfig = TracerConfigs[TracerIdx];
+		TracerConfig.Definition = Definition;
+		TracerConfig.RegisterTracerData();
+	}
+}
+
 void UMnhTracerComponent::AddNewMnhComponentTracer(const FGameplayTag TracerTag, const FMnhTraceSettings TraceSettings, const EMnhTracerTickType TracerTickType,
                                                    const int TargetFps, const int TargetDistanceTraveled, const EDrawDebugTrace::Type DrawDebugType, const float DrawDebugLifetime)
 {
@@ -269,82 +325,68 @@ void UMnhTracerComponent::StartTracersInternal(const FGameplayTagContainer& Trac
 
 	if (bResetHitCache)
 	{
-	    for (int i = HitCache.Num() - 1; i >= 0; --i)
-	    {
-	        const auto &HitRecord = HitCache[i];
-	        for (const auto TracerTag : TracerTags)
-	        {
-	            if (HitRecord.TracerTag.MatchesTag(TracerTag))
-	            {
-	                HitCache.RemoveAt(i);
-	                break;
-	            }
-	        }
-	    }
+		const int32 NumKeptRecords = FMnhCoreHitCache::RemoveRecords(HitCache.GetData(), HitCache.Num(), [&TracerTags](const FMnhHitCache& HitRecord)
+		{
+			return HitRecord.TracerTag.MatchesAny(TracerTags);
+		});
+		HitCache.SetNum(NumKeptRecords, EAllowShrinking::No);
 	}
 	
-	for (const auto Tracer : Tracers)
+	ForEachTracer(TracerTags, [this](const UMnhTracer* Tracer)
 	{
-		if (!Tracer)
-		{
-			// FMnhHelpers::Mnh_Log("MissNoHit Warning: Null Tracer Found during tracer start on actor: " + GetOwner()->GetName() + ", skipping...");
-			continue;
-		}
-		
 		if (Tracer->SourceComponent == nullptr && Tracer->TraceSource != EMnhTraceSource::AnimNotify)
 		{
 			// FMnhHelpers::Mnh_Log("MissNoHit Warning: Tracer Source is not initialized for Tracer: " + Tracer->TracerTag.ToString());
-			continue;
+			return;
 		}
 		
-		if (TracerTags.HasTagExact(Tracer->TracerTag))
-		{
-			
-			FMnhHelpers::Mnh_Log("MissNoHit Warning: "
-						   "Tracers are deprecated and will be removed in future update, please switch to TracerConfig instead on actor:" + GetOwner()->GetName());
-			// if constexpr (!AllowAnimNotify)
-			// {
-			// 	if (Tracer->TraceSource == EMnhTraceSource::AnimNotify)
-			// 	{
-			// 		const FString DebugMessage = FString::Printf(TEXT("MissNoHit Warning: "
-			// 												   "AnimNotifyTracer [%s] on Owner [%s] cannot be started manually"),
-			// 												   *Tracer->TracerTag.ToString(), *GetOwner()->GetName());
-			// 		FMnhHelpers::Mnh_Log(DebugMessage);
-			// 		continue;
-			// 	}
-			// }
-			//
-			// Tracer->ChangeTracerState(true);
-			// OnTracerStarted.Broadcast(Tracer->TracerTag);
-		}
-	}
-
-	for (auto& TracerConfig: TracerConfigs)
-	{
-		if (TracerConfig.SourceComponent == nullptr && TracerConfig.TraceSource != EMnhTraceSource::AnimNotify)
+		FMnhHelpers::Mnh_Log("MissNoHit Warning: "
+					   "Tracers are deprecated and will be removed in future update, please switch to TracerConfig instead on actor:" + GetOwner()->GetName());
+		// if constexpr (!AllowAnimNotify)
+		// {
+		// 	if (Tracer->TraceSource == EMnhTraceSource::AnimNotify)
+		// 	{
+		// 		const FString DebugMessage = FString::Printf(TEXT("MissNoHit Warning: "
+		// 												   "AnimNotifyTracer [%s] on Owner [%s] cannot be started manually"),
+		// 												   *Tracer->TracerTag.ToString(), *GetOwner()->GetName());
+		// 		FMnhHelpers::Mnh_Log(DebugMessage);
+		// 		continue;
+		// 	}
+		// }
+		//
+		// Tracer->ChangeTracerState(true);
+		// OnTracerStarted.Broadcast(Tracer->TracerTag);
+	});
+
+	// Listeners may add tracers, so every state is changed before anything is broadcast
+	TArray<FGameplayTag, TInlineAllocator<8>> StartedTracerTags;
+	ForEachTracerConfig(TracerTags, [this, AllowAnimNotify, &StartedTracerTags](FMnhTracerConfig& TracerConfig)
+	{
+		if (TracerConfig.SourceComponent == nullptr && TracerConfig.GetTraceSource() != EMnhTraceSource::AnimNotify)
 		{
 			FMnhHelpers::Mnh_Log("MissNoHit Warning: Tracer Source is not initialized for Tracer Config: "
 						"" + TracerConfig.TracerTag.ToString() + " On Actor: " + GetOwner()->GetName());
-			continue;
+			return;
 		}
 		
-		if (TracerTags.HasTagExact(TracerConfig.TracerTag))
+		if (!AllowAnimNotify)
 		{
-			if (!AllowAnimNotify)
+			if (TracerConfig.GetTraceSource() == EMnhTraceSource::AnimNotify)
 			{
-				if (TracerConfig.TraceSource == EMnhTraceSource::AnimNotify)
-				{
-					const FString DebugMessage = FString::Printf(TEXT("MissNoHit Warning: "
-															   "AnimNotifyTracer [%s] on Owner [%s] cannot be started manually"),
-															   *TracerConfig.TracerTag.ToString(), *GetOwner()->GetName());
-					FMnhHelpers::Mnh_Log(DebugMessage);
-					continue;
-				}
+				const FString DebugMessage = FString::Printf(TEXT("MissNoHit Warning: "
+														   "AnimNotifyTracer [%s] on Owner [%s] cannot be started manually"),
+														   *TracerConfig.TracerTag.ToString(), *GetOwner()->GetName());
+				FMnhHelpers::Mnh_Log(DebugMessage);
+				return;
 			}
-			
-			TracerConfig.ChangeTracerState(true);
-			OnTracerStarted.Broadcast(TracerConfig.TracerTag);
 		}
+		
+		TracerConfig.ChangeTracerState(true);
+		StartedTracerTags.Add(TracerConfig.TracerTag);
+	});
+	for (const auto& TracerTag : StartedTracerTags)
+	{
+		OnTracerStarted.Broadcast(TracerTag);
 	}
 }
 
@@ -354,96 +396,262 @@ void UMnhTracerComponent::StopTracers(const FGameplayTagContainer TracerTags)
 	{
 		return;
 	}
-	for (const auto Tracer : Tracers)
+	StopTracersInternal(TracerTags, true);
+}
+
+void UMnhTracerComponent::StopTracersDelayed(const FGameplayTagContainer& TracerTags)
+{
+	if (!this)
 	{
-		if (!Tracer)
-		{
-			FMnhHelpers::Mnh_Log("MissNoHit Warning: Null Tracer Found during tracer stop on actor: " + GetOwner()->GetName() + ", skipping...");
-			continue;
-		}
-		
-		if (TracerTags.HasTagExact(Tracer->TracerTag))
-		{
-			Tracer->ChangeTracerState(false);
-			OnTracerStopped.Broadcast(Tracer->TracerTag);
-		}
+		return;
 	}
-	for (auto& TracerConfig : TracerConfigs)
+	StopTracersInternal(TracerTags, false);
+}
+
+void UMnhTracerComponent::StopTracersInternal(const FGameplayTagContainer& TracerTags, const bool bStopImmediately)
+{
+	// Indices are collected first, listeners may add tracers and reallocate the arrays being iterated
+	FMnhTracerIndices TracerIndices;
+	FMnhTracerIndices TracerConfigIndices;
+	ForEachTracerIndex(TracerTags, TracerIndicesByTag, [&TracerIndices](const int TracerIdx)
 	{
-		if (TracerTags.HasTagExact(TracerConfig.TracerTag))
-		{
-			TracerConfig.ChangeTracerState(false);
-			OnTracerStopped.Broadcast(TracerConfig.TracerTag);
-		}
+		TracerIndices.Add(TracerIdx);
+	});
+	ForEachTracerIndex(TracerTags, TracerConfigIndicesByTag, [&TracerConfigIndices](const int TracerConfigIdx)
+	{
+		TracerConfigIndices.Add(TracerConfigIdx);
+	});
+
+	TArray<FGameplayTag, TInlineAllocator<8>> StoppedTracerTags;
+	for (const int TracerIdx : TracerIndices)
+	{
+		Tracers[TracerIdx]->ChangeTracerState(false, bStopImmediately);
+		StoppedTracerTags.Add(Tracers[TracerIdx]->TracerTag);
+	}
+	for (const int TracerConfigIdx : TracerConfigIndices)
+	{
+		TracerConfigs[TracerConfigIdx].ChangeTracerState(false, bStopImmediately);
+		StoppedTracerTags.Add(TracerConfigs[TracerConfigIdx].TracerTag);
+	}
+	
+	for (const auto& TracerTag : StoppedTracerTags)
+	{
+		OnTracerStopped.Broadcast(TracerTag);
 	}
 }
 
-void UMnhTracerComponent::StopTracersDelayed(const FGameplayTagContainer& TracerTags)
+FDelegateHandle UMnhTracerComponent::SubscribeToTracerHits(const FGameplayTagContainer& TracerTags, const FMnhOnTracerHitDetected::FDelegate& Delegate)
 {
-	if (!this)
+	// An empty container subscribes under the empty tag, which receives the hits of every tracer
+	if (TracerTags.Num() == 0)
+	{
+		return SubscribeToTracerHits(FGameplayTag::EmptyTag, Delegate);
+	}
+	
+	// Handle is carried with the delegate, so each tag's multicast returns the same one
+	FDelegateHandle DelegateHandle;
+	for (const auto& TracerTag : TracerTags)
+	{
+		DelegateHandle = SubscribeToTracerHits(TracerTag, Delegate);
+	}
+	return DelegateHandle;
+}
+
+FDelegateHandle UMnhTracerComponent::SubscribeToTracerHits(const FGameplayTag TracerTag, const FMnhOnTracerHitDetected::FDelegate& Delegate)
+{
+	auto Subscription = TracerHitSubscriptions.Find(TracerTag);
+	if (!Subscription)
+	{
+		Subscription = &TracerHitSubscriptions.Add(TracerTag, MakeShared<FMnhOnTracerHitDetected>());
+	}
+	return (*Subscription)->Add(Delegate);
+}
+
+void UMnhTracerComponent::UnsubscribeFromTracerHits(const FGameplayTagContainer& TracerTags, const FDelegateHandle DelegateHandle)
+{
+	if (TracerTags.Num() == 0)
 	{
+		UnsubscribeFromTracerHits(FGameplayTag::EmptyTag, DelegateHandle);
 		return;
 	}
-	for (const auto Tracer : Tracers)
+	
+	for (const auto& TracerTag : TracerTags)
 	{
-		if (!Tracer)
-		{
-			FMnhHelpers::Mnh_Log("MissNoHit Warning: Null Tracer Found during tracer stop on actor: " + GetOwner()->GetName() + ", skipping...");
-			continue;
-		}
-		
-		if (TracerTags.HasTagExact(Tracer->TracerTag))
-		{
-			Tracer->ChangeTracerState(false, false);
-			OnTracerStopped.Broadcast(Tracer->TracerTag);
-		}
+		UnsubscribeFromTracerHits(TracerTag, DelegateHandle);
 	}
-	for (auto& TracerConfig : TracerConfigs)
+}
+
+void UMnhTracerComponent::UnsubscribeFromTracerHits(const FGameplayTag TracerTag, const FDelegateHandle DelegateHandle)
+{
+	if (const auto Subscription = TracerHitSubscriptions.Find(TracerTag))
 	{
-		if (TracerTags.HasTagExact(TracerConfig.TracerTag))
+		(*Subscription)->Remove(DelegateHandle);
+		if (!(*Subscription)->IsBound())
 		{
-			TracerConfig.ChangeTracerState(false, false);
-			OnTracerStopped.Broadcast(TracerConfig.TracerTag);
+			TracerHitSubscriptions.Remove(TracerTag);
 		}
 	}
 }
 
 UMnhTracer* UMnhTracerComponent::FindTracer(const FGameplayTag TracerTag)
 {
-	for (const auto Tracer : Tracers)
+	if (const auto TracerIndices = TracerIndicesByTag.Find(TracerTag))
 	{
-		if (!Tracer)
-		{
-			FMnhHelpers::Mnh_Log("MissNoHit Warning: Null Tracer Found during tracer find on actor: " + GetOwner()->GetName() + ", skipping...");
-			continue;
-		}
-		
-		if (Tracer->TracerTag.MatchesTagExact(TracerTag))
-		{
-			return Tracer;
-		}
+		return Tracers[(*TracerIndices)[0]];
 	}
 	return nullptr;
 }
 
 int UMnhTracerComponent::FindTracerConfig(const FGameplayTag TracerTag)
 {
-	for (int Idx = 0; Idx < TracerConfigs.Num(); Idx++)
+	if (const auto TracerConfigIndices = TracerConfigIndicesByTag.Find(TracerTag))
+	{
+		return (*TracerConfigIndices)[0];
+	}
+	return -1;
+}
+
+bool UMnhTracerComponent::HasTracer(const FGameplayTag TracerTag) const
+{
+	return TracerConfigIndicesByTag.Contains(TracerTag) || TracerIndicesByTag.Contains(TracerTag);
+}
+
+void UMnhTracerComponent::RebuildTracerTagIndices()
+{
+	TracerIndicesByTag.Reset();
+	for (int TracerIdx = 0; TracerIdx < Tracers.Num(); TracerIdx++)
 	{
-		const auto& TracerConfig = TracerConfigs[Idx];
-		if (TracerConfig.TracerTag.MatchesTagExact(TracerTag))
+		if (const auto Tracer = Tracers[TracerIdx])
+		{
+			TracerIndicesByTag.FindOrAdd(Tracer->TracerTag).Add(TracerIdx);
+		}
+		else
 		{
-			return Idx;
+			FMnhHelpers::Mnh_Log("MissNoHit Warning: Null Tracer Found on actor: " + GetNameSafe(GetOwner()) + ", skipping...");
 		}
 	}
-	return -1;
+	
+	TracerConfigIndicesByTag.Reset();
+	for (int TracerConfigIdx = 0; TracerConfigIdx < TracerConfigs.Num(); TracerConfigIdx++)
+	{
+		TracerConfigIndicesByTag.FindOrAdd(TracerConfigs[TracerConfigIdx].TracerTag).Add(TracerConfigIdx);
+	}
+	TracerConfigsRevision++;
 }
 
 // Called when the game starts
 void UMnhTracerComponent::BeginPlay()
 {
 	Super::BeginPlay();
+
+	if (HitReplicationMode == EMnhHitReplicationMode::ClientReported && bValidateWithLagCompensation)
+	{
+		// Only created on servers
+		if (const auto LagCompensation = GetWorld()->GetSubsystem<UMnhLagCompensationSubsystem>())
+		{
+			LagCompensation->RegisterTracerComponent(this);
+		}
+	}
+	
+	if (!bAreTracersRegistered)
+	{
+		RegisterTracersBulk({this});
+	}
 	
+	bIsInitialized = true;
+	
+	for (const auto& [TracerTags, TracerSource] : EarlyTracerInitializations)
+	{
+		InitializeTracers(TracerTags, TracerSource);
+	}
+}
+
+void UMnhTracerComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (const auto LagCompensation = GetWorld()->GetSubsystem<UMnhLagCompensationSubsystem>())
+	{
+		LagCompensation->UnregisterTracerComponent(this);
+	}
+	Super::EndPlay(EndPlayReason);
+}
+
+void UMnhTracerComponent::RegisterTracersBulk(const TArray<UMnhTracerComponent*>& TracerComponents)
+{
+	LLM_SCOPE_BYTAG(MissNoHit_Registry);
+	// A component listed twice must be counted once, it is only registered once
+	TSet<UMnhTracerComponent*> ComponentsToRegister;
+	ComponentsToRegister.Reserve(TracerComponents.Num());
+	int NumTracersToRegister = 0;
+	for (const auto TracerComponent : TracerComponents)
+	{
+		bool bIsAlreadyInSet = false;
+		if (IsValid(TracerComponent) && !TracerComponent->bAreTracersRegistered)
+		{
+			ComponentsToRegister.Add(TracerComponent, &bIsAlreadyInSet);
+			if (!bIsAlreadyInSet)
+			{
+				NumTracersToRegister += TracerComponent->GetNumTracersToRegister();
+			}
+		}
+	}
+	if (NumTracersToRegister == 0)
+	{
+		return;
+	}
+
+	FMissNoHitModule& MnhModule = FMissNoHitModule::Get();
+	const int FirstTracerDataIdx = MnhModule.RequestNewTracerDataRange(NumTracersToRegister);
+	int NextTracerDataIdx = FirstTracerDataIdx;
+	for (const auto TracerComponent : ComponentsToRegister)
+	{
+		NextTracerDataIdx = TracerComponent->RegisterTracers(NextTracerDataIdx);
+	}
+	
+	const int NumUnusedTracerDatas = FirstTracerDataIdx + NumTracersToRegister - NextTracerDataIdx;
+	if (NumUnusedTracerDatas > 0)
+	{
+		MnhModule.ReturnTracerDataRange(NextTracerDataIdx, NumUnusedTracerDatas);
+	}
+}
+
+void UMnhTracerComponent::GetMemoryUsage(FMnhMemoryUsage& OutUsage) const
+{
+	OutUsage.Registry += TracerConfigs.GetAllocatedSize() + Tracers.GetAllocatedSize()
+		+ TracerConfigIndicesByTag.GetAllocatedSize() + TracerIndicesByTag.GetAllocatedSize()
+		+ TracerHitSubscriptions.GetAllocatedSize();
+	for (const auto& [TracerTag, TracerConfigIndices] : TracerConfigIndicesByTag)
+	{
+		OutUsage.Registry += TracerConfigIndices.GetAllocatedSize();
+	}
+	for (const auto& [TracerTag, TracerIndices] : TracerIndicesByTag)
+	{
+		OutUsage.Registry += TracerIndices.GetAllocatedSize();
+	}
+	OutUsage.HitCache += HitCache.GetAllocatedSize();
+	OutUsage.HitBuffers += PendingHitEvents.GetAllocatedSize() + DispatchingHitEvents.GetAllocatedSize()
+		+ PendingRetainedHitResults.GetAllocatedSize() + DispatchingRetainedHitResults.GetAllocatedSize();
+	for (const auto& RetainedHitResults : PendingRetainedHitResults)
+	{
+		OutUsage.HitBuffers += RetainedHitResults.GetAllocatedSize();
+	}
+}
+
+int UMnhTracerComponent::GetNumTracersToRegister() const
+{
+	int NumTracers = TracerConfigs.Num();
+	for (const auto& Tracer : Tracers)
+	{
+		if (Tracer)
+		{
+			NumTracers++;
+		}
+	}
+	return NumTracers;
+}
+
+int UMnhTracerComponent::RegisterTracers(const int FirstTracerDataIdx)
+{
+	int NextTracerDataIdx = FirstTracerDataIdx;
 	for (const auto& Tracer : Tracers)
 	{
 		if(!Tracer)
@@ -451,7 +659,7 @@ void UMnhTracerComponent::BeginPlay()
 			continue;
 		}
 		Tracer->OwnerComponent = this;
-		Tracer->RegisterTracerData();
+		Tracer->RegisterTracerDataAt(NextTracerDataIdx++);
 	}
 	
 	for (int TracerConfigIdx = 0; TracerConfigIdx < TracerConfigs.Num(); TracerConfigIdx++)
@@ -459,68 +667,261 @@ void UMnhTracerComponent::BeginPlay()
 		auto& TracerConfig = TracerConfigs[TracerConfigIdx];
 		TracerConfig.OwnerTracerConfigIdx = TracerConfigIdx;
 		TracerConfig.OwnerTracerComponent = this;
-		TracerConfig.RegisterTracerData();
-	}
-	
-	bIsInitialized = true;
-	
-	for (const auto& [TracerTags, TracerSource] : EarlyTracerInitializations)
-	{
-		InitializeTracers(TracerTags, TracerSource);
+		TracerConfig.RegisterTracerDataAt(NextTracerDataIdx++);
 	}
+	bAreTracersRegistered = true;
+	return NextTracerDataIdx;
 }
 
 bool UMnhTracerComponent::CheckFilters(const FHitResult& HitResult, const FGameplayTag TracerTag, int TickIdxArg)
 {
 	SCOPE_CYCLE_COUNTER(STAT_MNHCheckFilters);
 
-	if (HitCache.Num() > 2048)
+	if (HitCache.Num() > FMnhConsoleVariables::HitCacheCap)
 	{
 		HitCache.Reset();
 		const FString Message = FString::Printf(TEXT("MissNoHit Warning: Your Tracer Hit Cache"
-													 " contains over 2048 elements, it is very likely that you are not resetting"
+													 " contains over %d elements, it is very likely that you are not resetting"
 													 "your Hit Cache, this can lead to performance and memory leak problems!"
-													 " Please enable MissNoHit tracers only when they are needed"));
+													 " Please enable MissNoHit tracers only when they are needed"), FMnhConsoleVariables::HitCacheCap);
 		FMnhHelpers::Mnh_Log(Message);
 	}
 
-	for (auto& HitRecord : HitCache)
-    {
-        if (FilterType == EMnhFilterType::FilterSameActorPerTracer)
-        {
-        	if (HitRecord.TracerTag.MatchesTag(TracerTag) && HitRecord.HitResult.GetActor() == HitResult.GetActor())
-        	{
-        		return false;
-        	}
-        }
-        else if (FilterType == EMnhFilterType::FilterSameActorAcrossAllTracers)
-        {
-        	if (HitRecord.HitResult.GetActor() == HitResult.GetActor())
-        	{
-        		return false;
-        	}
-        }
-    }
-	
-	return true;
+	return FMnhCoreHitCache::PassesFilter(HitCache.GetData(), HitCache.Num(), EMnhCoreFilterType(FilterType),
+		FMnhCoreAdapter::GetObjectKey(HitResult.GetActor()), [TracerTag](const FMnhHitCache& HitRecord)
+		{
+			return HitRecord.TracerTag.MatchesTag(TracerTag);
+		});
 }
 
-void UMnhTracerComponent::OnTracerHitDetected(const FGameplayTag TracerTag, const TArray<FHitResult>& HitResults, const float DeltaTime, const int TickIdx)
+int32 UMnhTracerComponent::OnTracerHitDetected(const FGameplayTag TracerTag, const TArray<FHitResult>& HitResults, const float DeltaTime, const int TickIdx,
+	const bool bHitResultsOutliveFlush)
 {
 	SCOPE_CYCLE_COUNTER(STAT_MnhTracerComponentHitDetected)
-	FScopeLock ScopedLock(&TraceDoneScopeLock);
+	check(IsInGameThread());
 
+	const bool bBatchHits = OnHitsDetected.IsBound() || ShouldReplicateLocalHits();
+	TSharedPtr<FMnhOnTracerHitDetected> TracerHitSubscribers;
+	if (const auto Subscription = TracerHitSubscriptions.Find(TracerTag))
+	{
+		TracerHitSubscribers = *Subscription;
+	}
+	TSharedPtr<FMnhOnTracerHitDetected> AllTracerHitSubscribers;
+	if (const auto Subscription = TracerHitSubscriptions.Find(FGameplayTag::EmptyTag))
+	{
+		AllTracerHitSubscribers = *Subscription;
+	}
+	
+	TArray<FHitResult>* RetainedHitResults = nullptr;
+	if (bBatchHits)
+	{
+		LLM_SCOPE_BYTAG(MissNoHit_HitBuffers);
+		PendingHitEvents.Reserve(PendingHitEvents.Num() + HitResults.Num());
+		if (!bHitResultsOutliveFlush)
+		{
+			// Reserved up front so the copies never move while events point at them
+			RetainedHitResults = &PendingRetainedHitResults.AddDefaulted_GetRef();
+			RetainedHitResults->Reserve(HitResults.Num());
+		}
+	}
+	
+	int32 NumAcceptedHits = 0;
 	for (const auto& HitResult : HitResults)
 	{
-		if (FilterType == EMnhFilterType::None)
+		if (FilterType != EMnhFilterType::None)
 		{
-			OnHitDetected.Broadcast(TracerTag, HitResult, DeltaTime);
+			if (!CheckFilters(HitResult, TracerTag, TickIdx))
+			{
+				continue;
+			}
+			LLM_SCOPE_BYTAG(MissNoHit_HitCache);
+			HitCache.Add(FMnhHitCache{HitResult, TracerTag, TickIdx, FMnhCoreAdapter::GetObjectKey(HitResult.GetActor())});
 		}
-		else if(CheckFilters(HitResult, TracerTag, TickIdx))
+		NumAcceptedHits++;
+
+		if (bBatchHits)
+		{
+			const FHitResult* EventHitResult = RetainedHitResults ? &RetainedHitResults->Add_GetRef(HitResult) : &HitResult;
+			PendingHitEvents.Add(FMnhHitEvent{TracerTag, EventHitResult, DeltaTime});
+		}
+		if (OnHitDetected.IsBound())
 		{
-			HitCache.Add(FMnhHitCache{HitResult, TracerTag, TickIdx});
 			OnHitDetected.Broadcast(TracerTag, HitResult, DeltaTime);
 		}
+		if (TracerHitSubscribers.IsValid())
+		{
+			TracerHitSubscribers->Broadcast(TracerTag, HitResult, DeltaTime);
+		}
+		if (AllTracerHitSubscribers.IsValid())
+		{
+			AllTracerHitSubscribers->Broadcast(TracerTag, HitResult, DeltaTime);
+		}
+	}
+
+	if (PendingHitEvents.Num() > 0 && !bIsPendingHitEventsFlush)
+	{
+		bIsPendingHitEventsFlush = true;
+		FMissNoHitModule::Get().RequestHitEventsFlush(this);
+	}
+	return NumAcceptedHits;
+}
+
+void UMnhTracerComponent::FlushHitEvents()
+{
+	bIsPendingHitEventsFlush = false;
+	if (PendingHitEvents.Num() == 0)
+	{
+		return;
+	}
+
+	// Hits detected by listeners during the broadcast are collected into PendingHitEvents for the next flush
+	Swap(PendingHitEvents, DispatchingHitEvents);
+	Swap(PendingRetainedHitResults, DispatchingRetainedHitResults);
+	OnHitsDetected.Broadcast(this, DispatchingHitEvents);
+	if (ShouldReplicateLocalHits())
+	{
+		ReplicateHitEvents(DispatchingHitEvents);
+	}
+	DispatchingHitEvents.Reset();
+	DispatchingRetainedHitResults.Reset();
+}
+
+bool UMnhTracerComponent::ShouldReplicateLocalHits() const
+{
+	const AActor* Owner = GetOwner();
+	if (!Owner)
+	{
+		return false;
+	}
+	
+	switch (HitReplicationMode)
+	{
+	case EMnhHitReplicationMode::ServerAuthoritative:
+		return Owner->HasAuthority();
+	case EMnhHitReplicationMode::ClientReported:
+		// Remote players' swings may also be simulated here, only hits of the local player are reported
+		return Owner->HasLocalNetOwner();
+	default:
+		return false;
+	}
+}
+
+void UMnhTracerComponent::ReplicateHitEvents(const TConstArrayView<FMnhHitEvent> HitEvents)
+{
+	LLM_SCOPE_BYTAG(MissNoHit_HitBuffers);
+	const bool bHasAuthority = GetOwner()->HasAuthority();
+	FMnhReplicatedHitBatch HitBatch;
+	if (!bHasAuthority && bValidateWithLagCompensation)
+	{
+		const AGameStateBase* GameState = GetWorld()->GetGameState();
+		HitBatch.bIncludesTimestamp = true;
+		HitBatch.Timestamp = GameState ? GameState->GetServerWorldTimeSeconds() : GetWorld()->GetTimeSeconds();
+		HitBatch.FrameDeltaTime = uint16(FMath::Clamp(FMath::RoundToInt(GetWorld()->GetDeltaSeconds() * 10000.f), 0, MAX_uint16));
+	}
+	const auto SendHitBatch = [&]()
+	{
+		if (bHasAuthority)
+		{
+			MulticastConfirmedHits(HitBatch);
+		}
+		else
+		{
+			ServerReportHits(HitBatch);
+		}
+		HitBatch.Hits.Reset();
+	};
+	
+	for (const auto& HitEvent : HitEvents)
+	{
+		if (!HasTracer(HitEvent.TracerTag) || !HitEvent.GetHitResult().GetActor())
+		{
+			continue;
+		}
+		HitBatch.Hits.Add(FMnhReplicatedHitBatch::Pack(HitEvent));
+		if (HitBatch.Hits.Num() == FMnhReplicatedHitBatch::MaxHits)
+		{
+			SendHitBatch();
+		}
+	}
+	if (HitBatch.Hits.Num() > 0)
+	{
+		SendHitBatch();
+	}
+}
+
+bool UMnhTracerComponent::ServerReportHits_Validate(const FMnhReplicatedHitBatch& HitBatch)
+{
+	// Disconnects the client, only for batches no well behaved client sends
+	return HitBatch.Hits.Num() <= FMnhReplicatedHitBatch::MaxHits;
+}
+
+void UMnhTracerComponent::ServerReportHits_Implementation(const FMnhReplicatedHitBatch& HitBatch)
+{
+	// Mode may have been changed while the batch was in flight
+	if (HitReplicationMode != EMnhHitReplicationMode::ClientReported)
+	{
+		return;
+	}
+	
+	UMnhLagCompensationSubsystem* LagCompensation = nullptr;
+	if (!ValidateReplicatedHit.IsBound() && bValidateWithLagCompensation)
+	{
+		LagCompensation = GetWorld()->GetSubsystem<UMnhLagCompensationSubsystem>();
+		if (!LagCompensation || !HitBatch.bIncludesTimestamp)
+		{
+			return;
+		}
+	}
+	
+	FMnhReplicatedHitBatch ConfirmedHitBatch;
+	FHitResult HitResult;
+	float DeltaTime;
+	for (const auto& Hit : HitBatch.Hits)
+	{
+		const auto TracerTag = Hit.TracerTag;
+		if (!HasTracer(TracerTag) || !FMnhReplicatedHitBatch::Unpack(Hit, HitResult, DeltaTime))
+		{
+			continue;
+		}
+		if (ValidateReplicatedHit.IsBound() && !ValidateReplicatedHit.Execute(this, TracerTag, HitResult))
+		{
+			continue;
+		}
+		if (LagCompensation && !LagCompensation->ValidateHit(this, TracerTag, HitBatch.Timestamp, HitBatch.FrameDeltaTime / 10000.f,
+			HitResult.GetActor(), LagCompensationTolerance))
+		{
+			continue;
+		}
+		
+		ConfirmedHitBatch.Hits.Add(Hit);
+		OnReplicatedHitDetected.Broadcast(TracerTag, HitResult, DeltaTime);
+	}
+
+	if (ConfirmedHitBatch.Hits.Num() > 0)
+	{
+		MulticastConfirmedHits(ConfirmedHitBatch);
+	}
+}
+
+void UMnhTracerComponent::MulticastConfirmedHits_Implementation(const FMnhReplicatedHitBatch& HitBatch)
+{
+	const AActor* Owner = GetOwner();
+	// Server already dispatched these, reporting client detected them locally
+	if (!Owner || Owner->HasAuthority()
+		|| (HitReplicationMode == EMnhHitReplicationMode::ClientReported && Owner->HasLocalNetOwner()))
+	{
+		return;
+	}
+
+	FHitResult HitResult;
+	float DeltaTime;
+	for (const auto& Hit : HitBatch.Hits)
+	{
+		const auto TracerTag = Hit.TracerTag;
+		if (HasTracer(TracerTag) && FMnhReplicatedHitBatch::Unpack(Hit, HitResult, DeltaTime))
+		{
+			OnReplicatedHitDetected.Broadcast(TracerTag, HitResult, DeltaTime);
+		}
 	}
 }
 
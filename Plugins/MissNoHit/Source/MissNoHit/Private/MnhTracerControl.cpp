@@ -40,6 +40,8 @@ UMnhTracerControl* UMnhTracerControl::StartAllTracersEvent(UMnhTracerComponent*
 void UMnhTracerControl::Activate()
 {
 	Super::Activate();
+	// Nodes without tags keep listening to every tracer, including ones added after activation
+	SubscribedTracerTags = TracerTags;
 	if (TracerTags.Num() == 0)
 	{
 		if (!HitTracerComponent)
@@ -50,7 +52,7 @@ void UMnhTracerControl::Activate()
 		
 		for (const auto TracerConfig : HitTracerComponent->TracerConfigs)
 		{
-			if (TracerConfig.TraceSource != EMnhTraceSource::AnimNotify)
+			if (TracerConfig.GetTraceSource() != EMnhTraceSource::AnimNotify)
 			{
 				TracerTags.AddTag(TracerConfig.TracerTag);
 			}
@@ -69,7 +71,8 @@ void UMnhTracerControl::Activate()
 	{
 		HitTracerComponent->StartTracers(TracerTags, bResetHits);
 	}
-	HitTracerComponent->OnHitDetected.AddDynamic(this, &UMnhTracerControl::OnHitDetected);
+	HitSubscriptionHandle = HitTracerComponent->SubscribeToTracerHits(SubscribedTracerTags,
+		FMnhOnTracerHitDetected::FDelegate::CreateUObject(this, &UMnhTracerControl::OnHitDetected));
 	HitTracerComponent->OnDestroyed.AddDynamic(this, &UMnhTracerControl::OnComponentDestroyed);
 	
 	bIsActive = true;
@@ -79,11 +82,14 @@ void UMnhTracerControl::Activate()
 void UMnhTracerControl::StopEvent()
 {
 	bIsActive = false;
-	HitTracerComponent->OnHitDetected.RemoveDynamic(this, &UMnhTracerControl::OnHitDetected);
+	if (HitTracerComponent)
+	{
+		HitTracerComponent->UnsubscribeFromTracerHits(SubscribedTracerTags, HitSubscriptionHandle);
+	}
 	SetReadyToDestroy();
 }
 
-void UMnhTracerControl::OnHitDetected(FGameplayTag TracerTag, FHitResult HitResult, float DeltaTime)
+void UMnhTracerControl::OnHitDetected(const FGameplayTag TracerTag, const FHitResult& HitResult, const float DeltaTime)
 {
 	SCOPE_CYCLE_COUNTER(STAT_MnhTracerHitDetectedAsyncNode)
 	if (bIsActive)
@@ -0,0 +1,46 @@
+﻿// Copyright 2024 Eren Balatkan. All Rights Reserved.
+
+#include "MnhTracerDefinition.h"
+
+TMultiMap<uint32, TWeakObjectPtr<UMnhTracerDefinition>> UMnhTracerDefinition::SharedTransientDefinitions;
+
+void UMnhTracerDefinition::PostInitProperties()
+{
+	Super::PostInitProperties();
+	// Assets created in the editor or at runtime are never loaded
+	UpdateDerivedData();
+}
+
+void UMnhTracerDefinition::PostLoad()
+{
+	Super::PostLoad();
+	UpdateDerivedData();
+}
+
+#if WITH_EDITOR
+void UMnhTracerDefinition::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+	UpdateDerivedData();
+}
+#endif
+
+void UMnhTracerDefinition::UpdateDerivedData()
+{
+	// Clamped so values typed in as zero never make the tracer tick without an interval
+	TickInterval = 0;
+	if (TracerTickType == EMnhTracerTickType::DistanceTick)
+	{
+		TickInterval = FMath::Max(TickDistanceTraveled, 1);
+	}
+	else if (TracerTickType == EMnhTracerTickType::FixedRateTick)
+	{
+		TickInterval = 1.0f/float(FMath::Max(TargetFps, 1));
+	}
+
+	ObjectQueryParams = FCollisionObjectQueryParams();
+	for (const auto& ObjectType : TraceSettings.ObjectTypes)
+	{
+		ObjectQueryParams.AddObjectTypesToQuery(ObjectType);
+	}
+}
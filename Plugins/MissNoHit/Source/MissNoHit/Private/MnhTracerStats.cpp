@@ -0,0 +1,133 @@
+﻿// Copyright 2024 Eren Balatkan. All Rights Reserved.
+
+#include "MnhTracerStats.h"
+
+#include "Misc/OutputDeviceRedirector.h"
+
+CSV_DEFINE_CATEGORY(MissNoHit, true);
+
+void FMnhTracerStatsEntry::EndFrame()
+{
+	LastFrame.NumTicks = NumTicks.exchange(0, std::memory_order_relaxed);
+	LastFrame.NumSweeps = NumSweeps.exchange(0, std::memory_order_relaxed);
+	LastFrame.NumHits = NumHits.exchange(0, std::memory_order_relaxed);
+	LastFrame.NumFilteredHits = NumFilteredHits.exchange(0, std::memory_order_relaxed);
+	LastFrame.SweepCycles = SweepCycles.exchange(0, std::memory_order_relaxed);
+	LastFrame.ActiveTime = ActiveTimeMicroseconds.exchange(0, std::memory_order_relaxed) / 1000000.0;
+	Totals.Add(LastFrame);
+}
+
+FMnhTracerStats& FMnhTracerStats::Get()
+{
+	static FMnhTracerStats Instance;
+	return Instance;
+}
+
+FMnhTracerStatsEntry* FMnhTracerStats::FindOrAddEntry(const FMnhTracerStatsKey& Key)
+{
+	check(IsInGameThread());
+	if (const auto Entry = Entries.Find(Key))
+	{
+		return Entry->Get();
+	}
+
+	LLM_SCOPE_BYTAG(MissNoHit_Debug);
+
+	auto Entry = MakeUnique<FMnhTracerStatsEntry>();
+	Entry->Key = Key;
+#if CSV_PROFILER
+	const FString StatPrefix = FString::Printf(TEXT("%s/%s"), *Key.TracerTag.ToString(), *Key.OwnerClass.ToString());
+	Entry->CsvSweepTimeStatName = FName(StatPrefix + TEXT("/SweepUs"));
+	Entry->CsvSweepsStatName = FName(StatPrefix + TEXT("/Sweeps"));
+#endif
+	return Entries.Add(Key, MoveTemp(Entry)).Get();
+}
+
+void FMnhTracerStats::EndFrame(const int32 NumActiveTracers)
+{
+	FMnhTracerCounters FrameCounters;
+	for (const auto& [Key, Entry] : Entries)
+	{
+		Entry->EndFrame();
+		FrameCounters.Add(Entry->LastFrame);
+
+#if CSV_PROFILER
+		if (Entry->LastFrame.NumTicks > 0)
+		{
+			FCsvProfiler::RecordCustomStat(Entry->CsvSweepTimeStatName, CSV_CATEGORY_INDEX(MissNoHit),
+				float(Entry->LastFrame.GetSweepMicroseconds()), ECsvCustomStatOp::Set);
+			FCsvProfiler::RecordCustomStat(Entry->CsvSweepsStatName, CSV_CATEGORY_INDEX(MissNoHit),
+				int32(Entry->LastFrame.NumSweeps), ECsvCustomStatOp::Set);
+		}
+#endif
+	}
+
+	SET_DWORD_STAT(STAT_MnhActiveTracers, NumActiveTracers);
+	SET_DWORD_STAT(STAT_MnhTickedTracers, FrameCounters.NumTicks);
+	SET_DWORD_STAT(STAT_MnhSweeps, FrameCounters.NumSweeps);
+	SET_DWORD_STAT(STAT_MnhHitsReturned, FrameCounters.NumHits);
+	SET_DWORD_STAT(STAT_MnhHitsFiltered, FrameCounters.NumFilteredHits);
+
+	CSV_CUSTOM_STAT(MissNoHit, ActiveTracers, NumActiveTracers, ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(MissNoHit, Sweeps, int32(FrameCounters.NumSweeps), ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(MissNoHit, HitsReturned, int32(FrameCounters.NumHits), ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(MissNoHit, HitsFiltered, int32(FrameCounters.NumFilteredHits), ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(MissNoHit, SweepUs, float(FrameCounters.GetSweepMicroseconds()), ECsvCustomStatOp::Set);
+}
+
+void FMnhTracerStats::Dump(FOutputDevice& Ar) const
+{
+	TArray<const FMnhTracerStatsEntry*> SortedEntries;
+	for (const auto& [Key, Entry] : Entries)
+	{
+		SortedEntries.Add(Entry.Get());
+	}
+	SortedEntries.Sort([](const FMnhTracerStatsEntry& A, const FMnhTracerStatsEntry& B)
+	{
+		return A.Totals.SweepCycles > B.Totals.SweepCycles;
+	});
+
+	Ar.Logf(TEXT("MissNoHit tracer stats, sorted by sweep time"));
+	Ar.Logf(TEXT("%-40s %-32s %-14s %12s %10s %10s %10s %10s %12s %10s"),
+		TEXT("Tag"), TEXT("Owner Class"), TEXT("Tick Type"), TEXT("Sweep ms"), TEXT("Us/Sweep"),
+		TEXT("Ticks"), TEXT("Sweeps"), TEXT("Hits"), TEXT("Filtered"), TEXT("Active s"));
+	for (const auto Entry : SortedEntries)
+	{
+		const auto& Totals = Entry->Totals;
+		const double SweepMicroseconds = Totals.GetSweepMicroseconds();
+		Ar.Logf(TEXT("%-40s %-32s %-14s %12.3f %10.2f %10llu %10llu %10llu %12llu %10.2f"),
+			*Entry->Key.TracerTag.ToString(), *Entry->Key.OwnerClass.ToString(),
+			*UEnum::GetDisplayValueAsText(Entry->Key.TracerTickType).ToString(),
+			SweepMicroseconds / 1000.0, Totals.NumSweeps > 0 ? SweepMicroseconds / Totals.NumSweeps : 0.0,
+			Totals.NumTicks, Totals.NumSweeps, Totals.NumHits, Totals.NumFilteredHits, Totals.ActiveTime);
+	}
+}
+
+SIZE_T FMnhTracerStats::GetAllocatedSize() const
+{
+	return Entries.GetAllocatedSize() + Entries.Num() * sizeof(FMnhTracerStatsEntry);
+}
+
+void FMnhTracerStats::ResetTotals()
+{
+	for (const auto& [Key, Entry] : Entries)
+	{
+		Entry->Totals = FMnhTracerCounters();
+	}
+}
+
+static FAutoConsoleCommandWithOutputDevice MnhStatsDumpCommand(
+	TEXT("MissNoHit.Stats.Dump"),
+	TEXT("Prints MissNoHit tracer counters per tag, owner class and tick type, most expensive first"),
+	FConsoleCommandWithOutputDeviceDelegate::CreateLambda([](FOutputDevice& Ar)
+	{
+		FMnhTracerStats::Get().Dump(Ar);
+	}));
+
+static FAutoConsoleCommand MnhStatsResetCommand(
+	TEXT("MissNoHit.Stats.Reset"),
+	TEXT("Resets MissNoHit tracer counters"),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		FMnhTracerStats::Get().ResetTotals();
+	}));
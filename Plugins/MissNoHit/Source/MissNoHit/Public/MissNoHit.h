@@ -5,10 +5,18 @@
 #include "Modules/ModuleManager.h"
 #include "Tickable.h"
 #include "Engine/HitResult.h"
+#include "Containers/MpscQueue.h"
+#include "UObject/ObjectKey.h"
+#include "MnhTracerCommands.h"
+#include <atomic>
 #include "MissNoHit.generated.h"
 
 struct FMnhTracerData;
+struct FMnhAnimationPoseSource;
+class FMnhCaptureRecorder;
+class FMnhDebugDrawBatcher;
 class UMnhTracer;
+class UMnhTracerComponent;
 
 USTRUCT()
 struct FMnhMultiTraceResultContainer
@@ -22,14 +30,79 @@ public:
 	TArray<FHitResult> HitResults;
 };
 
+/**
+ * Lock-free multi producer, single consumer queue with a fixed capacity.
+ * Producers push from worker threads, consumer drains after all producers are done.
+ */
+template <typename ElementType>
+class TMnhBoundedMpscQueue
+{
+public:
+	void Reset(const int32 Capacity)
+	{
+		Elements.SetNumUninitialized(Capacity, EAllowShrinking::No);
+		NumElements.store(0, std::memory_order_relaxed);
+	}
+	
+	bool Enqueue(const ElementType& Element)
+	{
+		const int32 ElementIdx = NumElements.fetch_add(1, std::memory_order_relaxed);
+		if (ElementIdx >= Elements.Num())
+		{
+			return false;
+		}
+		Elements[ElementIdx] = Element;
+		return true;
+	}
+
+	TArrayView<ElementType> Drain()
+	{
+		const int32 Count = FMath::Min(NumElements.exchange(0, std::memory_order_acquire), Elements.Num());
+		return TArrayView<ElementType>(Elements.GetData(), Count);
+	}
+
+	/* Pushes since the last drain, including the ones that did not fit */
+	int32 GetNumRequested() const { return NumElements.load(std::memory_order_relaxed); }
+	SIZE_T GetAllocatedSize() const { return Elements.GetAllocatedSize(); }
+	int32 GetCapacity() const { return Elements.Num(); }
+
+private:
+	TArray<ElementType> Elements;
+	std::atomic<int32> NumElements = 0;
+};
+
+/* Wall time of each phase of a module tick, in seconds */
+struct FMnhTickTimings
+{
+	double ApplyTracerCommands = 0;
+	double UpdateTracerTransforms = 0;
+	double PerformTraces = 0;
+	// Zero unless a capture is running
+	double Capture = 0;
+	double NotifyTraceResults = 0;
+	double FlushHitEvents = 0;
+	double Total = 0;
+};
+
 class FMissNoHitModule : public IModuleInterface, public FTickableGameObject
 {
 public:
 	/** IModuleInterface implementation */
 	virtual void StartupModule() override;
 	virtual void ShutdownModule() override;
+	virtual ~FMissNoHitModule() override;
 	virtual bool IsGameModule() const override { return true; }
 	
+	/* Cached module lookup, avoids going through the module manager on hot paths */
+	FORCEINLINE static FMissNoHitModule& Get()
+	{
+		if (UNLIKELY(!Instance))
+		{
+			Instance = &FModuleManager::LoadModuleChecked<FMissNoHitModule>("MissNoHit");
+		}
+		return *Instance;
+	}
+	
 	//FTickableGameObject implementation
 	virtual void Tick(float DeltaTime) override;
 	virtual bool IsTickable() const override { return true; }
@@ -38,19 +111,80 @@ public:
 	virtual UWorld* GetTickableGameObjectWorld() const override;
 	virtual TStatId GetStatId() const override { return TStatId(); }
 
-	FCriticalSection CriticalSection;
 	FMnhTracerData& GetTracerDataAt(int Index);
 
+	/* Recycles a pooled tracer data slot when one is available, game thread only */
 	int RequestNewTracerData();
+	/* Reserves Count contiguous tracer data slots at once, returns the index of the first one */
+	int RequestNewTracerDataRange(int32 Count);
+	/* Hands back the unused tail of the last reserved range */
+	void ReturnTracerDataRange(int FirstTracerDataIdx, int32 Count);
+	FGuid NewTracerDataGuid();
 	void MarkTracerDataForRemoval(int TracerDataIdx, FGuid Guid);
 
+	/* Safe to call from any thread, calls from outside the game thread are queued and applied at the start of the next tick */
+	void ChangeTracerState(int TracerDataIdx, FGuid Guid, bool bIsTracerActive, bool bStopImmediate=true);
+	void UpdateTracerData(int TracerDataIdx, FGuid Guid, const FMnhTracerDataChangeSet& Changes);
+	void AddIgnoredActor(const TSharedRef<FMnhIgnoreSet>& IgnoreSet, const AActor* Actor);
+	void RemoveIgnoredActor(const TSharedRef<FMnhIgnoreSet>& IgnoreSet, const AActor* Actor);
+	void EnqueueTracerCommand(FMnhTracerCommand&& Command);
+
+	/* Makes sure NumTracerDatas slots can be registered without allocating, e.g. before spawning a wave of pooled enemies */
+	void WarmUpTracerDataPool(int32 NumTracerDatas, int32 SubstepsPerTracer=1, int32 HitsPerSubstep=8);
+	int32 GetNumActiveTracerDatas() const { return NumActiveTracerDatas; }
+	TConstArrayView<FMnhTracerData> GetActiveTracerDatas() const { return MakeArrayView(TracerDatas.GetData(), NumActiveTracerDatas); }
+	const FMnhTickTimings& GetLastTickTimings() const { return LastTickTimings; }
+	/* Tracer data pool including the hit buffers of every slot */
+	SIZE_T GetAllocatedSize() const;
+	/* Prints MissNoHit memory per component class and per world, see MissNoHit.MemReport */
+	void DumpMemReport(FOutputDevice& Ar) const;
+	void RequestHitEventsFlush(UMnhTracerComponent* TracerComponent);
+
+	/* Records every frame's tracer transforms, tick decisions and sweep hits, see MnhCapture.h */
+	bool StartCapture(const FString& FilePath);
+	void StopCapture();
+	bool IsCapturing() const { return CaptureRecorder.IsValid(); }
+
+	/* Debug shapes of every tracer are collected here and drawn once per tick */
+	FMnhDebugDrawBatcher& GetDebugDrawBatcher() const { return *DebugDrawBatcher; }
+
 private:
+	inline static FMissNoHitModule* Instance = nullptr;
+	
+	// Slots in [0, NumActiveTracerDatas) are in use, the rest are pooled and keep their buffers
 	TArray<FMnhTracerData> TracerDatas;
+	int32 NumActiveTracerDatas = 0;
+	uint64 TracerDataSerial = 0;
+	// Pool growth past MissNoHit.InitialTracerPoolSize is reported once per module startup
+	bool bWarnedTracerPoolGrowth = false;
+	TArray<TWeakObjectPtr<UMnhTracerComponent>> PendingHitEventsFlushes;
 	bool RemovalLock = false;
 	uint32 TickIdx = 0;
+	FMnhTickTimings LastTickTimings;
 	void RemoveTracerDataAt(int TracerDataIdx, FGuid Guid);
+	FMnhTracerData* FindTracerData(int TracerDataIdx, const FGuid& Guid);
+
+	TMpscQueue<FMnhTracerCommand> TracerCommands;
+	void ApplyTracerCommands();
+	void ApplyTracerCommand(FMnhTracerCommand& Command);
 
 	void UpdateTracerTransforms(const float DeltaTime);
 	void PerformTraces(const float DeltaTime);
 	void NotifyTraceResults();
+	void DispatchTracerHits(int32 TracerDataIdx);
+	void FlushHitEvents();
+
+	TMnhBoundedMpscQueue<int32> TracersWithHitsQueue;
+
+	// AnimationFinalized tracers found without a pose source of their current source component, e.g. after a tick type override
+	TMnhBoundedMpscQueue<int32> TracersWithoutPoseSourceQueue;
+	// Started or re-attached tracers, bound on the game thread before the workers look for their pose
+	TArray<TPair<int32, FGuid>> PendingPoseSourceBinds;
+	TMap<TObjectKey<UPrimitiveComponent>, TSharedRef<FMnhAnimationPoseSource>> AnimationPoseSources;
+	void BindAnimationPoseSources();
+	/* Drops the tracer's reference, the pose source is released when no other tracer uses it */
+	void DetachAnimationPoseSource(FMnhTracerData& TracerData);
+	void ReleaseAnimationPoseSource(FMnhAnimationPoseSource& PoseSource);
+	TUniquePtr<FMnhCaptureRecorder> CaptureRecorder;
+	TUniquePtr<FMnhDebugDrawBatcher> DebugDrawBatcher;
 };
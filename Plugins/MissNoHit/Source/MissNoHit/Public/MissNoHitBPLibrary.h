@@ -10,4 +10,8 @@ UCLASS()
 class UMissNoHitBPLibrary : public UBlueprintFunctionLibrary
 {
 	GENERATED_UCLASS_BODY()
+
+	/* Pre-allocates tracer slots and hit buffers so registering that many tracers later does not allocate */
+	UFUNCTION(BlueprintCallable, Category="MissNoHit")
+	static void WarmUpTracerPool(int32 TracerCount, int32 SubstepsPerTracer=1, int32 HitsPerSubstep=8);
 };
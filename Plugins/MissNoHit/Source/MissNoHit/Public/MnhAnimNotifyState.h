@@ -8,9 +8,40 @@
 #include "Animation/AnimNotifies/AnimNotifyState.h"
 #include "Components/SkeletalMeshComponent.h"
 #include "Runtime/Launch/Resources/Version.h"
+#include "Subsystems/WorldSubsystem.h"
 #include "MnhAnimNotifyState.generated.h"
 
 class UMnhTracerComponent;
+
+struct FMnhAnimNotifyBinding
+{
+	TWeakObjectPtr<UMnhTracerComponent> TracerComponent;
+	uint32 TracerConfigsRevision = 0;
+	TMap<FGameplayTag, int> TracerConfigIndices;
+};
+
+/**
+ * Caches the tracer component of every skeletal mesh playing MissNoHit notifies.
+ * Kept per world so PIE instances and editor previews never share or invalidate each other's bindings, game thread only.
+ */
+UCLASS()
+class MISSNOHIT_API UMnhAnimNotifyBindingSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	FMnhAnimNotifyBinding& FindOrResolveBinding(const USkeletalMeshComponent* MeshComp);
+	void InvalidateBindings(const AActor* Owner);
+
+private:
+	/* Removes bindings of destroyed meshes */
+	void PruneStaleBindings();
+	
+	// Notify instances are shared between every mesh playing the animation, so bindings are cached per mesh
+	TMap<TObjectKey<USkeletalMeshComponent>, FMnhAnimNotifyBinding> Bindings;
+	int32 NumBindingsAfterPrune = 0;
+};
+
 /**
  * 
  */
@@ -22,6 +53,13 @@ class MISSNOHIT_API UMnhAnimNotifyState : public UAnimNotifyState
 public:
 	FORCEINLINE static UMnhTracerComponent* FindMnhTracerComponent(const USkeletalMeshComponent* MeshComp);
 	FORCEINLINE static int FindTracerConfigIdx(const USkeletalMeshComponent* MeshComp, const FGameplayTag TracerTag);
+
+	/* Drops cached bindings of the Owner's skeletal meshes, called whenever a tracer component is added to or removed from it */
+	static void InvalidateBindings(const AActor* Owner);
+
+private:
+	/* Null when the mesh is not in a world */
+	static FMnhAnimNotifyBinding* FindOrResolveBinding(const USkeletalMeshComponent* MeshComp);
 };
 
 
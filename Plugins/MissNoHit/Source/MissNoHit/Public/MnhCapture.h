@@ -0,0 +1,183 @@
+﻿// Copyright 2024 Eren Balatkan. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MnhTracer.h"
+#include "UObject/StrongObjectPtr.h"
+
+class IFileHandle;
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/*
+ * MissNoHit capture file layout, every field is little endian and 4 byte aligned:
+ * FMnhCaptureFileHeader followed by chunks, each chunk is a FMnhCaptureChunkHeader and Size bytes of payload.
+ * Chunks are only ever appended, a capture cut short by a crash is valid up to its last complete chunk.
+ *
+ * Tracer chunk: FMnhCaptureTracerRecord, then Definition path, Profile name and Owner actor name as length prefixed
+ * UTF-8 strings, then a uint32 count and that many ignored actor names. A tracer chunk is written again with the same
+ * TracerKey whenever the tracer's settings or ignored actors change, it replaces the previous one from that point on.
+ * Frame chunk: FMnhCaptureFrameRecord, then NumTracers times a FMnhCaptureTracerFrameRecord that is followed by
+ * its two transforms when it ticked, and by NumHits FMnhCaptureHitRecord.
+ */
+namespace MnhCapture
+{
+	constexpr uint32 Magic = 0x43484E4D; // MNHC
+	constexpr uint32 Version = 2;
+
+	enum class EChunkType : uint32
+	{
+		Tracer = 1,
+		Frame = 2
+	};
+}
+
+struct FMnhCaptureFileHeader
+{
+	uint32 Magic = MnhCapture::Magic;
+	uint32 Version = MnhCapture::Version;
+};
+
+struct FMnhCaptureChunkHeader
+{
+	MnhCapture::EChunkType Type;
+	uint32 Size;
+};
+
+/* Settings needed to rebuild a tracer, written the first time the tracer is seen and whenever they change */
+struct FMnhCaptureTracerRecord
+{
+	uint32 TracerKey = 0;
+	uint8 TracerTickType = 0;
+	uint8 TraceShape = 0;
+	uint8 TraceType = 0;
+	uint8 bTraceComplex = 0;
+	uint8 TraceChannel = 0;
+	uint8 HitSelectionRule = 0;
+	uint8 Pad[2] = {};
+	uint32 ObjectTypesMask = 0;
+	float TickInterval = 0;
+	float ShapeOffset[3] = {};
+	float Radius = 0;
+	float HalfHeight = 0;
+	float HalfSize[3] = {};
+	float Orientation[3] = {};
+};
+
+struct FMnhCaptureFrameRecord
+{
+	uint32 TickIdx = 0;
+	float DeltaTime = 0;
+	uint32 NumTracers = 0;
+};
+
+struct FMnhCaptureTransform
+{
+	float Location[3];
+	float Rotation[4];
+	float Scale[3];
+};
+
+struct FMnhCaptureTracerFrameRecord
+{
+	uint32 TracerKey = 0;
+	uint8 bTicked = 0;
+	uint8 TracerState = 0;
+	uint8 Substeps = 0;
+	uint8 Pad = 0;
+	uint32 NumHits = 0;
+};
+
+struct FMnhCaptureHitRecord
+{
+	// CRC of the hit actor name, 0 when the hit has no actor
+	uint32 ActorNameHash = 0;
+	uint32 SubstepIdx = 0;
+	float ImpactPoint[3] = {};
+};
+
+/* Streams the tracer pipeline of the module to a capture file */
+class MISSNOHIT_API FMnhCaptureRecorder
+{
+public:
+	~FMnhCaptureRecorder();
+
+	bool Open(const FString& FilePath);
+	void Close();
+	/* Called after sweeps are done and before results are dispatched, so transforms and sweep hits are still intact */
+	void RecordFrame(uint32 TickIdx, float DeltaTime, TConstArrayView<FMnhTracerData> TracerDatas);
+	SIZE_T GetAllocatedSize() const { return Buffer.GetAllocatedSize() + RecordedTracers.GetAllocatedSize(); }
+
+private:
+	/* Last tracer chunk written for a tracer, compared against every frame to catch runtime changes */
+	struct FRecordedTracer
+	{
+		uint32 TracerKey = 0;
+		FMnhCaptureTracerRecord Record;
+		const UMnhTracerDefinition* Definition = nullptr;
+		FName ProfileName;
+		const FMnhIgnoreSet* IgnoreSet = nullptr;
+		uint32 IgnoreSetRevision = 0;
+	};
+
+	TUniquePtr<IFileHandle> File;
+	TArray<uint8> Buffer;
+	TMap<FGuid, FRecordedTracer> RecordedTracers;
+
+	void WriteTracer(const FMnhCaptureTracerRecord& Record, const FMnhTracerData& TracerData);
+	void WriteChunkHeader(MnhCapture::EChunkType Type, int32& OutChunkOffset);
+	void FinishChunk(int32 ChunkOffset);
+	void WriteString(const FString& String);
+	template <typename RecordType>
+	void Write(const RecordType& Record)
+	{
+		Buffer.Append(reinterpret_cast<const uint8*>(&Record), sizeof(RecordType));
+	}
+	void Flush();
+};
+
+struct FMnhCaptureReplayStats
+{
+	int32 NumFrames = 0;
+	int32 NumTracers = 0;
+	int64 NumSweeps = 0;
+	int64 NumRecordedHits = 0;
+	int64 NumReplayedHits = 0;
+	// Hits on the same actor in the same substep as the recording
+	int64 NumMatchedHits = 0;
+	double TraceSeconds = 0;
+	double TotalSeconds = 0;
+};
+
+/**
+ * Feeds recorded transforms and tick decisions back into tracer sweeps, as fast as the sweeps can run.
+ * Replays against the given world, which should have the captured level loaded. Targets are matched by actor name,
+ * actors spawned at runtime only match if they are spawned in the same order.
+ */
+class MISSNOHIT_API FMnhCapturePlayer
+{
+public:
+	~FMnhCapturePlayer();
+
+	bool Open(const FString& FilePath);
+	bool Replay(UWorld* World, FMnhCaptureReplayStats& OutStats);
+	/* Tracers rebuilt by the last replay, in the order they were first recorded */
+	TConstArrayView<FMnhTracerData> GetTracers() const { return Tracers; }
+
+private:
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+	// Used when the platform can not map files
+	TArray<uint8> FileData;
+	TConstArrayView<uint8> Data;
+
+	TArray<FMnhTracerData> Tracers;
+	TMap<uint32, int32> TracerIndicesByKey;
+	TArray<TStrongObjectPtr<UMnhTracerDefinition>> Definitions;
+	// Actors of the replay world, ignored actors are recorded by name
+	TMap<FName, AActor*> ActorsByName;
+
+	bool ReadTracer(TConstArrayView<uint8> Payload, UWorld* World);
+	bool ReplayFrame(TConstArrayView<uint8> Payload, FMnhCaptureReplayStats& OutStats);
+};
@@ -0,0 +1,39 @@
+﻿// Copyright 2024 Eren Balatkan. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MnhHelpers.h"
+#include "Async/ParallelFor.h"
+
+/**
+ * Runtime tuning of the tracer pipeline, every value is a console variable and can be set per platform from a device profile:
+ *   [Console_Low DeviceProfile]
+ *   +CVars=MissNoHit.MaxSubsteps=4
+ *   +CVars=MissNoHit.TraceRateScale=0.5
+ * Read from worker threads without synchronization, changes are picked up by the next tick.
+ */
+struct MISSNOHIT_API FMnhConsoleVariables
+{
+	/* Cap on the sweeps a tracer splits one tick into */
+	static int32 MaxSubsteps;
+	/* Tracer data slots reserved at startup, not a limit: the pool grows past it and a warning is logged once */
+	static int32 InitialTracerPoolSize;
+	/* Hit cache records a Tracer Component keeps before the cache is reset */
+	static int32 HitCacheCap;
+	/* Minimum number of tracers a ParallelFor task processes */
+	static int32 ParallelBatchSize;
+	/* Tracer counts below this are updated and swept on the game thread */
+	static int32 ParallelSerialThreshold;
+	static bool bDebugDraw;
+	/* -1 keeps the tick type of each tracer, otherwise an EMnhTracerTickType value applied to every tracer */
+	static int32 TickTypeOverride;
+	static int32 TickTypeOverrideTargetFps;
+	static int32 TickTypeOverrideTickDistance;
+	/* Multiplies the tick rate of FixedRateTick and DistanceTick tracers */
+	static float TraceRateScale;
+
+	/* Tick type and interval the module schedules the tracer with after the override and rate scaling */
+	static void GetTickSchedule(EMnhTracerTickType TracerTickType, float TickInterval, EMnhCoreTickType& OutTickType, float& OutTickInterval);
+	static EParallelForFlags GetParallelForFlags(int32 Num);
+};
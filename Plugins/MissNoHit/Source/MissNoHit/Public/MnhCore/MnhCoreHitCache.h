@@ -0,0 +1,67 @@
+﻿// Copyright 2024 Eren Balatkan. All Rights Reserved.
+
+#pragma once
+
+#include "MnhCoreMath.h"
+
+/* Mirrors EMnhFilterType, values are checked in MnhCoreAdapter.h */
+enum class EMnhCoreFilterType : uint8_t
+{
+	FilterSameActorAcrossAllTracers,
+	FilterSameActorPerTracer,
+	None
+};
+
+/**
+ * Hit cache kernels, records only need an ActorKey member. Tracer tags stay opaque to the core,
+ * callers pass a predicate telling whether a record belongs to the tracer being filtered.
+ */
+struct FMnhCoreHitCache
+{
+	/* Whether a hit on ActorKey should be reported, false if a cached record already covers it */
+	template <typename RecordType, typename RecordMatchesTracerFunc>
+	MNH_CORE_INLINE static bool PassesFilter(const RecordType* Records, const int32_t NumRecords, const EMnhCoreFilterType FilterType,
+		const uint64_t ActorKey, RecordMatchesTracerFunc&& RecordMatchesTracer)
+	{
+		if (FilterType == EMnhCoreFilterType::FilterSameActorAcrossAllTracers)
+		{
+			for (int32_t RecordIdx = 0; RecordIdx < NumRecords; RecordIdx++)
+			{
+				if (Records[RecordIdx].ActorKey == ActorKey)
+				{
+					return false;
+				}
+			}
+		}
+		else if (FilterType == EMnhCoreFilterType::FilterSameActorPerTracer)
+		{
+			for (int32_t RecordIdx = 0; RecordIdx < NumRecords; RecordIdx++)
+			{
+				if (Records[RecordIdx].ActorKey == ActorKey && RecordMatchesTracer(Records[RecordIdx]))
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	/* Removes matching records in place keeping the order of the rest, returns the new record count */
+	template <typename RecordType, typename ShouldRemoveFunc>
+	MNH_CORE_INLINE static int32_t RemoveRecords(RecordType* Records, const int32_t NumRecords, ShouldRemoveFunc&& ShouldRemove)
+	{
+		int32_t NumKept = 0;
+		for (int32_t RecordIdx = 0; RecordIdx < NumRecords; RecordIdx++)
+		{
+			if (!ShouldRemove(Records[RecordIdx]))
+			{
+				if (NumKept != RecordIdx)
+				{
+					Records[NumKept] = static_cast<RecordType&&>(Records[RecordIdx]);
+				}
+				NumKept++;
+			}
+		}
+		return NumKept;
+	}
+};
@@ -0,0 +1,157 @@
+﻿// Copyright 2024 Eren Balatkan. All Rights Reserved.
+
+#pragma once
+
+/**
+ * Engine independent math used by the MissNoHit core kernels. Only the standard library is included so the core
+ * builds with plain g++/clang through Plugins/MissNoHit/Tests/MnhCore, MnhCoreAdapter.h converts to engine types.
+ * Conventions follow the engine: doubles, Hamilton quaternions, scale applied before rotation and translation.
+ */
+
+#include <cmath>
+#include <cstdint>
+
+#if defined(FORCEINLINE)
+#define MNH_CORE_INLINE FORCEINLINE
+#else
+#define MNH_CORE_INLINE inline
+#endif
+
+struct FMnhCoreVector
+{
+	double X = 0;
+	double Y = 0;
+	double Z = 0;
+
+	constexpr FMnhCoreVector() = default;
+	constexpr FMnhCoreVector(const double InX, const double InY, const double InZ) : X(InX), Y(InY), Z(InZ) {}
+
+	MNH_CORE_INLINE FMnhCoreVector operator+(const FMnhCoreVector& V) const { return {X + V.X, Y + V.Y, Z + V.Z}; }
+	MNH_CORE_INLINE FMnhCoreVector operator-(const FMnhCoreVector& V) const { return {X - V.X, Y - V.Y, Z - V.Z}; }
+	MNH_CORE_INLINE FMnhCoreVector operator*(const double Scale) const { return {X * Scale, Y * Scale, Z * Scale}; }
+	MNH_CORE_INLINE FMnhCoreVector operator/(const double Scale) const { return {X / Scale, Y / Scale, Z / Scale}; }
+	MNH_CORE_INLINE FMnhCoreVector operator-() const { return {-X, -Y, -Z}; }
+
+	MNH_CORE_INLINE static double Dot(const FMnhCoreVector& A, const FMnhCoreVector& B) { return A.X * B.X + A.Y * B.Y + A.Z * B.Z; }
+	MNH_CORE_INLINE static FMnhCoreVector Cross(const FMnhCoreVector& A, const FMnhCoreVector& B)
+	{
+		return {A.Y * B.Z - A.Z * B.Y, A.Z * B.X - A.X * B.Z, A.X * B.Y - A.Y * B.X};
+	}
+	MNH_CORE_INLINE static FMnhCoreVector Lerp(const FMnhCoreVector& A, const FMnhCoreVector& B, const double Alpha)
+	{
+		return A + (B - A) * Alpha;
+	}
+
+	MNH_CORE_INLINE double SizeSquared() const { return X * X + Y * Y + Z * Z; }
+	MNH_CORE_INLINE double Size() const { return std::sqrt(SizeSquared()); }
+
+	/* Zero vector when the size is below the tolerance, same as FVector::GetSafeNormal */
+	MNH_CORE_INLINE FMnhCoreVector GetSafeNormal(const double Tolerance = 1.e-8) const
+	{
+		const double SquareSum = SizeSquared();
+		if (SquareSum == 1.0)
+		{
+			return *this;
+		}
+		if (SquareSum < Tolerance)
+		{
+			return {};
+		}
+		return *this * (1.0 / std::sqrt(SquareSum));
+	}
+};
+
+struct FMnhCoreQuat
+{
+	double X = 0;
+	double Y = 0;
+	double Z = 0;
+	double W = 1;
+
+	constexpr FMnhCoreQuat() = default;
+	constexpr FMnhCoreQuat(const double InX, const double InY, const double InZ, const double InW) : X(InX), Y(InY), Z(InZ), W(InW) {}
+
+	MNH_CORE_INLINE static FMnhCoreQuat FromAxisAngle(const FMnhCoreVector& Axis, const double AngleRad)
+	{
+		const double HalfSin = std::sin(0.5 * AngleRad);
+		return {Axis.X * HalfSin, Axis.Y * HalfSin, Axis.Z * HalfSin, std::cos(0.5 * AngleRad)};
+	}
+
+	/* Same order as FQuat, A * B rotates by B first */
+	MNH_CORE_INLINE FMnhCoreQuat operator*(const FMnhCoreQuat& Q) const
+	{
+		return {
+			W * Q.X + X * Q.W + Y * Q.Z - Z * Q.Y,
+			W * Q.Y - X * Q.Z + Y * Q.W + Z * Q.X,
+			W * Q.Z + X * Q.Y - Y * Q.X + Z * Q.W,
+			W * Q.W - X * Q.X - Y * Q.Y - Z * Q.Z};
+	}
+	MNH_CORE_INLINE FMnhCoreQuat operator*(const double Scale) const { return {X * Scale, Y * Scale, Z * Scale, W * Scale}; }
+	MNH_CORE_INLINE FMnhCoreQuat operator+(const FMnhCoreQuat& Q) const { return {X + Q.X, Y + Q.Y, Z + Q.Z, W + Q.W}; }
+
+	MNH_CORE_INLINE static double Dot(const FMnhCoreQuat& A, const FMnhCoreQuat& B) { return A.X * B.X + A.Y * B.Y + A.Z * B.Z + A.W * B.W; }
+	MNH_CORE_INLINE double SizeSquared() const { return Dot(*this, *this); }
+	MNH_CORE_INLINE FMnhCoreQuat Conjugate() const { return {-X, -Y, -Z, W}; }
+
+	/* Identity when the size is below the tolerance, same as FQuat::Normalize */
+	MNH_CORE_INLINE FMnhCoreQuat GetNormalized(const double Tolerance = 1.e-8) const
+	{
+		const double SquareSum = SizeSquared();
+		if (SquareSum >= Tolerance)
+		{
+			return *this * (1.0 / std::sqrt(SquareSum));
+		}
+		return {};
+	}
+
+	MNH_CORE_INLINE FMnhCoreVector RotateVector(const FMnhCoreVector& V) const
+	{
+		// V' = V + 2w(Q x V) + (2Q x (Q x V))
+		const FMnhCoreVector Q(X, Y, Z);
+		const FMnhCoreVector T = FMnhCoreVector::Cross(Q, V) * 2.0;
+		return V + T * W + FMnhCoreVector::Cross(Q, T);
+	}
+};
+
+struct FMnhCoreTransform
+{
+	FMnhCoreQuat Rotation;
+	FMnhCoreVector Translation;
+	FMnhCoreVector Scale3D = FMnhCoreVector(1, 1, 1);
+
+	constexpr FMnhCoreTransform() = default;
+	constexpr FMnhCoreTransform(const FMnhCoreQuat& InRotation, const FMnhCoreVector& InTranslation, const FMnhCoreVector& InScale3D = FMnhCoreVector(1, 1, 1))
+		: Rotation(InRotation), Translation(InTranslation), Scale3D(InScale3D) {}
+
+	MNH_CORE_INLINE FMnhCoreVector TransformPosition(const FMnhCoreVector& V) const
+	{
+		return Rotation.RotateVector(FMnhCoreVector(V.X * Scale3D.X, V.Y * Scale3D.Y, V.Z * Scale3D.Z)) + Translation;
+	}
+
+	/**
+	 * Dual quaternion blend, matches UKismetMathLibrary::TLerp with ELerpInterpolationMode::DualQuatInterp.
+	 * Unlike a separate lerp of location and slerp of rotation, points of a rotating tracer follow the arc.
+	 */
+	MNH_CORE_INLINE static FMnhCoreTransform LerpDualQuat(const FMnhCoreTransform& A, const FMnhCoreTransform& B, const double Alpha)
+	{
+		const FMnhCoreQuat RotationA = A.Rotation.GetNormalized();
+		FMnhCoreQuat RotationB = B.Rotation.GetNormalized();
+		if (FMnhCoreQuat::Dot(RotationB, RotationA) < 0)
+		{
+			RotationB = RotationB * -1.0;
+		}
+
+		// Dual parts, half of the translation as a pure quaternion times the rotation
+		const FMnhCoreQuat DualA = FMnhCoreQuat(A.Translation.X, A.Translation.Y, A.Translation.Z, 0) * RotationA * 0.5;
+		const FMnhCoreQuat DualB = FMnhCoreQuat(B.Translation.X, B.Translation.Y, B.Translation.Z, 0) * RotationB * 0.5;
+
+		const FMnhCoreQuat Real = RotationA * (1 - Alpha) + RotationB * Alpha;
+		const FMnhCoreQuat Dual = DualA * (1 - Alpha) + DualB * Alpha;
+		const double RealSizeSquared = Real.SizeSquared();
+		const double InvRealSize = 1.0 / std::sqrt(RealSizeSquared);
+		const FMnhCoreQuat Translation = Dual * Real.Conjugate() * (2.0 / RealSizeSquared);
+
+		return FMnhCoreTransform(Real * InvRealSize, FMnhCoreVector(Translation.X, Translation.Y, Translation.Z),
+			FMnhCoreVector::Lerp(A.Scale3D, B.Scale3D, Alpha));
+	}
+};
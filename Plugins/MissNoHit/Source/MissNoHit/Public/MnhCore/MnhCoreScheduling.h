@@ -0,0 +1,88 @@
+﻿// Copyright 2024 Eren Balatkan. All Rights Reserved.
+
+#pragma once
+
+#include "MnhCoreMath.h"
+
+/* Mirrors EMnhTracerTickType, values are checked in MnhCoreAdapter.h */
+enum class EMnhCoreTickType : uint8_t
+{
+	MatchGameTick,
+	FixedRateTick,
+	DistanceTick,
+	AnimationFinalized
+};
+
+/* Transforms of a single substep, Average is the one the sweep shape is oriented and scaled by */
+struct FMnhCoreSubstepTransforms
+{
+	FMnhCoreTransform Start;
+	FMnhCoreTransform End;
+	FMnhCoreTransform Average;
+};
+
+struct FMnhCoreScheduling
+{
+	static constexpr int32_t DefaultMaxSubsteps = 10;
+
+	/**
+	 * Whether a running tracer sweeps this frame. TickInterval is seconds for FixedRateTick and units for DistanceTick,
+	 * DistanceSinceLastTick is measured from the last swept transform of the tracer.
+	 * AnimationFinalized tracers are only asked once their mesh has finalized a pose they have not swept yet.
+	 */
+	MNH_CORE_INLINE static bool ShouldTick(const EMnhCoreTickType TickType, const double DistanceSinceLastTick,
+		const float DeltaTimeLastTick, const float DeltaTime, const float TickInterval)
+	{
+		switch (TickType)
+		{
+		case EMnhCoreTickType::DistanceTick:
+			return DistanceSinceLastTick >= TickInterval;
+		case EMnhCoreTickType::FixedRateTick:
+			return DeltaTimeLastTick + DeltaTime > TickInterval / 2;
+		default:
+			return true;
+		}
+	}
+
+	/* Tick interval for a tick rate multiplied by RateScale, MatchGameTick and AnimationFinalized tracers are left alone */
+	MNH_CORE_INLINE static float GetScaledTickInterval(const EMnhCoreTickType TickType, const float TickInterval, const float RateScale)
+	{
+		if (TickType == EMnhCoreTickType::MatchGameTick || TickType == EMnhCoreTickType::AnimationFinalized || !(RateScale > 0))
+		{
+			return TickInterval;
+		}
+		return TickInterval / RateScale;
+	}
+
+	/* Number of sweeps the movement since the last tick is split into, capped at MaxSubsteps. A non-positive TickInterval is not split */
+	MNH_CORE_INLINE static int32_t GetSubstepCount(const EMnhCoreTickType TickType, const double DistanceTraveled,
+		const float DeltaTime, const float TickInterval, const int32_t MaxSubsteps = DefaultMaxSubsteps)
+	{
+		int32_t Substeps = 1;
+		if (!(TickInterval > 0))
+		{
+			return Substeps;
+		}
+		if (TickType == EMnhCoreTickType::DistanceTick)
+		{
+			Substeps = int32_t(std::ceil(DistanceTraveled / TickInterval));
+		}
+		else if (TickType == EMnhCoreTickType::FixedRateTick)
+		{
+			Substeps = int32_t(std::ceil(DeltaTime / TickInterval));
+		}
+		return Substeps < MaxSubsteps ? Substeps : MaxSubsteps;
+	}
+
+	/* Start, end and midpoint of substep SubstepIdx when the movement from Previous to Current is split into Substeps */
+	MNH_CORE_INLINE static FMnhCoreSubstepTransforms GetSubstepTransforms(const FMnhCoreTransform& Previous, const FMnhCoreTransform& Current,
+		const uint32_t SubstepIdx, const uint32_t Substeps)
+	{
+		const float SubstepRatio = 1.f / Substeps;
+		FMnhCoreSubstepTransforms Transforms;
+		Transforms.Start = FMnhCoreTransform::LerpDualQuat(Previous, Current, SubstepRatio * SubstepIdx);
+		Transforms.End = FMnhCoreTransform::LerpDualQuat(Previous, Current, SubstepRatio * (SubstepIdx + 1));
+		Transforms.Average = FMnhCoreTransform::LerpDualQuat(Transforms.Start, Transforms.End, 0.5);
+		return Transforms;
+	}
+};
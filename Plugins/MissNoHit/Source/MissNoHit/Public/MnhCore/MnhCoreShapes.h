@@ -0,0 +1,41 @@
+﻿// Copyright 2024 Eren Balatkan. All Rights Reserved.
+
+#pragma once
+
+#include "MnhCoreMath.h"
+
+/* Capsule spanning two sockets, the axes form the rotation matrix of the capsule with Z along its length */
+struct FMnhCoreCapsule
+{
+	FMnhCoreVector Center;
+	FMnhCoreVector AxisX;
+	FMnhCoreVector AxisY;
+	FMnhCoreVector AxisZ;
+	float HalfHeight = 1;
+	float Radius = 1;
+};
+
+struct FMnhCoreShapes
+{
+	/* Same basis as FRotationMatrix::MakeFromZ, X is kept horizontal unless Z is close to vertical */
+	MNH_CORE_INLINE static void MakeBasisFromZ(const FMnhCoreVector& ZAxis, FMnhCoreVector& OutX, FMnhCoreVector& OutY, FMnhCoreVector& OutZ)
+	{
+		OutZ = ZAxis.GetSafeNormal();
+		const FMnhCoreVector UpVector = std::abs(OutZ.Z) < (1.0 - 1.e-4) ? FMnhCoreVector(0, 0, 1) : FMnhCoreVector(1, 0, 0);
+		OutX = FMnhCoreVector::Cross(UpVector, OutZ).GetSafeNormal();
+		OutY = FMnhCoreVector::Cross(OutZ, OutX);
+	}
+
+	/* Capsule between two socket locations, LengthOffset extends both ends. Height and radius never go below 1 */
+	MNH_CORE_INLINE static FMnhCoreCapsule GetCapsuleFromSockets(const FMnhCoreVector& Socket1Location, const FMnhCoreVector& Socket2Location,
+		const float LengthOffset, const float Radius)
+	{
+		FMnhCoreCapsule Capsule;
+		Capsule.Center = (Socket1Location + Socket2Location) / 2.0;
+		const float HalfHeight = float((Socket1Location - Socket2Location).Size() / 2.0 + LengthOffset);
+		Capsule.HalfHeight = HalfHeight > 1.f ? HalfHeight : 1.f;
+		Capsule.Radius = Radius > 1.f ? Radius : 1.f;
+		MakeBasisFromZ(Socket1Location - Socket2Location, Capsule.AxisX, Capsule.AxisY, Capsule.AxisZ);
+		return Capsule;
+	}
+};
@@ -0,0 +1,60 @@
+﻿// Copyright 2024 Eren Balatkan. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MnhCore/MnhCoreHitCache.h"
+#include "MnhCore/MnhCoreScheduling.h"
+#include "MnhCore/MnhCoreShapes.h"
+#include "UObject/UObjectArray.h"
+
+/* Conversions between engine types and the engine independent MnhCore types */
+struct FMnhCoreAdapter
+{
+	FORCEINLINE static FMnhCoreVector ToCore(const FVector& Vector)
+	{
+		return FMnhCoreVector(Vector.X, Vector.Y, Vector.Z);
+	}
+
+	FORCEINLINE static FMnhCoreQuat ToCore(const FQuat& Quat)
+	{
+		return FMnhCoreQuat(Quat.X, Quat.Y, Quat.Z, Quat.W);
+	}
+
+	FORCEINLINE static FMnhCoreTransform ToCore(const FTransform& Transform)
+	{
+		return FMnhCoreTransform(ToCore(Transform.GetRotation()), ToCore(Transform.GetTranslation()), ToCore(Transform.GetScale3D()));
+	}
+
+	FORCEINLINE static FVector ToUnreal(const FMnhCoreVector& Vector)
+	{
+		return FVector(Vector.X, Vector.Y, Vector.Z);
+	}
+
+	FORCEINLINE static FQuat ToUnreal(const FMnhCoreQuat& Quat)
+	{
+		return FQuat(Quat.X, Quat.Y, Quat.Z, Quat.W);
+	}
+
+	FORCEINLINE static FTransform ToUnreal(const FMnhCoreTransform& Transform)
+	{
+		return FTransform(ToUnreal(Transform.Rotation), ToUnreal(Transform.Translation), ToUnreal(Transform.Scale3D));
+	}
+
+	FORCEINLINE static FRotator GetRotator(const FMnhCoreCapsule& Capsule)
+	{
+		return FMatrix(ToUnreal(Capsule.AxisX), ToUnreal(Capsule.AxisY), ToUnreal(Capsule.AxisZ), FVector::ZeroVector).Rotator();
+	}
+
+	/* Index and serial number of the object like a weak pointer, a recycled object slot never matches an old key. Zero for null */
+	FORCEINLINE static uint64 GetObjectKey(const UObjectBase* Object)
+	{
+		if (!Object)
+		{
+			return 0;
+		}
+		const int32 ObjectIndex = GUObjectArray.ObjectToIndex(Object);
+		const int32 SerialNumber = GUObjectArray.AllocateSerialNumber(ObjectIndex);
+		return uint64(uint32(SerialNumber)) << 32 | uint32(ObjectIndex);
+	}
+};
@@ -0,0 +1,72 @@
+﻿// Copyright 2024 Eren Balatkan. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MissNoHit.h"
+#include "MnhHelpers.h"
+#include "Components/LineBatchComponent.h"
+
+/* Compact record of a single debug shape, expanded into lines when the frame's batch is submitted */
+struct FMnhDebugPrimitive
+{
+	const UWorld* World = nullptr;
+	FVector Start = FVector::ZeroVector;
+	FVector End = FVector::ZeroVector;
+	FQuat Rotation = FQuat::Identity;
+	FVector3f HalfSize = FVector3f::ZeroVector;
+	float Radius = 0;
+	float HalfHeight = 0;
+	float LifeTime = 0;
+	FColor Color;
+	EMnhTraceShape TraceShape = EMnhTraceShape::Sphere;
+	bool bPersistent = false;
+	// Hit points are drawn as a cross at Start, the other fields are unused
+	bool bIsPoint = false;
+};
+
+/**
+ * Collects the debug shapes of every tracer during the frame and submits them to each world's line batchers in one call.
+ * Safe to add from worker threads. At most MissNoHit.DebugDraw.MaxPrimitives are drawn per frame, primitives of the
+ * priority actor are drawn first so the tracers under inspection stay visible in crowded fights.
+ */
+class MISSNOHIT_API FMnhDebugDrawBatcher
+{
+public:
+	FMnhDebugDrawBatcher();
+
+	/* Draws the primitives collected since the last call, on the game thread while no worker is adding */
+	void Submit();
+
+	/* Same shapes and colors as FMnhHelpers::DrawDebug */
+	void AddSweep(const FVector& Start, const FVector& End, const FVector& Scale, const FQuat& Rotation, TConstArrayView<FHitResult> Hits,
+		const FMnhShapeData& ShapeData, const UWorld* World, EDrawDebugTrace::Type DrawDebugType, float DebugDrawTime,
+		const FColor& DebugTraceColor, const FColor& DebugTraceBlockColor, const FColor& DebugTraceHitColor, bool bIsPriority);
+
+	void SetPriorityActor(const AActor* Actor) { PriorityActor = Actor; }
+	const AActor* GetPriorityActor() const { return PriorityActor.Get(); }
+
+	int32 GetNumDrawnLastFrame() const { return NumDrawnLastFrame; }
+	int32 GetNumDroppedLastFrame() const { return NumDroppedLastFrame; }
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	TMnhBoundedMpscQueue<FMnhDebugPrimitive> PriorityPrimitives;
+	TMnhBoundedMpscQueue<FMnhDebugPrimitive> Primitives;
+	TMap<ULineBatchComponent*, TArray<FBatchedLine>> LinesByBatcher;
+	TWeakObjectPtr<const AActor> PriorityActor;
+	int32 NumDrawnLastFrame = 0;
+	int32 NumDroppedLastFrame = 0;
+
+	void AddTrace(const FVector& Start, const FVector& End, const FVector& Scale, const FQuat& Rotation, const FColor& Color,
+		const FMnhShapeData& ShapeData, const UWorld* World, EDrawDebugTrace::Type DrawDebugType, float DebugDrawTime, bool bIsPriority);
+	void AddPrimitive(const FMnhDebugPrimitive& Primitive, bool bIsPriority);
+	void AppendLines(const FMnhDebugPrimitive& Primitive);
+};
+
+/* Visual Logger recording of tracer sweeps, so a miss can be scrubbed after the fact. Compiled out with the Visual Logger */
+struct MISSNOHIT_API FMnhVisualLogger
+{
+	/* Sweep shapes and hits of the tracer's last tick, logged on the actor owning the tracer */
+	static void LogTracerSweeps(const FMnhTracerData& TracerData);
+};
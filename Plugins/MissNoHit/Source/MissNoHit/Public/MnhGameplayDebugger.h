@@ -0,0 +1,24 @@
+﻿// Copyright 2024 Eren Balatkan. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if WITH_GAMEPLAY_DEBUGGER
+#include "GameplayDebugger.h"
+#include "GameplayDebuggerCategory.h"
+
+/**
+ * Tracers of the debug actor with their state, tick schedule, last substep count and cost, followed by the hit cache of
+ * its Tracer Components. The debug actor also becomes the priority actor of tracer debug drawing.
+ */
+class FGameplayDebuggerCategory_MissNoHit : public FGameplayDebuggerCategory
+{
+public:
+	FGameplayDebuggerCategory_MissNoHit();
+
+	virtual void CollectData(APlayerController* OwnerPC, AActor* DebugActor) override;
+
+	static TSharedRef<FGameplayDebuggerCategory> MakeInstance();
+};
+#endif
@@ -8,9 +8,13 @@
 #include "Kismet/KismetSystemLibrary.h"
 #include "UObject/Object.h"
 #include "KismetTraceUtils.h"
+#include "MnhCoreAdapter.h"
 #include "UnrealEngine.h"
 #include "Components/SkeletalMeshComponent.h"
+#include "GameFramework/Actor.h"
 #include "DrawDebugHelpers.h"
+#include "HAL/LowLevelMemTracker.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
 #include "MnhHelpers.generated.h"
 
 
@@ -25,11 +29,51 @@ DECLARE_CYCLE_STAT(TEXT("MissNoHit Tracer Do Trace"), STAT_MnhTracerDoTrace, STA
 DECLARE_CYCLE_STAT(TEXT("MissNoHit Tracer Debug Draw"), STAT_MnhTracerDebugDraw, STATGROUP_MISSNOHIT);
 DECLARE_CYCLE_STAT(TEXT("MissNoHit Tracer Trace Done"), STAT_MnhTracerTraceDone, STATGROUP_MISSNOHIT);
 DECLARE_CYCLE_STAT(TEXT("MissNoHit TracerComponent Hit Detected"), STAT_MnhTracerComponentHitDetected, STATGROUP_MISSNOHIT);
+DECLARE_CYCLE_STAT(TEXT("MissNoHit Apply Tracer Commands"), STAT_MnhApplyTracerCommands, STATGROUP_MISSNOHIT);
+DECLARE_CYCLE_STAT(TEXT("MissNoHit Flush Hit Events"), STAT_MnhFlushHitEvents, STATGROUP_MISSNOHIT);
+DECLARE_CYCLE_STAT(TEXT("MissNoHit Lag Compensation Sample"), STAT_MnhLagCompensationSample, STATGROUP_MISSNOHIT);
+DECLARE_CYCLE_STAT(TEXT("MissNoHit Lag Compensation Rewind"), STAT_MnhLagCompensationRewind, STATGROUP_MISSNOHIT);
 DECLARE_CYCLE_STAT(TEXT("MissNoHit Tracer Control Node Hit Detected "), STAT_MnhTracerHitDetectedAsyncNode, STATGROUP_MISSNOHIT);
 DECLARE_CYCLE_STAT(TEXT("MissNoHit Tracer Get Shape"), STAT_MnhGetTracerShape, STATGROUP_MISSNOHIT)
+DECLARE_DWORD_COUNTER_STAT(TEXT("MissNoHit Active Tracers"), STAT_MnhActiveTracers, STATGROUP_MISSNOHIT);
+DECLARE_DWORD_COUNTER_STAT(TEXT("MissNoHit Ticked Tracers"), STAT_MnhTickedTracers, STATGROUP_MISSNOHIT);
+DECLARE_DWORD_COUNTER_STAT(TEXT("MissNoHit Sweeps"), STAT_MnhSweeps, STATGROUP_MISSNOHIT);
+DECLARE_DWORD_COUNTER_STAT(TEXT("MissNoHit Hits Returned"), STAT_MnhHitsReturned, STATGROUP_MISSNOHIT);
+DECLARE_DWORD_COUNTER_STAT(TEXT("MissNoHit Hits Filtered"), STAT_MnhHitsFiltered, STATGROUP_MISSNOHIT);
+DECLARE_DWORD_COUNTER_STAT(TEXT("MissNoHit Debug Primitives Drawn"), STAT_MnhDebugPrimitivesDrawn, STATGROUP_MISSNOHIT);
+DECLARE_DWORD_COUNTER_STAT(TEXT("MissNoHit Debug Primitives Dropped"), STAT_MnhDebugPrimitivesDropped, STATGROUP_MISSNOHIT);
 
 DECLARE_LOG_CATEGORY_EXTERN(LogMnh, Log, All)
 
+// Low level memory tracker tags, visible with -llm in stat LLM and memreport
+LLM_DECLARE_TAG_API(MissNoHit, MISSNOHIT_API);
+// Tracer data pool, tracer configs and tag lookups, command queue
+LLM_DECLARE_TAG_API(MissNoHit_Registry, MISSNOHIT_API);
+// Sweep results and hit event batches
+LLM_DECLARE_TAG_API(MissNoHit_HitBuffers, MISSNOHIT_API);
+LLM_DECLARE_TAG_API(MissNoHit_HitCache, MISSNOHIT_API);
+// Debug drawing, tracer stats and captures
+LLM_DECLARE_TAG_API(MissNoHit_Debug, MISSNOHIT_API);
+
+/* Bytes allocated by MissNoHit, split like the LLM sub-tags */
+struct FMnhMemoryUsage
+{
+	SIZE_T Registry = 0;
+	SIZE_T HitBuffers = 0;
+	SIZE_T HitCache = 0;
+	SIZE_T Debug = 0;
+
+	SIZE_T GetTotal() const { return Registry + HitBuffers + HitCache + Debug; }
+
+	void Add(const FMnhMemoryUsage& Other)
+	{
+		Registry += Other.Registry;
+		HitBuffers += Other.HitBuffers;
+		HitCache += Other.HitCache;
+		Debug += Other.Debug;
+	}
+};
+
 UENUM()
 enum class EMnhTraceSource : uint8
 {
@@ -61,7 +105,22 @@ enum class EMnhTracerTickType : uint8
 {
 	MatchGameTick			UMETA(DisplayName = "Match Game Tick"),
 	FixedRateTick			UMETA(DisplayName = "Fixed Rate Tick"),
-	DistanceTick			UMETA(DisplayName = "Tick by Distance Traveled")
+	DistanceTick			UMETA(DisplayName = "Tick by Distance Traveled"),
+	/* Once per pose the source Skeletal Mesh finalizes, skipped with the mesh by URO and visibility based ticking */
+	AnimationFinalized		UMETA(DisplayName = "Tick on Animation Finalized")
+};
+static_assert(uint8(EMnhTracerTickType::MatchGameTick) == uint8(EMnhCoreTickType::MatchGameTick)
+	&& uint8(EMnhTracerTickType::FixedRateTick) == uint8(EMnhCoreTickType::FixedRateTick)
+	&& uint8(EMnhTracerTickType::DistanceTick) == uint8(EMnhCoreTickType::DistanceTick)
+	&& uint8(EMnhTracerTickType::AnimationFinalized) == uint8(EMnhCoreTickType::AnimationFinalized));
+
+UENUM(BlueprintType)
+enum class EMnhHitSelectionRule : uint8
+{
+	AllHits					UMETA(DisplayName = "All Hits"),
+	EarliestTime			UMETA(DisplayName = "Earliest Time"),
+	ClosestToTip			UMETA(DisplayName = "Closest To Tip"),
+	HighestPriority			UMETA(DisplayName = "Highest Priority")
 };
 
 UENUM()
@@ -186,6 +245,102 @@ public:
 	bool bTraceComplex=true;
 };
 
+USTRUCT(BlueprintType)
+struct FMnhHitSelectionSettings
+{
+	GENERATED_BODY()
+
+public:
+	/* When a single sweep returns multiple hits on the same actor, only one of them is kept based on this rule */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category="MissNoHit")
+	EMnhHitSelectionRule SelectionRule = EMnhHitSelectionRule::AllHits;
+
+	/* Higher value wins, materials that are not listed have priority of 0 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category="MissNoHit",
+		meta=(EditCondition="SelectionRule==EMnhHitSelectionRule::HighestPriority", EditConditionHides))
+	TMap<TObjectPtr<UPhysicalMaterial>, int32> PhysicalMaterialPriorities;
+
+	/* Higher value wins, bones that are not listed have priority of 0 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category="MissNoHit",
+		meta=(EditCondition="SelectionRule==EMnhHitSelectionRule::HighestPriority", EditConditionHides))
+	TMap<FName, int32> BonePriorities;
+
+	FORCEINLINE int32 GetHitPriority(const FHitResult& HitResult) const
+	{
+		int32 Priority = 0;
+		if (const auto MaterialPriority = PhysicalMaterialPriorities.Find(HitResult.PhysMaterial.Get()))
+		{
+			Priority = *MaterialPriority;
+		}
+		if (const auto BonePriority = BonePriorities.Find(HitResult.BoneName))
+		{
+			Priority = FMath::Max(Priority, *BonePriority);
+		}
+		return Priority;
+	}
+};
+
+/* Actors ignored by every tracer of a Tracer Component, tracers reference it instead of keeping their own copy */
+struct FMnhIgnoreSet
+{
+	FMnhIgnoreSet()
+	{
+		SimpleCollisionParams.bReturnPhysicalMaterial = true;
+		ComplexCollisionParams.bReturnPhysicalMaterial = true;
+		ComplexCollisionParams.bTraceComplex = true;
+	}
+
+	bool AddIgnoredActor(const AActor* Actor)
+	{
+		if (!Actor || IgnoredActorIds.Contains(Actor->GetUniqueID()))
+		{
+			return false;
+		}
+		const uint32 ActorId = Actor->GetUniqueID();
+		IgnoredActorIds.Add(ActorId);
+		SimpleCollisionParams.AddIgnoredActor(ActorId);
+		ComplexCollisionParams.AddIgnoredActor(ActorId);
+		Revision++;
+		return true;
+	}
+
+	bool RemoveIgnoredActor(const AActor* Actor)
+	{
+		if (!Actor || IgnoredActorIds.RemoveSwap(Actor->GetUniqueID(), EAllowShrinking::No) == 0)
+		{
+			return false;
+		}
+		
+		// Query params can't remove a single actor, rebuild their lists from ours
+		SimpleCollisionParams.ClearIgnoredActors();
+		ComplexCollisionParams.ClearIgnoredActors();
+		for (const uint32 ActorId : IgnoredActorIds)
+		{
+			SimpleCollisionParams.AddIgnoredActor(ActorId);
+			ComplexCollisionParams.AddIgnoredActor(ActorId);
+		}
+		Revision++;
+		return true;
+	}
+
+	int32 Num() const { return IgnoredActorIds.Num(); }
+	/* Unique IDs of the ignored actors */
+	TConstArrayView<uint32> GetIgnoredActorIds() const { return IgnoredActorIds; }
+	/* Bumped on every change, lets observers like the capture recorder detect changes without comparing lists */
+	uint32 GetRevision() const { return Revision; }
+
+	FORCEINLINE const FCollisionQueryParams& GetCollisionParams(const bool bTraceComplex) const
+	{
+		return bTraceComplex ? ComplexCollisionParams : SimpleCollisionParams;
+	}
+
+private:
+	FCollisionQueryParams SimpleCollisionParams;
+	FCollisionQueryParams ComplexCollisionParams;
+	TArray<uint32> IgnoredActorIds;
+	uint32 Revision = 0;
+};
+
 USTRUCT()
 struct MISSNOHIT_API FMnhHelpers
 {
@@ -214,7 +369,8 @@ public:
 	}
 
 	
-	FORCEINLINE static void DrawDebug(const FVector& Start, const FVector& End, const FVector& Scale, const FQuat& Rot, TArray<FHitResult> Hits, const FMnhShapeData& ShapeData, const UWorld* World,
+	/* Draws immediately, tracers go through FMnhDebugDrawBatcher instead */
+	FORCEINLINE static void DrawDebug(const FVector& Start, const FVector& End, const FVector& Scale, const FQuat& Rot, TConstArrayView<FHitResult> Hits, const FMnhShapeData& ShapeData, const UWorld* World,
 	                                  const EDrawDebugTrace::Type DrawDebugType, float DebugDrawTime, const FColor& DebugTraceColor, const FColor& DebugTraceBlockColor, const FColor& DebugTraceHitColor)
 	{
 		SCOPE_CYCLE_COUNTER(STAT_MnhTracerDebugDraw)
@@ -317,18 +473,86 @@ public:
 		}
 	}
 
+	// Tip of the tracer is the furthest point of the shape along its local Z axis, which points to MeshSocket_1 on socket tracers
+	FORCEINLINE static FVector GetTracerTipLocation(const FTransform& Transform, const FMnhShapeData& ShapeData)
+	{
+		switch (ShapeData.TraceShape)
+		{
+		case EMnhTraceShape::Box:
+			return Transform.GetLocation() + Transform.GetRotation().GetUpVector() * ShapeData.HalfSize.Z;
+		case EMnhTraceShape::Capsule:
+			return Transform.GetLocation() + Transform.GetRotation().GetUpVector() * ShapeData.HalfHeight * Transform.GetScale3D().X;
+		default:
+			return Transform.GetLocation();
+		}
+	}
+
+	FORCEINLINE static bool IsBetterHit(const FHitResult& Candidate, const FHitResult& Current, const FMnhHitSelectionSettings& Settings, const FVector& TipLocation)
+	{
+		switch (Settings.SelectionRule)
+		{
+		case EMnhHitSelectionRule::ClosestToTip:
+			return FVector::DistSquared(Candidate.ImpactPoint, TipLocation) < FVector::DistSquared(Current.ImpactPoint, TipLocation);
+		case EMnhHitSelectionRule::HighestPriority:
+			{
+				const int32 CandidatePriority = Settings.GetHitPriority(Candidate);
+				const int32 CurrentPriority = Settings.GetHitPriority(Current);
+				if (CandidatePriority != CurrentPriority)
+				{
+					return CandidatePriority > CurrentPriority;
+				}
+				return Candidate.Time < Current.Time;
+			}
+		default:
+			return Candidate.Time < Current.Time;
+		}
+	}
+
+	/* Reduces hits of a single sweep to one hit per actor, kept hits preserve the sweep order of their actor's first hit */
+	FORCEINLINE static void SelectBestHitPerActor(TArray<FHitResult>& Hits, const FMnhHitSelectionSettings& Settings, const FVector& TipLocation)
+	{
+		if (Settings.SelectionRule == EMnhHitSelectionRule::AllHits || Hits.Num() < 2)
+		{
+			return;
+		}
+
+		int32 KeptHitCount = 0;
+		for (int32 HitIdx = 0; HitIdx < Hits.Num(); HitIdx++)
+		{
+			const AActor* HitActor = Hits[HitIdx].GetActor();
+			int32 KeptHitIdx = INDEX_NONE;
+			for (int32 Idx = 0; Idx < KeptHitCount; Idx++)
+			{
+				if (Hits[Idx].GetActor() == HitActor)
+				{
+					KeptHitIdx = Idx;
+					break;
+				}
+			}
+
+			if (KeptHitIdx == INDEX_NONE)
+			{
+				Hits.Swap(KeptHitCount++, HitIdx);
+			}
+			else if (IsBetterHit(Hits[HitIdx], Hits[KeptHitIdx], Settings, TipLocation))
+			{
+				Hits.Swap(KeptHitIdx, HitIdx);
+			}
+		}
+		Hits.SetNum(KeptHitCount, EAllowShrinking::No);
+	}
+
 	FORCEINLINE static FMnhShapeData GetCapsuleShapeDataFromTransforms(const FTransform& Transform1, const FTransform& Transform2, const float LengthOffset, const float Radius)
 	{
-		const FVector Socket1Location = Transform1.GetLocation();
-		const FVector Socket2Location = Transform2.GetLocation();
-		const FVector CenterLocation = (Socket1Location + Socket2Location) / 2.f;
+		const FMnhCoreCapsule Capsule = FMnhCoreShapes::GetCapsuleFromSockets(
+			FMnhCoreAdapter::ToCore(Transform1.GetLocation()), FMnhCoreAdapter::ToCore(Transform2.GetLocation()), LengthOffset, Radius);
 
 		FMnhShapeData ShapeData;
 		ShapeData.TraceShape = EMnhTraceShape::Capsule;
-		ShapeData.HalfHeight = FMath::Max((Socket1Location - Socket2Location).Length() / 2.f + LengthOffset, 1.f);
-		ShapeData.Offset = CenterLocation;
-		ShapeData.Orientation = FRotationMatrix::MakeFromZ(Socket1Location - Socket2Location).Rotator();
-		ShapeData.Radius = FMath::Max(1.f, Radius);
+		ShapeData.HalfHeight = Capsule.HalfHeight;
+		ShapeData.Offset = FMnhCoreAdapter::ToUnreal(Capsule.Center);
+		ShapeData.Orientation = FMnhCoreAdapter::GetRotator(Capsule);
+		ShapeData.Radius = Capsule.Radius;
 		return ShapeData;
 	}
 };
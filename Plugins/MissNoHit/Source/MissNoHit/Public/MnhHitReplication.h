@@ -0,0 +1,68 @@
+﻿// Copyright 2024 Eren Balatkan. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/NetSerialization.h"
+#include "GameplayTagContainer.h"
+#include "MnhHitReplication.generated.h"
+
+class UMnhTracerComponent;
+struct FMnhHitEvent;
+
+UENUM(BlueprintType)
+enum class EMnhHitReplicationMode : uint8
+{
+	None UMETA(DisplayName="None"),
+	/* Hits detected on the server are sent to clients */
+	ServerAuthoritative UMETA(DisplayName="Server Authoritative"),
+	/* Hits detected by the owning client are sent to the server, validated, then sent to the other clients */
+	ClientReported UMETA(DisplayName="Client Reported")
+};
+
+/* Quantized hit, HitActor is sent as its net GUID */
+struct FMnhReplicatedHit
+{
+	FVector_NetQuantize ImpactPoint;
+	FVector_NetQuantizeNormal ImpactNormal;
+	TWeakObjectPtr<AActor> HitActor;
+	// Sent as its network index, stays valid however the tracers are ordered on each machine
+	FGameplayTag TracerTag;
+	// Hit time along the substep sweep, 0-255
+	uint8 SweepTime = 0;
+	// Substep delta time in tenths of a millisecond
+	uint16 DeltaTime = 0;
+};
+
+/* Hits of a single frame of a single Tracer Component, sent as one message */
+USTRUCT()
+struct MISSNOHIT_API FMnhReplicatedHitBatch
+{
+	GENERATED_BODY()
+
+	static constexpr int32 MaxHits = 64;
+
+	TArray<FMnhReplicatedHit, TInlineAllocator<8>> Hits;
+
+	/* Set for client reported batches validated by UMnhLagCompensationSubsystem, the server rebuilds the sweeps from its own samples */
+	bool bIncludesTimestamp = false;
+	/* Server world time the client detected the hits at, only sent with bIncludesTimestamp */
+	double Timestamp = 0;
+	/* Client frame the hits were swept in, in tenths of a millisecond, only sent with bIncludesTimestamp */
+	uint16 FrameDeltaTime = 0;
+
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+
+	static FMnhReplicatedHit Pack(const FMnhHitEvent& HitEvent);
+	/* Returns false when the hit actor can not be resolved on this machine */
+	static bool Unpack(const FMnhReplicatedHit& Hit, FHitResult& OutHitResult, float& OutDeltaTime);
+};
+
+template<>
+struct TStructOpsTypeTraits<FMnhReplicatedHitBatch> : public TStructOpsTypeTraitsBase2<FMnhReplicatedHitBatch>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
@@ -0,0 +1,144 @@
+﻿// Copyright 2024 Eren Balatkan. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "MnhHelpers.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "MnhLagCompensation.generated.h"
+
+class UMnhTracerComponent;
+
+struct FMnhRewindHit
+{
+	TWeakObjectPtr<UPrimitiveComponent> Component;
+	FVector ImpactPoint = FVector::ZeroVector;
+	// Distance along the sweep, 0 at start, 1 at end
+	float Time = 0;
+};
+
+/* Target shape registered for lag compensation, stays constant while it is registered */
+struct FMnhHurtbox
+{
+	TWeakObjectPtr<UPrimitiveComponent> Component;
+	// Kept to find the slot after the component is destroyed
+	TObjectKey<UPrimitiveComponent> ComponentKey;
+	EMnhTraceShape Shape = EMnhTraceShape::Sphere;
+	// Box: half extents, Sphere: (Radius, 0, 0), Capsule: (Radius, HalfHeight, 0)
+	FVector3f Extent = FVector3f::ZeroVector;
+	// Frames sampled before it may hold a previous user of the slot, negative until the first sample
+	double FirstSampleTime = -1;
+	bool bIsRegistered = false;
+};
+
+/* Shape posed at a point in time, Extent follows the FMnhHurtbox layout */
+struct FMnhRewoundShape
+{
+	EMnhTraceShape Shape = EMnhTraceShape::Sphere;
+	FVector3f Extent = FVector3f::ZeroVector;
+	FVector Center = FVector::ZeroVector;
+	FQuat Rotation = FQuat::Identity;
+	// Tracer samples only, cleared for frames the tracer was not running on the server
+	bool bIsValid = false;
+};
+
+/* Tracer Config shapes the server swept for a component, HistoryFrameCount samples per Tracer Config */
+struct FMnhTracerHistory
+{
+	TWeakObjectPtr<UMnhTracerComponent> TracerComponent;
+	int32 NumTracerConfigs = 0;
+	// Indexed by TracerConfigIdx * HistoryFrameCount + frame index
+	TArray<FMnhRewoundShape> Samples;
+};
+
+/* Hurtbox transforms of a single server tick, one array per component so rewinding runs over contiguous floats */
+struct FMnhHurtboxFrame
+{
+	double Time = 0;
+	TArray<float> LocationX;
+	TArray<float> LocationY;
+	TArray<float> LocationZ;
+	TArray<float> RotationX;
+	TArray<float> RotationY;
+	TArray<float> RotationZ;
+	TArray<float> RotationW;
+
+	void SetNum(int32 NumHurtboxes);
+};
+
+/**
+ * Keeps a short history of hurtbox transforms on the server so hits reported by clients can be validated
+ * against the state the client saw, instead of simulating every swing on the server.
+ * Timestamps are in server world time, clients can estimate it through AGameStateBase::GetServerWorldTimeSeconds.
+ */
+UCLASS()
+class MISSNOHIT_API UMnhLagCompensationSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/* Number of server ticks kept, at 60Hz this covers about a second */
+	static constexpr int32 HistoryFrameCount = 64;
+	/* Rewind allowed on top of the round trip time of the reporting connection, covers jitter and the client's interpolation */
+	static constexpr double RewindSlackTime = 0.1;
+	/* Longest client sweep a reported hit can be validated against */
+	static constexpr float MaxSweepDuration = 0.25f;
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/* Sphere, Box and Capsule components use their shape, other primitives are approximated by their bounding sphere */
+	UFUNCTION(BlueprintCallable, Category="MissNoHit")
+	void RegisterHurtbox(UPrimitiveComponent* Component);
+
+	UFUNCTION(BlueprintCallable, Category="MissNoHit")
+	void UnregisterHurtbox(UPrimitiveComponent* Component);
+
+	/* Samples the running Tracer Configs of the component every tick, hits it reports can only be validated while registered */
+	void RegisterTracerComponent(UMnhTracerComponent* TracerComponent);
+	void UnregisterTracerComponent(UMnhTracerComponent* TracerComponent);
+
+	/*
+	 * Sweeps a sphere from Start to End against hurtboxes rewound to Timestamp. Boxes are tested against their extents grown
+	 * by SweepRadius, which slightly over-estimates corners. Returns false when Timestamp is outside the kept history.
+	 */
+	bool RewindSweep(const FVector& Start, const FVector& End, float SweepRadius, double Timestamp,
+		TArray<FMnhRewindHit>& OutHits, const AActor* IgnoredActor=nullptr);
+
+	/*
+	 * Checks a hurtbox of HitActor was touched by the tracer during the SweepDuration seconds before Timestamp. The sweep is rebuilt
+	 * from the tracer shapes the server sampled itself and tested against the hurtboxes rewound to the same times, both shapes grown
+	 * by Tolerance. Timestamp is clamped to the round trip time of the owner's connection.
+	 */
+	UFUNCTION(BlueprintCallable, Category="MissNoHit")
+	bool ValidateHit(UMnhTracerComponent* TracerComponent, FGameplayTag TracerTag, double Timestamp, float SweepDuration,
+		AActor* HitActor, float Tolerance=10);
+
+private:
+	TArray<FMnhHurtbox> Hurtboxes;
+	TArray<int32> FreeHurtboxSlots;
+	TMap<TObjectKey<UPrimitiveComponent>, int32> HurtboxSlotsByComponent;
+
+	TMap<TObjectKey<UMnhTracerComponent>, FMnhTracerHistory> TracerHistories;
+
+	TArray<FMnhHurtboxFrame> Frames;
+	int32 NewestFrameIdx = INDEX_NONE;
+	int32 NumFrames = 0;
+	int32 NumSampledHurtboxes = 0;
+
+	// Rewound transforms of the last query, kept to avoid allocating per query.
+	// Time is the older sample, hurtboxes registered after it are skipped
+	FMnhHurtboxFrame RewoundFrame;
+
+	void SampleHurtboxes(double Time);
+	void SampleTracers();
+	/* Frames around Timestamp and the blend between them, false when Timestamp is older than the history */
+	bool FindFramesAround(double Timestamp, int32& OutOlderIdx, int32& OutNewerIdx, float& OutAlpha) const;
+	bool RewindTo(double Timestamp);
+	FMnhRewoundShape RewindHurtbox(int32 SlotIdx, double Timestamp) const;
+	FMnhRewoundShape RewindTracer(const FMnhTracerHistory& History, int32 TracerConfigIdx, double Timestamp) const;
+	static void GetHurtboxShape(const UPrimitiveComponent* Component, EMnhTraceShape& OutShape, FVector3f& OutExtent);
+};
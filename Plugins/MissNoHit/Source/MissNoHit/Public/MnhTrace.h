@@ -0,0 +1,59 @@
+﻿// Copyright 2024 Eren Balatkan. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MnhHelpers.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Trace/Trace.h"
+
+struct FMnhTracerData;
+
+#ifndef MNH_TRACE_ENABLED
+#define MNH_TRACE_ENABLED (UE_TRACE_ENABLED && !UE_BUILD_SHIPPING)
+#endif
+
+/* Why a tracer did or did not sweep this frame */
+enum class EMnhTraceTickReason : uint8
+{
+	SourceInvalid,
+	MatchGameTick,
+	PendingStop,
+	DistanceReached,
+	DistanceNotReached,
+	FixedRateDue,
+	FixedRateNotDue,
+	PoseFinalized,
+	PoseNotFinalized
+};
+
+#if MNH_TRACE_ENABLED
+
+UE_TRACE_CHANNEL_EXTERN(MissNoHitChannel, MISSNOHIT_API);
+
+/**
+ * Structured events of the MissNoHit Insights channel, enable with -trace=missnohit or Trace.Enable MissNoHit.
+ * Tracers are identified by the serial of their Guid, owners by their object trace id so they line up with Gameplay Insights tracks.
+ */
+struct MISSNOHIT_API FMnhTraceEvents
+{
+	FORCEINLINE static bool IsEnabled() { return UE_TRACE_CHANNELEXPR_IS_ENABLED(MissNoHitChannel); }
+
+	static void TracerStarted(const FMnhTracerData& TracerData);
+	static void TracerStopped(const FMnhTracerData& TracerData, bool bStopImmediate);
+	static void TickDecision(const FMnhTracerData& TracerData, bool bTicked, EMnhTraceTickReason Reason);
+	static void Sweep(const FMnhTracerData& TracerData, uint32 SubstepIdx, float SweepLength, uint32 NumHits, uint64 StartCycle, uint64 EndCycle);
+	static void HitDispatched(const FMnhTracerData& TracerData, uint32 SubstepIdx, const FHitResult& HitResult);
+};
+
+/* Evaluates the event call only while the channel is enabled, e.g. MNH_TRACE(TracerStarted(TracerData)) */
+#define MNH_TRACE(EventCall) if (FMnhTraceEvents::IsEnabled()) { FMnhTraceEvents::EventCall; }
+/* CPU timing scope on the MissNoHit channel, shows up on the thread tracks of the Timing view */
+#define MNH_TRACE_SCOPE(Name) TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL_STR(Name, MissNoHitChannel)
+
+#else
+
+#define MNH_TRACE(EventCall)
+#define MNH_TRACE_SCOPE(Name)
+
+#endif
@@ -6,6 +6,9 @@
 #include "GameplayTagContainer.h"
 #include "MissNoHit.h"
 #include "MnhHelpers.h"
+#include "MnhTracerCommands.h"
+#include "MnhTracerDefinition.h"
+#include "MnhTracerStats.h"
 #include "UObject/Object.h"
 #include "Kismet/KismetSystemLibrary.h"
 #include "WorldCollision.h"
@@ -81,6 +84,10 @@ public:
 		meta=(EditCondition="TracerTickType==EMnhTracerTickType::DistanceTick", EditConditionHides))
 	int TickDistanceTraveled = 30;
 
+	/* Specifies which hit is kept when a sweep hits the same actor multiple times */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category="MissNoHit")
+	FMnhHitSelectionSettings HitSelection;
+
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category="MissNoHit|Debug")
 	TEnumAsByte<EDrawDebugTrace::Type> DrawDebugType;
 
@@ -106,9 +113,10 @@ public:
 	bool bIsTracerActive = false;
 	
 	TObjectPtr<UMnhTracerComponent> OwnerComponent;
-	
-	FCollisionQueryParams CollisionParams;
-	FCollisionObjectQueryParams ObjectQueryParams;
+
+	/* Built from the properties above when the tracer is registered */
+	UPROPERTY(Transient)
+	TObjectPtr<UMnhTracerDefinition> ActiveDefinition;
 
 	void InitializeParameters(UPrimitiveComponent* SourceComponentArg);
 	void InitializeFromPhysicAsset();
@@ -123,10 +131,14 @@ public:
 	FGuid TracerDataGuid;
 
 	void RegisterTracerData();
-	void UpdateTracerData();
+	/* Registers into a slot already reserved through FMissNoHitModule::RequestNewTracerDataRange */
+	void RegisterTracerDataAt(int TracerDataIdxArg);
+	/* Stages the given field groups, runtime state of the tracer is left alone */
+	void UpdateTracerData(EMnhTracerDataDirtyFlags DirtyFlags=EMnhTracerDataDirtyFlags::All);
 	void MarkTracerDataForRemoval() const;
 
 private:
+	void WriteTracerData();
 	FMnhTracerData& GetTracerData() const;
 	
 };
@@ -139,6 +151,10 @@ struct FMnhTracerConfig
 public:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category="MissNoHit")
 	FGameplayTag TracerTag;
+
+	/* Shared tracer definition, when set it is used instead of the properties below */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category="MissNoHit")
+	TObjectPtr<UMnhTracerDefinition> Definition;
 	
 	UPROPERTY(EditAnywhere, Category="MissNoHit")
 	EMnhTraceSource TraceSource = EMnhTraceSource::MnhShapeComponent;
@@ -159,7 +175,7 @@ public:
 		meta=(EditCondition="(TraceSource==EMnhTraceSource::StaticMeshSockets||TraceSource==EMnhTraceSource::SkeletalMeshSockets)", EditConditionHides))
 	float MeshSocketTracerLengthOffset = 0;
 
-	/* Name of the Socket or Bone Tracer will be attached to */
+	/* Name of the Socket or Bone Tracer will be attached to, taken from Definition when one is set */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category="MissNoHit",
 		meta=(EditCondition="(TraceSource==EMnhTraceSource::SocketOrBone)||(TraceSource==EMnhTraceSource::PhysicsAsset)", EditConditionHides))
 	FName SocketOrBoneName;
@@ -187,6 +203,10 @@ public:
 		meta=(EditCondition="TracerTickType==EMnhTracerTickType::DistanceTick", EditConditionHides))
 	int TickDistanceTraveled = 30;
 
+	/* Specifies which hit is kept when a sweep hits the same actor multiple times */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category="MissNoHit")
+	FMnhHitSelectionSettings HitSelection;
+
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category="MissNoHit|Debug")
 	TEnumAsByte<EDrawDebugTrace::Type> DrawDebugType = EDrawDebugTrace::None;
 
@@ -214,8 +234,15 @@ public:
 	int OwnerTracerConfigIdx;
 	TObjectPtr<UMnhTracerComponent> OwnerTracerComponent;
 
-	FCollisionQueryParams CollisionParams;
-	FCollisionObjectQueryParams ObjectQueryParams;
+	/* Definition or a transient one built from the inline properties, resolved when the tracer is registered */
+	UPROPERTY(Transient)
+	TObjectPtr<UMnhTracerDefinition> ActiveDefinition;
+
+	const UMnhTracerDefinition& GetDefinition() const { return *ActiveDefinition; }
+	EMnhTraceSource GetTraceSource() const
+	{
+		return ActiveDefinition ? ActiveDefinition->TraceSource : Definition ? Definition->TraceSource : TraceSource;
+	}
 	
 	void InitializeParameters(UPrimitiveComponent* SourceComponentArg);
 	void InitializeFromPhysicAsset();
@@ -226,28 +253,46 @@ public:
 	void ChangeTracerState(bool bIsTracerActiveArg, bool bStopImmediate=true);
 	bool IsTracerActive() const;
 	void RegisterTracerData();
-	void UpdateTracerData() const;
+	/* Registers into a slot already reserved through FMissNoHitModule::RequestNewTracerDataRange */
+	void RegisterTracerDataAt(int TracerDataIdxArg);
+	/* Stages the given field groups, runtime state of the tracer is left alone */
+	void UpdateTracerData(EMnhTracerDataDirtyFlags DirtyFlags=EMnhTracerDataDirtyFlags::All) const;
 	void MarkTracerDataForRemoval() const;
 
 private:
+	void ResolveDefinition();
+	void WriteTracerData() const;
 	FMnhTracerData& GetTracerData() const;
 };
 
+/* Shared by the AnimationFinalized tracers of a source component, bound on the game thread by the module */
+struct FMnhAnimationPoseSource
+{
+	// Compared against the tracer's source so a re-attached tracer is bound again
+	TObjectKey<UPrimitiveComponent> SourceComponentKey;
+	TWeakObjectPtr<USkeletalMeshComponent> Mesh;
+	FDelegateHandle BoneTransformsFinalizedHandle;
+	// Other sources have no pose to wait for and tick with the game
+	bool bIsSkeletalMesh = false;
+	// Incremented each time the mesh finalizes its bones on the game thread, read by the module's workers
+	std::atomic<uint32> PoseSerial = 0;
+
+	uint32 GetPoseSerial() const { return PoseSerial.load(std::memory_order_relaxed); }
+};
+
 USTRUCT(BlueprintType)
 struct FMnhTracerData
 {
 	GENERATED_BODY()
 
 public:
-	EMnhTraceSource TraceSource;
-	FName MeshSocket_1 = NAME_None;
-	FName MeshSocket_2 = NAME_None;
+	// Shared between every tracer built from the same definition, kept alive by the owning Tracer Config or Tracer
+	const UMnhTracerDefinition* Definition = nullptr;
+	
 	FName SocketOrBoneName;
 	FMnhShapeData ShapeData;
-	FMnhTraceSettings TraceSettings;
 	EMnhTracerTickType TracerTickType;
 	float TickInterval = 30;
-	TEnumAsByte<EDrawDebugTrace::Type> DrawDebugType;
 	bool bUsesTracerConfig = true;
 	
 	float DeltaTimeLastTick = 0;
@@ -261,21 +306,43 @@ public:
 	TObjectPtr<UMnhTracerComponent> OwnerTracerComponent;
 	EMnhTracerState TracerState = EMnhTracerState::Stopped;
 
-	FCollisionQueryParams CollisionParams;
-	FCollisionObjectQueryParams ObjectQueryParams;
+	// Owned by the Tracer Component, changes are picked up by the next sweep
+	TSharedPtr<const FMnhIgnoreSet> IgnoreSet;
 	
+	// Containers are kept when the tracer data slot is recycled, only the first NumSubstepHits are valid
 	TArray<FMnhMultiTraceResultContainer> SubstepHits;
+	int32 NumSubstepHits = 0;
 	TArray<FTransform, TFixedAllocator<2>> TracerTransformsOverTime;
 	bool bShouldTickThisFrame = false;
 	bool IsPendingRemoval = false;
 
+	FMnhTracerDataChangeSet PendingChanges;
+
+	TSharedPtr<const FMnhAnimationPoseSource> AnimationPoseSource;
+	uint32 LastSweptPoseSerial = 0;
+
+	// Written by the worker sweeping this tracer, StatsEntry is resolved on the game thread when the tracer starts
+	FMnhTracerCounters Counters;
+	FMnhTracerStatsEntry* StatsEntry = nullptr;
 	
+	FGameplayTag GetTracerTag() const;
 	void ChangeTracerState(bool bIsTracerActiveArg, bool bStopImmediate=true);
+	void ApplyPendingChanges();
 	void DoTrace(const uint32 Substeps, const uint32 TickIdx);
+	void ReserveHitBuffers(int32 Substeps, int32 HitsPerSubstep);
+	/* Hit buffers of the slot, pooled slots keep them */
+	SIZE_T GetAllocatedSize() const;
+	void ResetForReuse();
+
+	FORCEINLINE TConstArrayView<FMnhMultiTraceResultContainer> GetSubstepHits() const
+	{
+		return TConstArrayView<FMnhMultiTraceResultContainer>(SubstepHits.GetData(), NumSubstepHits);
+	}
 	
 	FORCEINLINE FTransform GetCurrentTracerTransform()
 	{
 		FTransform CurrentTransform;
+		const EMnhTraceSource TraceSource = Definition->TraceSource;
 		if (TraceSource == EMnhTraceSource::PhysicsAsset || TraceSource == EMnhTraceSource::AnimNotify)
 		{
 			const USkeletalMeshComponent* Source = Cast<USkeletalMeshComponent>(SourceComponent);
@@ -311,8 +378,8 @@ public:
 				return CurrentTransform;
 			}
 			const auto LengthOffset = ShapeData.HalfSize.X;
-			const auto Socket1Transform = Source->GetSocketTransform(MeshSocket_1, RTS_World);
-			const auto Socket2Transform = Source->GetSocketTransform(MeshSocket_2, RTS_World);
+			const auto Socket1Transform = Source->GetSocketTransform(Definition->MeshSocket_1, RTS_World);
+			const auto Socket2Transform = Source->GetSocketTransform(Definition->MeshSocket_2, RTS_World);
 			const auto NewShapeData =
 				FMnhHelpers::GetCapsuleShapeDataFromTransforms(Socket1Transform, Socket2Transform, LengthOffset, ShapeData.Radius);
 			ShapeData = NewShapeData;
@@ -0,0 +1,89 @@
+﻿// Copyright 2024 Eren Balatkan. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MnhHelpers.h"
+
+class UMnhTracerDefinition;
+
+/* Field groups of FMnhTracerData that can be updated without touching its runtime state */
+enum class EMnhTracerDataDirtyFlags : uint8
+{
+	None = 0,
+	Shape = 1 << 0,
+	Attachment = 1 << 1, // Source component and socket or bone name
+	TraceSettings = 1 << 2, // Tracer definition
+	QueryParams = 1 << 3, // Ignore set
+	TickPolicy = 1 << 4,
+	All = Shape | Attachment | TraceSettings | QueryParams | TickPolicy
+};
+ENUM_CLASS_FLAGS(EMnhTracerDataDirtyFlags)
+
+/* Changes staged on a tracer data, applied by the module at the start of its next tick or when the tracer is started */
+struct FMnhTracerDataChangeSet
+{
+	EMnhTracerDataDirtyFlags DirtyFlags = EMnhTracerDataDirtyFlags::None;
+	FMnhShapeData ShapeData;
+	TObjectPtr<UPrimitiveComponent> SourceComponent;
+	FName SocketOrBoneName;
+	const UMnhTracerDefinition* Definition = nullptr;
+	TSharedPtr<const FMnhIgnoreSet> IgnoreSet;
+	EMnhTracerTickType TracerTickType = EMnhTracerTickType::MatchGameTick;
+	float TickInterval = 0;
+
+	void Merge(const FMnhTracerDataChangeSet& Other)
+	{
+		DirtyFlags |= Other.DirtyFlags;
+		if (EnumHasAnyFlags(Other.DirtyFlags, EMnhTracerDataDirtyFlags::Shape))
+		{
+			ShapeData = Other.ShapeData;
+		}
+		if (EnumHasAnyFlags(Other.DirtyFlags, EMnhTracerDataDirtyFlags::Attachment))
+		{
+			SourceComponent = Other.SourceComponent;
+			SocketOrBoneName = Other.SocketOrBoneName;
+		}
+		if (EnumHasAnyFlags(Other.DirtyFlags, EMnhTracerDataDirtyFlags::TraceSettings))
+		{
+			Definition = Other.Definition;
+		}
+		if (EnumHasAnyFlags(Other.DirtyFlags, EMnhTracerDataDirtyFlags::QueryParams))
+		{
+			IgnoreSet = Other.IgnoreSet;
+		}
+		if (EnumHasAnyFlags(Other.DirtyFlags, EMnhTracerDataDirtyFlags::TickPolicy))
+		{
+			TracerTickType = Other.TracerTickType;
+			TickInterval = Other.TickInterval;
+		}
+	}
+};
+
+enum class EMnhTracerCommandType : uint8
+{
+	Start,
+	Stop,
+	StopDelayed,
+	Update,
+	AddIgnoredActor,
+	RemoveIgnoredActor,
+	Remove
+};
+
+/* Tracer mutation queued from outside the game thread, applied by the module at the start of its tick */
+struct FMnhTracerCommand
+{
+	EMnhTracerCommandType Type = EMnhTracerCommandType::Stop;
+
+	// Index is only a hint, tracers can be moved by removals after the command is queued
+	int TracerDataIdx = -1;
+	FGuid TracerDataGuid;
+
+	// Update
+	FMnhTracerDataChangeSet Changes;
+
+	// AddIgnoredActor, RemoveIgnoredActor
+	TSharedPtr<FMnhIgnoreSet> IgnoreSet;
+	TWeakObjectPtr<const AActor> Actor;
+};
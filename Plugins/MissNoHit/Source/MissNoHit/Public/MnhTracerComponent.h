@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "GameplayTagContainer.h"
 #include "MnhHelpers.h"
+#include "MnhHitReplication.h"
 #include "MnhTracer.h"
 #include "Components/ActorComponent.h"
 #include "Engine/HitResult.h"
@@ -22,11 +23,27 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FMnhOnTracerStarted, FGameplayTag, T
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FMnhTracerComponentDestroyed);
 
+/* Points at the hit stored by the tracer that detected it, valid only for the duration of the OnHitsDetected broadcast */
+struct FMnhHitEvent
+{
+	FGameplayTag TracerTag;
+	const FHitResult* HitResult;
+	float DeltaTime;
+
+	const FHitResult& GetHitResult() const { return *HitResult; }
+};
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FMnhOnHitsDetected, UMnhTracerComponent*, TConstArrayView<FMnhHitEvent>);
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FMnhOnTracerHitDetected, FGameplayTag, const FHitResult&, float);
+DECLARE_DELEGATE_RetVal_ThreeParams(bool, FMnhValidateReplicatedHit, UMnhTracerComponent*, FGameplayTag, const FHitResult&);
+
 struct FMnhHitCache
 {
 	FHitResult HitResult;
 	FGameplayTag TracerTag;
 	int TickIdx;
+	// FMnhCoreAdapter::GetObjectKey of the hit actor, what the filters compare
+	uint64 ActorKey;
 };
 
 struct FTracerInitializationData
@@ -42,6 +59,9 @@ enum class EMnhFilterType : uint8
     FilterSameActorPerTracer UMETA(DisplayName="FilterSameActorPerTracer"),
 	None UMETA(DisplayName="None")
 };
+static_assert(uint8(EMnhFilterType::FilterSameActorAcrossAllTracers) == uint8(EMnhCoreFilterType::FilterSameActorAcrossAllTracers)
+	&& uint8(EMnhFilterType::FilterSameActorPerTracer) == uint8(EMnhCoreFilterType::FilterSameActorPerTracer)
+	&& uint8(EMnhFilterType::None) == uint8(EMnhCoreFilterType::None));
 
 UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent),
 	HideCategories=(Sockets, Navigation, Tags, ComponentTick, ComponentReplication,
@@ -54,17 +74,21 @@ class MISSNOHIT_API UMnhTracerComponent : public UActorComponent
 public:
 	// Sets default values for this component's properties
 	UMnhTracerComponent();
+	virtual void PostInitProperties() override;
+	virtual void OnRegister() override;
+	virtual void OnUnregister() override;
 	virtual void OnComponentDestroyed(bool bDestroyingHierarchy) override;
 
 	UPROPERTY(BlueprintAssignable)
 	FMnhOnHitDetected OnHitDetected;
+
+	/* Native alternative to OnHitDetected, receives every hit detected by this component during the frame in a single batch */
+	FMnhOnHitsDetected OnHitsDetected;
 	
 	FMnhOnTracerStarted OnTracerStarted;
 	FMnhOnTracerStopped OnTracerStopped;
 	FMnhTracerComponentDestroyed OnDestroyed;
 
-	FCriticalSection TraceDoneScopeLock;
-
 	TArray<FMnhHitCache> HitCache;
 	
 	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category="MissNoHit", meta=(FullyExpand=true, TitleProperty="TracerTag"))
@@ -77,6 +101,30 @@ public:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category="MissNoHit")
 	EMnhFilterType FilterType;
 
+	/* Sends each frame's hits as a single quantized message, the owning actor must replicate */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="MissNoHit|Replication")
+	EMnhHitReplicationMode HitReplicationMode = EMnhHitReplicationMode::None;
+
+	/* Called for hits received from another machine, local hits are only reported through OnHitDetected */
+	UPROPERTY(BlueprintAssignable)
+	FMnhOnHitDetected OnReplicatedHitDetected;
+
+	/* Client reported hits are re-swept against UMnhLagCompensationSubsystem when ValidateReplicatedHit is unbound, using the tracer
+	 * transforms of the server. Tracers must run on the server too and hurtboxes of the targets must be registered to the subsystem,
+	 * otherwise every hit is rejected. Read on BeginPlay */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="MissNoHit|Replication",
+		meta=(EditCondition="HitReplicationMode==EMnhHitReplicationMode::ClientReported", EditConditionHides))
+	bool bValidateWithLagCompensation = false;
+
+	/* Distance the tracer and the hurtboxes are grown by when re-sweeping reported hits */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="MissNoHit|Replication",
+		meta=(EditCondition="bValidateWithLagCompensation", EditConditionHides))
+	float LagCompensationTolerance = 10;
+
+	/* Server side check of hits reported by the owning client, takes precedence over bValidateWithLagCompensation.
+	 * Every hit is accepted when unbound and lag compensation is disabled */
+	FMnhValidateReplicatedHit ValidateReplicatedHit;
+
 	UFUNCTION(BlueprintCallable, Category="MissNoHit")
 	void InitializeTracers(const FGameplayTagContainer TracerTags, UPrimitiveComponent* TracerSource);
 
@@ -86,12 +134,18 @@ public:
 	UFUNCTION(BlueprintCallable, Category="MissNoHit")
 	void ResetHitCache();
 
+	/* Ignored actors are shared by all tracers of this component, TracerTags are kept for compatibility */
 	UFUNCTION(BlueprintCallable, Category="MissNoHit")
 	void AddToIgnoredActors(FGameplayTagContainer TracerTags, AActor* Actor);
 	
 	UFUNCTION(BlueprintCallable, Category="MissNoHit")
 	void AddToIgnoredActorsArray(const FGameplayTagContainer TracerTags, TArray<AActor*> Actors);
 
+	UFUNCTION(BlueprintCallable, Category="MissNoHit")
+	void RemoveFromIgnoredActors(AActor* Actor);
+
+	const TSharedRef<FMnhIgnoreSet>& GetIgnoreSet() const { return IgnoreSet; }
+
 	UFUNCTION(BlueprintCallable, Category="MissNoHit")
 	void StartTracers(FGameplayTagContainer TracerTags, bool bResetHitCache=true);
 
@@ -102,13 +156,31 @@ public:
 
 	void StopTracersDelayed(const FGameplayTagContainer& TracerTags);
 
+	/* Native listener that only receives hits from tracers with exactly matching tags, an empty container receives hits from every tracer */
+	FDelegateHandle SubscribeToTracerHits(const FGameplayTagContainer& TracerTags, const FMnhOnTracerHitDetected::FDelegate& Delegate);
+	void UnsubscribeFromTracerHits(const FGameplayTagContainer& TracerTags, FDelegateHandle DelegateHandle);
+
+	/* Registers the tracers of every given component with a single reservation, components registered this way skip registration on BeginPlay */
+	UFUNCTION(BlueprintCallable, Category="MissNoHit")
+	static void RegisterTracersBulk(const TArray<UMnhTracerComponent*>& TracerComponents);
+
 	UMnhTracer* FindTracer(FGameplayTag TracerTag);
 	int FindTracerConfig(FGameplayTag TracerTag);
+
+	/* Whether a Tracer Config or a deprecated Tracer has the tag */
+	bool HasTracer(FGameplayTag TracerTag) const;
+	
+	/* Incremented whenever TracerConfigs indices may change, used to invalidate cached config lookups */
+	uint32 GetTracerConfigsRevision() const { return TracerConfigsRevision; }
 	
 	int AddNewTracer(const FGameplayTag TracerTag, const EMnhTraceSource TraceSource, const FMnhTraceSettings& TraceSettings,
 		EMnhTracerTickType TracerTickType, int TargetFps, int TargetDistanceTraveled,
 		EDrawDebugTrace::Type DrawDebugType, float DrawDebugLifetime=0.5);
 
+	/* Adds a tracer that shares its settings with every other tracer using the same Definition */
+	UFUNCTION(BlueprintCallable, Category="MissNoHit")
+	void AddNewTracerFromDefinition(const FGameplayTag TracerTag, UMnhTracerDefinition* Definition);
+
 	UFUNCTION(BlueprintCallable, Category="MissNoHit")
 	void AddNewMnhComponentTracer(const FGameplayTag TracerTag,
 		FMnhTraceSettings TraceSettings, EMnhTracerTickType TracerTickType, int TargetFps, int TargetDistanceTraveled,
@@ -140,12 +212,92 @@ public:
 protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	virtual bool CheckFilters(const FHitResult& HitResult, FGameplayTag TracerTag, int TickIdxArg);
 
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerReportHits(const FMnhReplicatedHitBatch& HitBatch);
+
+	UFUNCTION(NetMulticast, Unreliable)
+	void MulticastConfirmedHits(const FMnhReplicatedHitBatch& HitBatch);
+
 public:
-	void OnTracerHitDetected(FGameplayTag TracerTag, const TArray<FHitResult>& HitResults, const float DeltaTime, const int TickIdx);
+	/* Returns the number of hits that passed the filters.
+	 * HitResults are copied for OnHitsDetected unless bHitResultsOutliveFlush promises they stay unchanged until FlushHitEvents */
+	int32 OnTracerHitDetected(FGameplayTag TracerTag, const TArray<FHitResult>& HitResults, const float DeltaTime, const int TickIdx,
+		bool bHitResultsOutliveFlush=false);
+	void FlushHitEvents();
+	/* Adds the heap memory owned by this component, tracer data slots are accounted by the module */
+	void GetMemoryUsage(FMnhMemoryUsage& OutUsage) const;
 
 private:
+	TArray<FMnhHitEvent> PendingHitEvents;
+	TArray<FMnhHitEvent> DispatchingHitEvents;
+	// Copies of hits whose caller does not keep them alive until the flush, inner arrays keep their addresses when the outer one grows
+	TArray<TArray<FHitResult>> PendingRetainedHitResults;
+	TArray<TArray<FHitResult>> DispatchingRetainedHitResults;
+	bool bIsPendingHitEventsFlush = false;
+
+	bool ShouldReplicateLocalHits() const;
+	void ReplicateHitEvents(TConstArrayView<FMnhHitEvent> HitEvents);
+
+	// Shared so subscribers can be added or removed while hits are being broadcast
+	// Keyed by the empty tag for subscribers of every tracer
+	TMap<FGameplayTag, TSharedRef<FMnhOnTracerHitDetected>> TracerHitSubscriptions;
+	FDelegateHandle SubscribeToTracerHits(FGameplayTag TracerTag, const FMnhOnTracerHitDetected::FDelegate& Delegate);
+	void UnsubscribeFromTracerHits(FGameplayTag TracerTag, FDelegateHandle DelegateHandle);
+
+	using FMnhTracerIndices = TArray<int, TInlineAllocator<2>>;
+	
+	// Built on PostInitProperties and OnRegister and kept up to date by AddNewTracer, multiple tracers can share the same tag
+	TMap<FGameplayTag, FMnhTracerIndices> TracerConfigIndicesByTag;
+	TMap<FGameplayTag, FMnhTracerIndices> TracerIndicesByTag;
+	uint32 TracerConfigsRevision = 0;
+	void RebuildTracerTagIndices();
+	
+	template <typename FunctorType>
+	static void ForEachTracerIndex(const FGameplayTagContainer& TracerTags, const TMap<FGameplayTag, FMnhTracerIndices>& IndicesByTag, FunctorType&& Functor)
+	{
+		for (const auto& TracerTag : TracerTags)
+		{
+			if (const auto TracerIndices = IndicesByTag.Find(TracerTag))
+			{
+				for (const int TracerIdx : *TracerIndices)
+				{
+					Functor(TracerIdx);
+				}
+			}
+		}
+	}
+
+	/* Functors must not add tracers, collect indices with ForEachTracerIndex first when they may */
+	template <typename FunctorType>
+	void ForEachTracerConfig(const FGameplayTagContainer& TracerTags, FunctorType&& Functor)
+	{
+		ForEachTracerIndex(TracerTags, TracerConfigIndicesByTag, [this, &Functor](const int TracerConfigIdx)
+		{
+			Functor(TracerConfigs[TracerConfigIdx]);
+		});
+	}
+
+	template <typename FunctorType>
+	void ForEachTracer(const FGameplayTagContainer& TracerTags, FunctorType&& Functor)
+	{
+		ForEachTracerIndex(TracerTags, TracerIndicesByTag, [this, &Functor](const int TracerIdx)
+		{
+			Functor(Tracers[TracerIdx].Get());
+		});
+	}
+
+	void StopTracersInternal(const FGameplayTagContainer& TracerTags, bool bStopImmediately);
+
+	TSharedRef<FMnhIgnoreSet> IgnoreSet = MakeShared<FMnhIgnoreSet>();
+
 	bool bIsInitialized = false;
+	bool bAreTracersRegistered = false;
 	TArray<FTracerInitializationData> EarlyTracerInitializations;
+
+	int GetNumTracersToRegister() const;
+	/* Returns the index after the last slot used */
+	int RegisterTracers(int FirstTracerDataIdx);
 };
@@ -56,12 +56,14 @@ public:
 	void StopEvent();
 
 protected:
-	UFUNCTION()
-	void OnHitDetected(FGameplayTag TracerTag, FHitResult HitResult, float DeltaTime);
+	void OnHitDetected(FGameplayTag TracerTag, const FHitResult& HitResult, float DeltaTime);
 
 	UFUNCTION()
 	void OnComponentDestroyed();
     
 private:
 	UObject* WorldContextObject;
+	FDelegateHandle HitSubscriptionHandle;
+	// Tags the hit subscription was made with, empty when the node listens to every tracer
+	FGameplayTagContainer SubscribedTracerTags;
 };
@@ -0,0 +1,189 @@
+﻿// Copyright 2024 Eren Balatkan. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MnhHelpers.h"
+#include "Engine/DataAsset.h"
+#include "Kismet/KismetSystemLibrary.h"
+#include "UObject/Package.h"
+#include "WorldCollision.h"
+#include "MnhTracerDefinition.generated.h"
+
+/**
+ * Immutable part of a tracer, can be shared by any number of Tracer Components.
+ * Per-instance state such as the source component, ignored actors and tracer state is kept by the tracers themselves.
+ */
+UCLASS(BlueprintType)
+class MISSNOHIT_API UMnhTracerDefinition : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	/* An enumeration that specifies the source of the tracer. It can be a shape component, a physics asset, or an animation notification.  */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="MissNoHit")
+	EMnhTraceSource TraceSource = EMnhTraceSource::MnhShapeComponent;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="MissNoHit",
+		meta=(EditCondition="(TraceSource==EMnhTraceSource::StaticMeshSockets||TraceSource==EMnhTraceSource::SkeletalMeshSockets)", EditConditionHides))
+	FName MeshSocket_1 = NAME_None;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="MissNoHit",
+		meta=(EditCondition="(TraceSource==EMnhTraceSource::StaticMeshSockets||TraceSource==EMnhTraceSource::SkeletalMeshSockets)", EditConditionHides))
+	FName MeshSocket_2 = NAME_None;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="MissNoHit",
+		meta=(EditCondition="(TraceSource==EMnhTraceSource::StaticMeshSockets||TraceSource==EMnhTraceSource::SkeletalMeshSockets)", EditConditionHides))
+	float MeshSocketTracerRadius = 10;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="MissNoHit",
+		meta=(EditCondition="(TraceSource==EMnhTraceSource::StaticMeshSockets||TraceSource==EMnhTraceSource::SkeletalMeshSockets)", EditConditionHides))
+	float MeshSocketTracerLengthOffset = 0;
+
+	/* Name of the Socket or Bone Tracer will be attached to */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="MissNoHit",
+		meta=(EditCondition="(TraceSource==EMnhTraceSource::SocketOrBone)||(TraceSource==EMnhTraceSource::PhysicsAsset)", EditConditionHides))
+	FName SocketOrBoneName;
+
+	/* Collision settings for the Tracer */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="MissNoHit")
+	FMnhTraceSettings TraceSettings;
+
+	/* Specifies how the tracer should tick. Sub-stepping is disabled on Match Game Tick */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="MissNoHit")
+	EMnhTracerTickType TracerTickType = EMnhTracerTickType::MatchGameTick;
+
+	/* Tick Rate of the Tracer */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="MissNoHit",
+		meta=(EditCondition="TracerTickType==EMnhTracerTickType::FixedRateTick", EditConditionHides))
+	int TargetFps = 30;
+
+	/* Distance traveled by Tracer between each Tick */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="MissNoHit",
+		meta=(EditCondition="TracerTickType==EMnhTracerTickType::DistanceTick", EditConditionHides))
+	int TickDistanceTraveled = 30;
+
+	/* Specifies which hit is kept when a sweep hits the same actor multiple times */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="MissNoHit")
+	FMnhHitSelectionSettings HitSelection;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="MissNoHit|Debug")
+	TEnumAsByte<EDrawDebugTrace::Type> DrawDebugType = EDrawDebugTrace::None;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="MissNoHit|Debug",
+		meta=(EditCondition="DrawDebugType!=EDrawDebugTrace::None", EditConditionHides))
+	FColor DebugTraceColor = FColor::Red;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="MissNoHit|Debug",
+		meta=(EditCondition="DrawDebugType!=EDrawDebugTrace::None", EditConditionHides))
+	FColor DebugTraceHitColor = FColor::Green;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="MissNoHit|Debug",
+			meta=(EditCondition="DrawDebugType!=EDrawDebugTrace::None", EditConditionHides))
+	FColor DebugTraceBlockColor = FColor::Blue;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="MissNoHit|Debug",
+		meta=(EditCondition="DrawDebugType==EDrawDebugTrace::ForDuration", EditConditionHides))
+	float DebugDrawTime = 0.5;
+
+	/* Derived from TracerTickType, TargetFps and TickDistanceTraveled */
+	float TickInterval = 0;
+
+	/* Derived from TraceSettings */
+	FCollisionObjectQueryParams ObjectQueryParams;
+
+	virtual void PostInitProperties() override;
+	virtual void PostLoad() override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+	void UpdateDerivedData();
+
+	/* Returns the transient definition shared by every Tracer Config or deprecated Tracer with the same inline properties,
+	 * only the first tracer of an archetype builds it */
+	template <typename SourceType>
+	static UMnhTracerDefinition* FindOrCreateShared(const SourceType& Source)
+	{
+		check(IsInGameThread());
+		const uint32 Hash = GetInlinePropertiesHash(Source);
+		for (auto It = SharedTransientDefinitions.CreateKeyIterator(Hash); It; ++It)
+		{
+			UMnhTracerDefinition* Definition = It.Value().Get();
+			if (!Definition)
+			{
+				It.RemoveCurrent();
+			}
+			else if (Definition->MatchesInlineProperties(Source))
+			{
+				return Definition;
+			}
+		}
+
+		UMnhTracerDefinition* Definition = CreateTransient(GetTransientPackage(), Source);
+		SharedTransientDefinitions.Add(Hash, Definition);
+		return Definition;
+	}
+
+	/* Builds a definition from the inline properties of a Tracer Config or a deprecated Tracer */
+	template <typename SourceType>
+	static UMnhTracerDefinition* CreateTransient(UObject* Outer, const SourceType& Source)
+	{
+		UMnhTracerDefinition* Definition = NewObject<UMnhTracerDefinition>(Outer, NAME_None, RF_Transient);
+		Definition->TraceSource = Source.TraceSource;
+		Definition->MeshSocket_1 = Source.MeshSocket_1;
+		Definition->MeshSocket_2 = Source.MeshSocket_2;
+		Definition->MeshSocketTracerRadius = Source.MeshSocketTracerRadius;
+		Definition->MeshSocketTracerLengthOffset = Source.MeshSocketTracerLengthOffset;
+		Definition->SocketOrBoneName = Source.SocketOrBoneName;
+		Definition->TraceSettings = Source.TraceSettings;
+		Definition->TracerTickType = Source.TracerTickType;
+		Definition->TargetFps = Source.TargetFps;
+		Definition->TickDistanceTraveled = Source.TickDistanceTraveled;
+		Definition->HitSelection = Source.HitSelection;
+		Definition->DrawDebugType = Source.DrawDebugType;
+		Definition->DebugTraceColor = Source.DebugTraceColor;
+		Definition->DebugTraceHitColor = Source.DebugTraceHitColor;
+		Definition->DebugTraceBlockColor = Source.DebugTraceBlockColor;
+		Definition->DebugDrawTime = Source.DebugDrawTime;
+		Definition->UpdateDerivedData();
+		return Definition;
+	}
+
+private:
+	// Kept alive by the tracers referencing them, entries of collected definitions are dropped on lookup
+	static TMultiMap<uint32, TWeakObjectPtr<UMnhTracerDefinition>> SharedTransientDefinitions;
+
+	template <typename SourceType>
+	static uint32 GetInlinePropertiesHash(const SourceType& Source)
+	{
+		uint32 Hash = HashCombineFast(GetTypeHash(Source.TraceSource), GetTypeHash(Source.TracerTickType));
+		Hash = HashCombineFast(Hash, GetTypeHash(Source.SocketOrBoneName));
+		Hash = HashCombineFast(Hash, GetTypeHash(Source.MeshSocket_1));
+		Hash = HashCombineFast(Hash, GetTypeHash(Source.MeshSocket_2));
+		Hash = HashCombineFast(Hash, GetTypeHash(Source.TraceSettings.TraceChannel.GetValue()));
+		Hash = HashCombineFast(Hash, GetTypeHash(Source.TraceSettings.ProfileName));
+		return HashCombineFast(Hash, GetTypeHash(Source.DrawDebugType.GetValue()));
+	}
+
+	template <typename SourceType>
+	bool MatchesInlineProperties(const SourceType& Source) const
+	{
+		return TraceSource == Source.TraceSource
+			&& MeshSocket_1 == Source.MeshSocket_1
+			&& MeshSocket_2 == Source.MeshSocket_2
+			&& MeshSocketTracerRadius == Source.MeshSocketTracerRadius
+			&& MeshSocketTracerLengthOffset == Source.MeshSocketTracerLengthOffset
+			&& SocketOrBoneName == Source.SocketOrBoneName
+			&& TracerTickType == Source.TracerTickType
+			&& TargetFps == Source.TargetFps
+			&& TickDistanceTraveled == Source.TickDistanceTraveled
+			&& DrawDebugType == Source.DrawDebugType
+			&& DebugTraceColor == Source.DebugTraceColor
+			&& DebugTraceHitColor == Source.DebugTraceHitColor
+			&& DebugTraceBlockColor == Source.DebugTraceBlockColor
+			&& DebugDrawTime == Source.DebugDrawTime
+			&& FMnhTraceSettings::StaticStruct()->CompareScriptStruct(&TraceSettings, &Source.TraceSettings, PPF_None)
+			&& FMnhHitSelectionSettings::StaticStruct()->CompareScriptStruct(&HitSelection, &Source.HitSelection, PPF_None);
+	}
+};
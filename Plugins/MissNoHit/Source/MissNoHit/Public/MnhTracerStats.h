@@ -0,0 +1,109 @@
+﻿// Copyright 2024 Eren Balatkan. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "MnhHelpers.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include <atomic>
+
+#ifndef MNH_WITH_TRACER_STATS
+#define MNH_WITH_TRACER_STATS !UE_BUILD_SHIPPING
+#endif
+
+struct FMnhTracerCounters
+{
+	uint64 NumTicks = 0;
+	uint64 NumSweeps = 0;
+	uint64 NumHits = 0;
+	// Hits dropped by the Tracer Component filters
+	uint64 NumFilteredHits = 0;
+	uint64 SweepCycles = 0;
+	double ActiveTime = 0;
+
+	double GetSweepMicroseconds() const { return FPlatformTime::ToMilliseconds64(SweepCycles) * 1000.0; }
+
+	void Add(const FMnhTracerCounters& Other)
+	{
+		NumTicks += Other.NumTicks;
+		NumSweeps += Other.NumSweeps;
+		NumHits += Other.NumHits;
+		NumFilteredHits += Other.NumFilteredHits;
+		SweepCycles += Other.SweepCycles;
+		ActiveTime += Other.ActiveTime;
+	}
+};
+
+struct FMnhTracerStatsKey
+{
+	FGameplayTag TracerTag;
+	FName OwnerClass;
+	EMnhTracerTickType TracerTickType = EMnhTracerTickType::MatchGameTick;
+
+	bool operator==(const FMnhTracerStatsKey& Other) const
+	{
+		return TracerTag == Other.TracerTag && OwnerClass == Other.OwnerClass && TracerTickType == Other.TracerTickType;
+	}
+
+	friend uint32 GetTypeHash(const FMnhTracerStatsKey& Key)
+	{
+		return HashCombine(HashCombine(GetTypeHash(Key.TracerTag), GetTypeHash(Key.OwnerClass)), uint32(Key.TracerTickType));
+	}
+};
+
+/* Counters of every tracer sharing a tag, owner class and tick type. Workers add to it without locking */
+struct FMnhTracerStatsEntry
+{
+	FMnhTracerStatsKey Key;
+	FMnhTracerCounters Totals;
+	FMnhTracerCounters LastFrame;
+#if CSV_PROFILER
+	FName CsvSweepTimeStatName;
+	FName CsvSweepsStatName;
+#endif
+
+	void Add(const FMnhTracerCounters& Counters)
+	{
+		NumTicks.fetch_add(Counters.NumTicks, std::memory_order_relaxed);
+		NumSweeps.fetch_add(Counters.NumSweeps, std::memory_order_relaxed);
+		NumHits.fetch_add(Counters.NumHits, std::memory_order_relaxed);
+		NumFilteredHits.fetch_add(Counters.NumFilteredHits, std::memory_order_relaxed);
+		SweepCycles.fetch_add(Counters.SweepCycles, std::memory_order_relaxed);
+		ActiveTimeMicroseconds.fetch_add(uint64(Counters.ActiveTime * 1000000.0), std::memory_order_relaxed);
+	}
+
+	/* Moves this frame's counters into LastFrame and Totals, called on the game thread once workers are done */
+	void EndFrame();
+
+private:
+	std::atomic<uint64> NumTicks = 0;
+	std::atomic<uint64> NumSweeps = 0;
+	std::atomic<uint64> NumHits = 0;
+	std::atomic<uint64> NumFilteredHits = 0;
+	std::atomic<uint64> SweepCycles = 0;
+	std::atomic<uint64> ActiveTimeMicroseconds = 0;
+};
+
+/**
+ * Per tag, owner class and tick type tracer counters. Surfaced through stat MissNoHit, the MissNoHit CSV profiler
+ * category and the MissNoHit.Stats.Dump console command.
+ */
+class MISSNOHIT_API FMnhTracerStats
+{
+public:
+	static FMnhTracerStats& Get();
+
+	/* Game thread only, entries are never removed so the returned pointer stays valid until Reset */
+	FMnhTracerStatsEntry* FindOrAddEntry(const FMnhTracerStatsKey& Key);
+	void EndFrame(int32 NumActiveTracers);
+	/* Entries sorted by sweep cost, most expensive first */
+	void Dump(FOutputDevice& Ar) const;
+	void ResetTotals();
+
+	int32 GetNumEntries() const { return Entries.Num(); }
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	TMap<FMnhTracerStatsKey, TUniquePtr<FMnhTracerStatsEntry>> Entries;
+};
@@ -0,0 +1,32 @@
+﻿// Copyright 2024 Eren Balatkan. All Rights Reserved.
+
+using UnrealBuildTool;
+
+public class MissNoHitBenchmark : ModuleRules
+{
+	public MissNoHitBenchmark(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+		
+		bUseUnity = false;
+		
+		PublicDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"Core",
+				"GameplayTags",
+				"MissNoHit"
+			}
+			);
+			
+		
+		PrivateDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"CoreUObject",
+				"Engine",
+				"Json"
+			}
+			);
+	}
+}
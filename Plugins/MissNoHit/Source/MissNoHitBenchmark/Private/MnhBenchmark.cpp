@@ -0,0 +1,407 @@
+﻿// Copyright 2024 Eren Balatkan. All Rights Reserved.
+
+#include "MnhBenchmark.h"
+
+#include "EngineUtils.h"
+#include "MissNoHit.h"
+#include "MnhComponents.h"
+#include "MnhTracerComponent.h"
+#include "NativeGameplayTags.h"
+#include "Components/SphereComponent.h"
+#include "Dom/JsonObject.h"
+#include "Engine/CollisionProfile.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/App.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonSerializer.h"
+
+namespace MnhBenchmark
+{
+	UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_Tracer0, "MissNoHit.Benchmark.Tracer0");
+	UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_Tracer1, "MissNoHit.Benchmark.Tracer1");
+	UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_Tracer2, "MissNoHit.Benchmark.Tracer2");
+	UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_Tracer3, "MissNoHit.Benchmark.Tracer3");
+	UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_Tracer4, "MissNoHit.Benchmark.Tracer4");
+	UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_Tracer5, "MissNoHit.Benchmark.Tracer5");
+	UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_Tracer6, "MissNoHit.Benchmark.Tracer6");
+	UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_Tracer7, "MissNoHit.Benchmark.Tracer7");
+
+	FGameplayTag GetTracerTag(const int32 TracerIdx)
+	{
+		static const FNativeGameplayTag* Tags[FMnhBenchmarkSettings::MaxTracersPerComponent] = {
+			&TAG_Tracer0, &TAG_Tracer1, &TAG_Tracer2, &TAG_Tracer3, &TAG_Tracer4, &TAG_Tracer5, &TAG_Tracer6, &TAG_Tracer7};
+		return Tags[TracerIdx]->GetTag();
+	}
+
+	template <typename EnumType>
+	void ParseEnumList(const TCHAR* CommandLine, const TCHAR* Key, TArray<EnumType>& OutValues)
+	{
+		FString ValueList;
+		if (!FParse::Value(CommandLine, Key, ValueList, false))
+		{
+			return;
+		}
+		TArray<FString> ValueNames;
+		ValueList.ParseIntoArray(ValueNames, TEXT(","));
+		OutValues.Reset();
+		for (const auto& ValueName : ValueNames)
+		{
+			const int64 Value = StaticEnum<EnumType>()->GetValueByNameString(ValueName);
+			if (Value != INDEX_NONE)
+			{
+				OutValues.Add(EnumType(Value));
+			}
+		}
+	}
+
+	template <typename EnumType>
+	TArray<TSharedPtr<FJsonValue>> EnumListToJson(const TArray<EnumType>& Values)
+	{
+		TArray<TSharedPtr<FJsonValue>> JsonValues;
+		for (const auto Value : Values)
+		{
+			JsonValues.Add(MakeShared<FJsonValueString>(StaticEnum<EnumType>()->GetNameStringByValue(int64(Value))));
+		}
+		return JsonValues;
+	}
+}
+
+void FMnhBenchmarkSettings::ParseCommandLine(const TCHAR* CommandLine)
+{
+	FParse::Value(CommandLine, TEXT("MnhBench.Name="), Name);
+	FParse::Value(CommandLine, TEXT("MnhBench.NumComponents="), NumComponents);
+	FParse::Value(CommandLine, TEXT("MnhBench.TracersPerComponent="), TracersPerComponent);
+	FParse::Value(CommandLine, TEXT("MnhBench.ActiveRatio="), ActiveRatio);
+	MnhBenchmark::ParseEnumList(CommandLine, TEXT("MnhBench.Shapes="), Shapes);
+	MnhBenchmark::ParseEnumList(CommandLine, TEXT("MnhBench.TickTypes="), TickTypes);
+	FParse::Value(CommandLine, TEXT("MnhBench.TargetFps="), TargetFps);
+	FParse::Value(CommandLine, TEXT("MnhBench.TickDistanceTraveled="), TickDistanceTraveled);
+	FParse::Value(CommandLine, TEXT("MnhBench.ArenaRadius="), ArenaRadius);
+	FParse::Value(CommandLine, TEXT("MnhBench.TargetDensity="), TargetDensity);
+	FParse::Value(CommandLine, TEXT("MnhBench.TargetRadius="), TargetRadius);
+	FParse::Value(CommandLine, TEXT("MnhBench.SwingRadius="), SwingRadius);
+	FParse::Value(CommandLine, TEXT("MnhBench.SwingSpeed="), SwingSpeed);
+	FParse::Value(CommandLine, TEXT("MnhBench.WarmupFrames="), WarmupFrames);
+	FParse::Value(CommandLine, TEXT("MnhBench.NumFrames="), NumFrames);
+	FParse::Value(CommandLine, TEXT("MnhBench.DeltaTime="), DeltaTime);
+	FParse::Value(CommandLine, TEXT("MnhBench.RandomSeed="), RandomSeed);
+
+	TracersPerComponent = FMath::Clamp(TracersPerComponent, 1, MaxTracersPerComponent);
+	ActiveRatio = FMath::Clamp(ActiveRatio, 0.f, 1.f);
+	if (Shapes.Num() == 0)
+	{
+		Shapes.Add(EMnhTraceShape::Sphere);
+	}
+	if (TickTypes.Num() == 0)
+	{
+		TickTypes.Add(EMnhTracerTickType::MatchGameTick);
+	}
+}
+
+TSharedRef<FJsonObject> FMnhBenchmarkSettings::ToJson() const
+{
+	auto Json = MakeShared<FJsonObject>();
+	Json->SetStringField(TEXT("Name"), Name);
+	Json->SetNumberField(TEXT("NumComponents"), NumComponents);
+	Json->SetNumberField(TEXT("TracersPerComponent"), TracersPerComponent);
+	Json->SetNumberField(TEXT("ActiveRatio"), ActiveRatio);
+	Json->SetArrayField(TEXT("Shapes"), MnhBenchmark::EnumListToJson(Shapes));
+	Json->SetArrayField(TEXT("TickTypes"), MnhBenchmark::EnumListToJson(TickTypes));
+	Json->SetNumberField(TEXT("TargetFps"), TargetFps);
+	Json->SetNumberField(TEXT("TickDistanceTraveled"), TickDistanceTraveled);
+	Json->SetNumberField(TEXT("ArenaRadius"), ArenaRadius);
+	Json->SetNumberField(TEXT("TargetDensity"), TargetDensity);
+	Json->SetNumberField(TEXT("TargetRadius"), TargetRadius);
+	Json->SetNumberField(TEXT("SwingRadius"), SwingRadius);
+	Json->SetNumberField(TEXT("SwingSpeed"), SwingSpeed);
+	Json->SetNumberField(TEXT("WarmupFrames"), WarmupFrames);
+	Json->SetNumberField(TEXT("NumFrames"), NumFrames);
+	Json->SetNumberField(TEXT("DeltaTime"), DeltaTime);
+	Json->SetNumberField(TEXT("RandomSeed"), RandomSeed);
+	return Json;
+}
+
+FMnhBenchmarkPhaseStats FMnhBenchmarkPhaseStats::FromSamples(TArray<double>& SamplesMs)
+{
+	FMnhBenchmarkPhaseStats Stats;
+	if (SamplesMs.Num() == 0)
+	{
+		return Stats;
+	}
+
+	SamplesMs.Sort();
+	double Sum = 0;
+	for (const double Sample : SamplesMs)
+	{
+		Sum += Sample;
+	}
+	Stats.MeanMs = Sum / SamplesMs.Num();
+	Stats.MedianMs = SamplesMs[SamplesMs.Num() / 2];
+	Stats.P95Ms = SamplesMs[FMath::Min(SamplesMs.Num() - 1, FMath::FloorToInt(SamplesMs.Num() * 0.95))];
+	Stats.MaxMs = SamplesMs.Last();
+	return Stats;
+}
+
+TSharedRef<FJsonObject> FMnhBenchmarkPhaseStats::ToJson() const
+{
+	auto Json = MakeShared<FJsonObject>();
+	Json->SetNumberField(TEXT("MeanMs"), MeanMs);
+	Json->SetNumberField(TEXT("MedianMs"), MedianMs);
+	Json->SetNumberField(TEXT("P95Ms"), P95Ms);
+	Json->SetNumberField(TEXT("MaxMs"), MaxMs);
+	return Json;
+}
+
+TSharedRef<FJsonObject> FMnhBenchmarkResult::ToJson() const
+{
+	auto Phases = MakeShared<FJsonObject>();
+	Phases->SetObjectField(TEXT("ApplyTracerCommands"), ApplyTracerCommands.ToJson());
+	Phases->SetObjectField(TEXT("UpdateTracerTransforms"), UpdateTracerTransforms.ToJson());
+	Phases->SetObjectField(TEXT("PerformTraces"), PerformTraces.ToJson());
+	Phases->SetObjectField(TEXT("NotifyTraceResults"), NotifyTraceResults.ToJson());
+	Phases->SetObjectField(TEXT("FlushHitEvents"), FlushHitEvents.ToJson());
+	Phases->SetObjectField(TEXT("Total"), Total.ToJson());
+
+	auto Memory = MakeShared<FJsonObject>();
+	Memory->SetNumberField(TEXT("ModuleAllocatedBytes"), ModuleAllocatedBytes);
+	Memory->SetNumberField(TEXT("UsedPhysicalDeltaBytes"), UsedPhysicalDeltaBytes);
+
+	auto Json = MakeShared<FJsonObject>();
+	Json->SetObjectField(TEXT("Settings"), Settings.ToJson());
+	Json->SetStringField(TEXT("Platform"), FPlatformProperties::IniPlatformName());
+	Json->SetStringField(TEXT("BuildConfiguration"), LexToString(FApp::GetBuildConfiguration()));
+	Json->SetNumberField(TEXT("NumTracers"), NumTracers);
+	Json->SetNumberField(TEXT("NumActiveTracers"), NumActiveTracers);
+	Json->SetNumberField(TEXT("NumTargets"), NumTargets);
+	Json->SetNumberField(TEXT("NumHits"), NumHits);
+	Json->SetObjectField(TEXT("Phases"), Phases);
+	Json->SetObjectField(TEXT("Memory"), Memory);
+	return Json;
+}
+
+bool FMnhBenchmark::Run(const FMnhBenchmarkSettings& Settings, FMnhBenchmarkResult& OutResult)
+{
+	OutResult = FMnhBenchmarkResult();
+	OutResult.Settings = Settings;
+	if (!GEngine)
+	{
+		return false;
+	}
+
+	const int64 UsedPhysicalBefore = FPlatformMemory::GetStats().UsedPhysical;
+	FRandomStream RandomStream(Settings.RandomSeed);
+
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("MnhBenchmarkWorld"));
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+	World->InitializeActorsForPlay(FURL());
+	World->BeginPlay();
+
+	// Targets, static spheres scattered over the arena floor
+	const float ArenaArea = UE_PI * FMath::Square(Settings.ArenaRadius / 100.f);
+	OutResult.NumTargets = FMath::Max(1, FMath::RoundToInt(ArenaArea * Settings.TargetDensity));
+	for (int32 TargetIdx = 0; TargetIdx < OutResult.NumTargets; TargetIdx++)
+	{
+		AActor* Target = World->SpawnActor<AActor>();
+		USphereComponent* Body = NewObject<USphereComponent>(Target);
+		Body->SetSphereRadius(Settings.TargetRadius);
+		Body->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+		Target->SetRootComponent(Body);
+		Body->RegisterComponent();
+		const FVector2D Location = FVector2D(RandomStream.VRand()).GetSafeNormal() * Settings.ArenaRadius * FMath::Sqrt(RandomStream.FRand());
+		Target->SetActorLocation(FVector(Location, 0));
+	}
+
+	// Attackers, every tracer rides a shape component on a spinning arm
+	TArray<AActor*> Attackers;
+	int64 NumHits = 0;
+	for (int32 ComponentIdx = 0; ComponentIdx < Settings.NumComponents; ComponentIdx++)
+	{
+		AActor* Attacker = World->SpawnActor<AActor>();
+		USceneComponent* Root = NewObject<USceneComponent>(Attacker);
+		Attacker->SetRootComponent(Root);
+		Root->RegisterComponent();
+		const FVector2D Location = FVector2D(RandomStream.VRand()).GetSafeNormal() * Settings.ArenaRadius * FMath::Sqrt(RandomStream.FRand());
+		Attacker->SetActorLocationAndRotation(FVector(Location, 0), FRotator(0, RandomStream.FRandRange(0, 360), 0));
+
+		UMnhTracerComponent* TracerComponent = NewObject<UMnhTracerComponent>(Attacker);
+		TArray<UPrimitiveComponent*> TracerSources;
+		for (int32 TracerIdx = 0; TracerIdx < Settings.TracersPerComponent; TracerIdx++)
+		{
+			const int32 VariantIdx = ComponentIdx * Settings.TracersPerComponent + TracerIdx;
+			UShapeComponent* Shape = nullptr;
+			switch (Settings.Shapes[VariantIdx % Settings.Shapes.Num()])
+			{
+			case EMnhTraceShape::Sphere:
+				Shape = NewObject<UMnhSphereComponent>(Attacker);
+				break;
+			case EMnhTraceShape::Box:
+				Shape = NewObject<UMnhBoxComponent>(Attacker);
+				break;
+			case EMnhTraceShape::Capsule:
+				Shape = NewObject<UMnhCapsuleComponent>(Attacker);
+				break;
+			}
+			Shape->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+			Shape->SetupAttachment(Root);
+			Shape->SetRelativeLocation(FVector(Settings.SwingRadius, 0, 20.f * TracerIdx));
+			Shape->RegisterComponent();
+			TracerSources.Add(Shape);
+
+			const auto TickType = Settings.TickTypes[VariantIdx % Settings.TickTypes.Num()];
+			TracerComponent->AddNewTracer(MnhBenchmark::GetTracerTag(TracerIdx), EMnhTraceSource::MnhShapeComponent,
+				FMnhTraceSettings(), TickType, Settings.TargetFps, Settings.TickDistanceTraveled, EDrawDebugTrace::None);
+		}
+
+		// Registering after the tracers are added lets BeginPlay register all of them at once
+		TracerComponent->RegisterComponent();
+		TracerComponent->OnHitsDetected.AddLambda([&NumHits](UMnhTracerComponent*, const TConstArrayView<FMnhHitEvent> HitEvents)
+		{
+			NumHits += HitEvents.Num();
+		});
+
+		FGameplayTagContainer ActiveTracerTags;
+		for (int32 TracerIdx = 0; TracerIdx < Settings.TracersPerComponent; TracerIdx++)
+		{
+			const FGameplayTag TracerTag = MnhBenchmark::GetTracerTag(TracerIdx);
+			TracerComponent->InitializeTracers(FGameplayTagContainer(TracerTag), TracerSources[TracerIdx]);
+			OutResult.NumTracers++;
+			if (RandomStream.FRand() < Settings.ActiveRatio)
+			{
+				ActiveTracerTags.AddTag(TracerTag);
+				OutResult.NumActiveTracers++;
+			}
+		}
+		TracerComponent->StartTracers(ActiveTracerTags);
+		Attackers.Add(Attacker);
+	}
+
+	// Scene queries only see bodies the physics scene has synced, one world tick flushes the spawned targets into it
+	World->Tick(LEVELTICK_All, Settings.DeltaTime);
+
+	FMissNoHitModule& MnhModule = FMissNoHitModule::Get();
+	TArray<double> ApplyTracerCommandsMs, UpdateTracerTransformsMs, PerformTracesMs, NotifyTraceResultsMs, FlushHitEventsMs, TotalMs;
+	const FRotator SwingDelta(0, Settings.SwingSpeed * Settings.DeltaTime, 0);
+	for (int32 FrameIdx = 0; FrameIdx < Settings.WarmupFrames + Settings.NumFrames; FrameIdx++)
+	{
+		for (AActor* Attacker : Attackers)
+		{
+			Attacker->AddActorWorldRotation(SwingDelta);
+		}
+		MnhModule.Tick(Settings.DeltaTime);
+
+		if (FrameIdx == Settings.WarmupFrames)
+		{
+			NumHits = 0;
+		}
+		if (FrameIdx >= Settings.WarmupFrames)
+		{
+			const auto& Timings = MnhModule.GetLastTickTimings();
+			ApplyTracerCommandsMs.Add(Timings.ApplyTracerCommands * 1000.0);
+			UpdateTracerTransformsMs.Add(Timings.UpdateTracerTransforms * 1000.0);
+			PerformTracesMs.Add(Timings.PerformTraces * 1000.0);
+			NotifyTraceResultsMs.Add(Timings.NotifyTraceResults * 1000.0);
+			FlushHitEventsMs.Add(Timings.FlushHitEvents * 1000.0);
+			TotalMs.Add(Timings.Total * 1000.0);
+		}
+	}
+
+	OutResult.NumHits = NumHits;
+	OutResult.ApplyTracerCommands = FMnhBenchmarkPhaseStats::FromSamples(ApplyTracerCommandsMs);
+	OutResult.UpdateTracerTransforms = FMnhBenchmarkPhaseStats::FromSamples(UpdateTracerTransformsMs);
+	OutResult.PerformTraces = FMnhBenchmarkPhaseStats::FromSamples(PerformTracesMs);
+	OutResult.NotifyTraceResults = FMnhBenchmarkPhaseStats::FromSamples(NotifyTraceResultsMs);
+	OutResult.FlushHitEvents = FMnhBenchmarkPhaseStats::FromSamples(FlushHitEventsMs);
+	OutResult.Total = FMnhBenchmarkPhaseStats::FromSamples(TotalMs);
+	OutResult.ModuleAllocatedBytes = MnhModule.GetAllocatedSize();
+	OutResult.UsedPhysicalDeltaBytes = int64(FPlatformMemory::GetStats().UsedPhysical) - UsedPhysicalBefore;
+
+	// Destroying the components releases their tracers, the next tick returns the slots to the pool
+	for (TActorIterator<AActor> It(World); It; ++It)
+	{
+		It->Destroy();
+	}
+	MnhModule.Tick(Settings.DeltaTime);
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	return true;
+}
+
+FString FMnhBenchmark::WriteJson(const FMnhBenchmarkResult& Result)
+{
+	FString OutputDir = FPaths::ProjectSavedDir() / TEXT("Benchmarks") / TEXT("MissNoHit");
+	FParse::Value(FCommandLine::Get(), TEXT("MnhBench.OutputDir="), OutputDir);
+	const FString FilePath = OutputDir / (Result.Settings.Name + TEXT(".json"));
+
+	FString JsonString;
+	FJsonSerializer::Serialize(Result.ToJson(), TJsonWriterFactory<>::Create(&JsonString));
+	return FFileHelper::SaveStringToFile(JsonString, *FilePath) ? FilePath : FString();
+}
+
+#if WITH_AUTOMATION_TESTS
+
+IMPLEMENT_COMPLEX_AUTOMATION_TEST(FMnhScalabilityBenchmark, "MissNoHit.Benchmark.Scalability",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+void FMnhScalabilityBenchmark::GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const
+{
+	// Components x tracers per component
+	const TCHAR* Presets[] = {TEXT("Duel:2x2"), TEXT("Skirmish:20x2"), TEXT("Brawl:100x3"), TEXT("Horde:500x2"), TEXT("Stress:2000x4")};
+	for (const TCHAR* Preset : Presets)
+	{
+		FString Name, Size;
+		FString(Preset).Split(TEXT(":"), &Name, &Size);
+		OutBeautifiedNames.Add(Name);
+		OutTestCommands.Add(Preset);
+	}
+	// Takes its settings from the command line, presets always run as defined so their results stay comparable
+	OutBeautifiedNames.Add(TEXT("Custom"));
+	OutTestCommands.Add(TEXT("Custom"));
+}
+
+bool FMnhScalabilityBenchmark::RunTest(const FString& Parameters)
+{
+	FMnhBenchmarkSettings Settings;
+	FString Name, Size;
+	if (Parameters.Split(TEXT(":"), &Name, &Size))
+	{
+		FString NumComponents, TracersPerComponent;
+		Size.Split(TEXT("x"), &NumComponents, &TracersPerComponent);
+		Settings.Name = Name;
+		Settings.NumComponents = FCString::Atoi(*NumComponents);
+		Settings.TracersPerComponent = FCString::Atoi(*TracersPerComponent);
+	}
+	else
+	{
+		Settings.Name = Parameters;
+		Settings.ParseCommandLine(FCommandLine::Get());
+	}
+
+	FMnhBenchmarkResult Result;
+	if (!FMnhBenchmark::Run(Settings, Result))
+	{
+		AddError(TEXT("MissNoHit benchmark could not create its world"));
+		return false;
+	}
+
+	const FString FilePath = FMnhBenchmark::WriteJson(Result);
+	AddInfo(FString::Printf(TEXT("%s: %d tracers (%d active), %d targets, total %.3f ms mean, %.3f ms p95, PerformTraces %.3f ms mean, %lld hits"),
+		*Settings.Name, Result.NumTracers, Result.NumActiveTracers, Result.NumTargets, Result.Total.MeanMs, Result.Total.P95Ms,
+		Result.PerformTraces.MeanMs, Result.NumHits));
+	if (FilePath.IsEmpty())
+	{
+		AddWarning(TEXT("MissNoHit benchmark results could not be written"));
+	}
+	else
+	{
+		AddInfo(FString::Printf(TEXT("Results written to %s"), *FilePath));
+	}
+	return true;
+}
+
+#endif
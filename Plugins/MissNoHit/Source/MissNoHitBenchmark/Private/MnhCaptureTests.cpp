@@ -0,0 +1,83 @@
+﻿// Copyright 2024 Eren Balatkan. All Rights Reserved.
+
+#include "MnhCapture.h"
+#include "MnhTracerComponent.h"
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/Paths.h"
+
+#if WITH_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMnhCaptureRoundTripTest, "MissNoHit.Capture.RoundTrip",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FMnhCaptureRoundTripTest::RunTest(const FString& Parameters)
+{
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("MnhCaptureTestWorld"));
+	AActor* Owner = World->SpawnActor<AActor>();
+	AActor* IgnoredActor = World->SpawnActor<AActor>();
+	AActor* LateIgnoredActor = World->SpawnActor<AActor>();
+
+	UMnhTracerDefinition* Definition = NewObject<UMnhTracerDefinition>(GetTransientPackage(), NAME_None, RF_Transient);
+	Definition->TraceSettings.TraceChannel = ECC_WorldDynamic;
+	Definition->UpdateDerivedData();
+
+	const auto IgnoreSet = MakeShared<FMnhIgnoreSet>();
+	IgnoreSet->AddIgnoredActor(Owner);
+	IgnoreSet->AddIgnoredActor(IgnoredActor);
+
+	FMnhTracerData TracerData;
+	TracerData.Definition = Definition;
+	TracerData.Guid = FGuid::NewGuid();
+	TracerData.World = World;
+	TracerData.OwnerTracerComponent = NewObject<UMnhTracerComponent>(Owner);
+	TracerData.TracerTickType = EMnhTracerTickType::MatchGameTick;
+	TracerData.ShapeData.TraceShape = EMnhTraceShape::Sphere;
+	TracerData.ShapeData.Radius = 10;
+	TracerData.IgnoreSet = IgnoreSet;
+	TracerData.TracerState = EMnhTracerState::Active;
+	TracerData.bShouldTickThisFrame = true;
+	TracerData.TracerTransformsOverTime.Add(FTransform(FVector(0, 0, 0)));
+	TracerData.TracerTransformsOverTime.Add(FTransform(FVector(100, 0, 0)));
+
+	// Second frame changes the shape and the ignore set, both have to reach the replay
+	const FString FilePath = FPaths::AutomationTransientDir() / TEXT("MnhCaptureRoundTrip.mnhcap");
+	{
+		FMnhCaptureRecorder Recorder;
+		if (!Recorder.Open(FilePath))
+		{
+			AddError(TEXT("Could not open the capture file for writing"));
+			World->DestroyWorld(false);
+			return false;
+		}
+		Recorder.RecordFrame(1, 1 / 60.f, MakeArrayView(&TracerData, 1));
+		TracerData.ShapeData.Radius = 25;
+		IgnoreSet->AddIgnoredActor(LateIgnoredActor);
+		Recorder.RecordFrame(2, 1 / 60.f, MakeArrayView(&TracerData, 1));
+	}
+
+	FMnhCapturePlayer Player;
+	FMnhCaptureReplayStats Stats;
+	const bool bReplayed = Player.Open(FilePath) && Player.Replay(World, Stats);
+	TestTrue(TEXT("Capture replays"), bReplayed);
+	TestEqual(TEXT("Replayed frames"), Stats.NumFrames, 2);
+	TestEqual(TEXT("Replayed tracers"), Stats.NumTracers, 1);
+	if (bReplayed && Player.GetTracers().Num() == 1)
+	{
+		const FMnhTracerData& ReplayedTracer = Player.GetTracers()[0];
+		TestEqual(TEXT("Shape change is replayed"), ReplayedTracer.ShapeData.Radius, 25.f);
+		TestEqual(TEXT("Trace channel"), int32(ReplayedTracer.Definition->TraceSettings.TraceChannel), int32(ECC_WorldDynamic));
+		const auto IgnoredActorIds = ReplayedTracer.IgnoreSet->GetIgnoredActorIds();
+		TestEqual(TEXT("Ignored actors"), IgnoredActorIds.Num(), 3);
+		TestTrue(TEXT("Owner is ignored"), IgnoredActorIds.Contains(Owner->GetUniqueID()));
+		TestTrue(TEXT("Recorded actor is ignored"), IgnoredActorIds.Contains(IgnoredActor->GetUniqueID()));
+		TestTrue(TEXT("Actor ignored after the first frame is ignored"), IgnoredActorIds.Contains(LateIgnoredActor->GetUniqueID()));
+	}
+
+	IFileManager::Get().Delete(*FilePath);
+	World->DestroyWorld(false);
+	return true;
+}
+
+#endif
@@ -0,0 +1,86 @@
+﻿// Copyright 2024 Eren Balatkan. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MnhHelpers.h"
+
+class FJsonObject;
+
+/**
+ * Synthetic arena for the MissNoHit scalability benchmark. Attackers spin their tracers through randomly placed targets.
+ * Presets run as defined. The Custom test takes every field from the command line with MnhBench.<Field>=<Value>,
+ * e.g. MnhBench.NumComponents=500, results are written as <Name>.json so presets and custom runs never overwrite each other.
+ * Headless run: UnrealEditor-Cmd <Project> -ExecCmds="Automation RunTests MissNoHit.Benchmark; Quit" -nullrhi -unattended
+ */
+struct MISSNOHITBENCHMARK_API FMnhBenchmarkSettings
+{
+	FString Name = TEXT("Default");
+	int32 NumComponents = 100;
+	/* Up to MaxTracersPerComponent, each tracer gets its own shape component */
+	int32 TracersPerComponent = 2;
+	float ActiveRatio = 0.5f;
+	TArray<EMnhTraceShape> Shapes = {EMnhTraceShape::Sphere, EMnhTraceShape::Box, EMnhTraceShape::Capsule};
+	TArray<EMnhTracerTickType> TickTypes = {EMnhTracerTickType::MatchGameTick, EMnhTracerTickType::FixedRateTick, EMnhTracerTickType::DistanceTick};
+	int32 TargetFps = 60;
+	int32 TickDistanceTraveled = 30;
+	float ArenaRadius = 3000;
+	/* Targets per square meter of arena */
+	float TargetDensity = 0.05f;
+	float TargetRadius = 40;
+	float SwingRadius = 150;
+	/* Degrees per second */
+	float SwingSpeed = 720;
+	int32 WarmupFrames = 30;
+	int32 NumFrames = 600;
+	float DeltaTime = 1.f / 60.f;
+	int32 RandomSeed = 1;
+
+	static constexpr int32 MaxTracersPerComponent = 8;
+
+	void ParseCommandLine(const TCHAR* CommandLine);
+	TSharedRef<FJsonObject> ToJson() const;
+};
+
+struct MISSNOHITBENCHMARK_API FMnhBenchmarkPhaseStats
+{
+	double MeanMs = 0;
+	double MedianMs = 0;
+	double P95Ms = 0;
+	double MaxMs = 0;
+
+	static FMnhBenchmarkPhaseStats FromSamples(TArray<double>& SamplesMs);
+	TSharedRef<FJsonObject> ToJson() const;
+};
+
+struct MISSNOHITBENCHMARK_API FMnhBenchmarkResult
+{
+	FMnhBenchmarkSettings Settings;
+	int32 NumTracers = 0;
+	int32 NumActiveTracers = 0;
+	int32 NumTargets = 0;
+	int64 NumHits = 0;
+
+	FMnhBenchmarkPhaseStats ApplyTracerCommands;
+	FMnhBenchmarkPhaseStats UpdateTracerTransforms;
+	FMnhBenchmarkPhaseStats PerformTraces;
+	FMnhBenchmarkPhaseStats NotifyTraceResults;
+	FMnhBenchmarkPhaseStats FlushHitEvents;
+	FMnhBenchmarkPhaseStats Total;
+
+	/* Tracer data pool of the module after the run */
+	uint64 ModuleAllocatedBytes = 0;
+	/* Process memory growth from before the arena was built to the end of the run */
+	int64 UsedPhysicalDeltaBytes = 0;
+
+	TSharedRef<FJsonObject> ToJson() const;
+};
+
+class MISSNOHITBENCHMARK_API FMnhBenchmark
+{
+public:
+	/* Builds the arena in a new game world, drives the MissNoHit module for the configured frames and tears it down */
+	static bool Run(const FMnhBenchmarkSettings& Settings, FMnhBenchmarkResult& OutResult);
+	/* Writes <Name>.json to Saved/Benchmarks/MissNoHit or to MnhBench.OutputDir when given, returns the written path */
+	static FString WriteJson(const FMnhBenchmarkResult& Result);
+};
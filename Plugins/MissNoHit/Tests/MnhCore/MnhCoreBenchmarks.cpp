@@ -0,0 +1,168 @@
+﻿// Copyright 2024 Eren Balatkan. All Rights Reserved.
+
+#include "MnhCore/MnhCoreHitCache.h"
+#include "MnhCore/MnhCoreScheduling.h"
+#include "MnhCore/MnhCoreShapes.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+/* Microbenchmarks of the core kernels, nanoseconds per item is the median of several repetitions */
+namespace
+{
+	struct FBenchmarkContext
+	{
+		bool bQuick = false;
+		const char* Filter = nullptr;
+	};
+
+	volatile double Sink = 0;
+
+	template <typename BodyFunc>
+	void RunBenchmark(const FBenchmarkContext& Context, const char* Name, const int64_t ItemsPerRun, BodyFunc&& Body)
+	{
+		if (Context.Filter && !std::strstr(Name, Context.Filter))
+		{
+			return;
+		}
+
+		const int NumRepetitions = Context.bQuick ? 1 : 9;
+		const int RunsPerRepetition = Context.bQuick ? 1 : 20;
+		std::vector<double> NanosecondsPerItem;
+		for (int Repetition = 0; Repetition < NumRepetitions; Repetition++)
+		{
+			const auto StartTime = std::chrono::steady_clock::now();
+			for (int Run = 0; Run < RunsPerRepetition; Run++)
+			{
+				Sink = Sink + Body();
+			}
+			const std::chrono::duration<double, std::nano> Elapsed = std::chrono::steady_clock::now() - StartTime;
+			NanosecondsPerItem.push_back(Elapsed.count() / (double(ItemsPerRun) * RunsPerRepetition));
+		}
+		std::sort(NanosecondsPerItem.begin(), NanosecondsPerItem.end());
+		std::printf("%-40s %10lld items %12.2f ns/item\n", Name, static_cast<long long>(ItemsPerRun), NanosecondsPerItem[NanosecondsPerItem.size() / 2]);
+	}
+
+	FMnhCoreTransform MakeRandomTransform(std::mt19937& Random)
+	{
+		std::uniform_real_distribution<double> Unit(-1, 1);
+		const FMnhCoreVector Axis = FMnhCoreVector(Unit(Random), Unit(Random), Unit(Random)).GetSafeNormal();
+		return FMnhCoreTransform(FMnhCoreQuat::FromAxisAngle(Axis, Unit(Random) * 3), FMnhCoreVector(Unit(Random), Unit(Random), Unit(Random)) * 1000);
+	}
+
+	struct FBenchmarkHitRecord
+	{
+		uint64_t ActorKey;
+		uint32_t TracerId;
+	};
+}
+
+int main(const int ArgC, char** ArgV)
+{
+	FBenchmarkContext Context;
+	for (int ArgIdx = 1; ArgIdx < ArgC; ArgIdx++)
+	{
+		if (std::strcmp(ArgV[ArgIdx], "--quick") == 0)
+		{
+			Context.bQuick = true;
+		}
+		else if (std::strcmp(ArgV[ArgIdx], "--filter") == 0 && ArgIdx + 1 < ArgC)
+		{
+			Context.Filter = ArgV[++ArgIdx];
+		}
+	}
+
+	const int32_t NumTracers = Context.bQuick ? 256 : 4096;
+	std::mt19937 Random(1);
+	std::vector<FMnhCoreTransform> PreviousTransforms;
+	std::vector<FMnhCoreTransform> CurrentTransforms;
+	std::vector<float> TickIntervals;
+	std::vector<EMnhCoreTickType> TickTypes;
+	for (int32_t TracerIdx = 0; TracerIdx < NumTracers; TracerIdx++)
+	{
+		PreviousTransforms.push_back(MakeRandomTransform(Random));
+		CurrentTransforms.push_back(MakeRandomTransform(Random));
+		TickTypes.push_back(EMnhCoreTickType(TracerIdx % 3));
+		TickIntervals.push_back(TickTypes.back() == EMnhCoreTickType::FixedRateTick ? 1.f / 60 : 30.f);
+	}
+
+	RunBenchmark(Context, "LerpDualQuat", NumTracers, [&]()
+	{
+		double Checksum = 0;
+		for (int32_t TracerIdx = 0; TracerIdx < NumTracers; TracerIdx++)
+		{
+			Checksum += FMnhCoreTransform::LerpDualQuat(PreviousTransforms[TracerIdx], CurrentTransforms[TracerIdx], 0.37).Translation.X;
+		}
+		return Checksum;
+	});
+
+	const uint32_t Substeps = 4;
+	RunBenchmark(Context, "GetSubstepTransforms x4", int64_t(NumTracers) * Substeps, [&]()
+	{
+		double Checksum = 0;
+		for (int32_t TracerIdx = 0; TracerIdx < NumTracers; TracerIdx++)
+		{
+			for (uint32_t SubstepIdx = 0; SubstepIdx < Substeps; SubstepIdx++)
+			{
+				Checksum += FMnhCoreScheduling::GetSubstepTransforms(PreviousTransforms[TracerIdx], CurrentTransforms[TracerIdx],
+					SubstepIdx, Substeps).Average.Translation.Y;
+			}
+		}
+		return Checksum;
+	});
+
+	RunBenchmark(Context, "ShouldTick + GetSubstepCount", NumTracers, [&]()
+	{
+		double Checksum = 0;
+		for (int32_t TracerIdx = 0; TracerIdx < NumTracers; TracerIdx++)
+		{
+			const double Distance = (CurrentTransforms[TracerIdx].Translation - PreviousTransforms[TracerIdx].Translation).Size();
+			if (FMnhCoreScheduling::ShouldTick(TickTypes[TracerIdx], Distance, 1.f / 120, 1.f / 120, TickIntervals[TracerIdx]))
+			{
+				Checksum += FMnhCoreScheduling::GetSubstepCount(TickTypes[TracerIdx], Distance, 1.f / 120, TickIntervals[TracerIdx]);
+			}
+		}
+		return Checksum;
+	});
+
+	RunBenchmark(Context, "GetCapsuleFromSockets", NumTracers, [&]()
+	{
+		double Checksum = 0;
+		for (int32_t TracerIdx = 0; TracerIdx < NumTracers; TracerIdx++)
+		{
+			Checksum += FMnhCoreShapes::GetCapsuleFromSockets(PreviousTransforms[TracerIdx].Translation,
+				CurrentTransforms[TracerIdx].Translation, 10, 5).AxisX.Z;
+		}
+		return Checksum;
+	});
+
+	// The Tracer Component resets its hit cache past 2048 records, filter cost at that size is the worst case
+	for (const int32_t NumRecords : {16, 256, 2048})
+	{
+		std::vector<FBenchmarkHitRecord> Records;
+		for (int32_t RecordIdx = 0; RecordIdx < NumRecords; RecordIdx++)
+		{
+			Records.push_back({uint64_t(Random()) | 1, uint32_t(RecordIdx % 4)});
+		}
+		const int32_t NumQueries = Context.bQuick ? 64 : 1024;
+		char Name[64];
+		std::snprintf(Name, sizeof(Name), "HitCache PassesFilter %d records", NumRecords);
+		RunBenchmark(Context, Name, NumQueries, [&]()
+		{
+			double Checksum = 0;
+			for (int32_t QueryIdx = 0; QueryIdx < NumQueries; QueryIdx++)
+			{
+				// Misses scan the whole cache
+				Checksum += FMnhCoreHitCache::PassesFilter(Records.data(), NumRecords, EMnhCoreFilterType::FilterSameActorPerTracer,
+					uint64_t(QueryIdx) << 1, [QueryIdx](const FBenchmarkHitRecord& Record) { return Record.TracerId == uint32_t(QueryIdx % 4); });
+			}
+			return Checksum;
+		});
+	}
+
+	return 0;
+}
@@ -0,0 +1,74 @@
+﻿// Copyright 2024 Eren Balatkan. All Rights Reserved.
+
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+/* Minimal test runner so the core tests build without third party libraries */
+struct FMnhCoreTestRegistry
+{
+	struct FTest
+	{
+		const char* Name;
+		std::function<void()> Body;
+	};
+
+	static FMnhCoreTestRegistry& Get()
+	{
+		static FMnhCoreTestRegistry Instance;
+		return Instance;
+	}
+
+	std::vector<FTest> Tests;
+	int NumFailedChecks = 0;
+
+	/* Runs every test whose name contains Filter, returns the process exit code */
+	int RunAll(const char* Filter)
+	{
+		int NumFailedTests = 0;
+		for (const FTest& Test : Tests)
+		{
+			if (Filter && !std::strstr(Test.Name, Filter))
+			{
+				continue;
+			}
+			const int FailedChecksBefore = NumFailedChecks;
+			Test.Body();
+			const bool bPassed = NumFailedChecks == FailedChecksBefore;
+			NumFailedTests += bPassed ? 0 : 1;
+			std::printf("[%s] %s\n", bPassed ? "  OK  " : " FAIL ", Test.Name);
+		}
+		std::printf("%d tests failed\n", NumFailedTests);
+		return NumFailedTests == 0 ? 0 : 1;
+	}
+};
+
+struct FMnhCoreTestRegistrar
+{
+	FMnhCoreTestRegistrar(const char* Name, std::function<void()> Body)
+	{
+		FMnhCoreTestRegistry::Get().Tests.push_back({Name, std::move(Body)});
+	}
+};
+
+#define MNH_TEST(Name) \
+	static void MnhTest_##Name(); \
+	static FMnhCoreTestRegistrar MnhTestRegistrar_##Name(#Name, &MnhTest_##Name); \
+	static void MnhTest_##Name()
+
+#define MNH_CHECK(Condition) \
+	do { if (!(Condition)) { FMnhCoreTestRegistry::Get().NumFailedChecks++; \
+		std::printf("  %s:%d: check failed: %s\n", __FILE__, __LINE__, #Condition); } } while (0)
+
+#define MNH_CHECK_NEAR(Actual, Expected, Tolerance) \
+	do { const double MnhActual = (Actual); const double MnhExpected = (Expected); \
+		if (!(std::abs(MnhActual - MnhExpected) <= (Tolerance))) { FMnhCoreTestRegistry::Get().NumFailedChecks++; \
+		std::printf("  %s:%d: %s = %.9g, expected %.9g\n", __FILE__, __LINE__, #Actual, MnhActual, MnhExpected); } } while (0)
+
+#define MNH_CHECK_VECTOR_NEAR(Actual, Expected, Tolerance) \
+	do { MNH_CHECK_NEAR((Actual).X, (Expected).X, Tolerance); MNH_CHECK_NEAR((Actual).Y, (Expected).Y, Tolerance); \
+		MNH_CHECK_NEAR((Actual).Z, (Expected).Z, Tolerance); } while (0)
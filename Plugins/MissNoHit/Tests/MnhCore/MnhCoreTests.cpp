@@ -0,0 +1,215 @@
+﻿// Copyright 2024 Eren Balatkan. All Rights Reserved.
+
+#include "MnhCoreTestHarness.h"
+#include "MnhCore/MnhCoreHitCache.h"
+#include "MnhCore/MnhCoreScheduling.h"
+#include "MnhCore/MnhCoreShapes.h"
+
+namespace
+{
+	constexpr double Pi = 3.14159265358979323846;
+	const FMnhCoreVector UpAxis(0, 0, 1);
+
+	/* A point SwingRadius away from the pivot, rotated Angle around Z like a weapon on a spinning arm */
+	FMnhCoreTransform MakeSwingTransform(const double Angle, const double SwingRadius)
+	{
+		const FMnhCoreQuat Rotation = FMnhCoreQuat::FromAxisAngle(UpAxis, Angle);
+		return FMnhCoreTransform(Rotation, Rotation.RotateVector(FMnhCoreVector(SwingRadius, 0, 0)));
+	}
+
+	void CheckTransformNear(const FMnhCoreTransform& Actual, const FMnhCoreTransform& Expected, const double Tolerance)
+	{
+		MNH_CHECK_VECTOR_NEAR(Actual.Translation, Expected.Translation, Tolerance);
+		MNH_CHECK_VECTOR_NEAR(Actual.Scale3D, Expected.Scale3D, Tolerance);
+		// q and -q are the same rotation
+		MNH_CHECK_NEAR(std::abs(FMnhCoreQuat::Dot(Actual.Rotation, Expected.Rotation)), 1.0, Tolerance);
+	}
+
+	struct FTestHitRecord
+	{
+		uint64_t ActorKey;
+		int TracerId;
+	};
+}
+
+MNH_TEST(QuatRotateVector)
+{
+	const FMnhCoreQuat Rotation = FMnhCoreQuat::FromAxisAngle(UpAxis, Pi / 2);
+	MNH_CHECK_VECTOR_NEAR(Rotation.RotateVector(FMnhCoreVector(1, 0, 0)), FMnhCoreVector(0, 1, 0), 1e-12);
+	const FMnhCoreQuat Combined = FMnhCoreQuat::FromAxisAngle(FMnhCoreVector(1, 0, 0), Pi / 2) * Rotation;
+	// Z rotation is applied first
+	MNH_CHECK_VECTOR_NEAR(Combined.RotateVector(FMnhCoreVector(1, 0, 0)), FMnhCoreVector(0, 0, 1), 1e-12);
+}
+
+MNH_TEST(SafeNormal)
+{
+	MNH_CHECK_VECTOR_NEAR(FMnhCoreVector(0, 3, 4).GetSafeNormal(), FMnhCoreVector(0, 0.6, 0.8), 1e-12);
+	MNH_CHECK_VECTOR_NEAR(FMnhCoreVector(1e-5, 0, 0).GetSafeNormal(), FMnhCoreVector(), 0);
+}
+
+MNH_TEST(LerpDualQuatEndpoints)
+{
+	const FMnhCoreTransform A(FMnhCoreQuat::FromAxisAngle(FMnhCoreVector(0, 1, 0), 0.3), FMnhCoreVector(10, -4, 2), FMnhCoreVector(1, 1, 1));
+	const FMnhCoreTransform B(FMnhCoreQuat::FromAxisAngle(FMnhCoreVector(1, 0, 0), -1.1), FMnhCoreVector(-30, 8, 50), FMnhCoreVector(2, 1, 1));
+	CheckTransformNear(FMnhCoreTransform::LerpDualQuat(A, B, 0), A, 1e-9);
+	CheckTransformNear(FMnhCoreTransform::LerpDualQuat(A, B, 1), B, 1e-9);
+	MNH_CHECK_VECTOR_NEAR(FMnhCoreTransform::LerpDualQuat(A, B, 0.5).Scale3D, FMnhCoreVector(1.5, 1, 1), 1e-12);
+}
+
+MNH_TEST(LerpDualQuatTranslationIsLinear)
+{
+	const FMnhCoreTransform A(FMnhCoreQuat(), FMnhCoreVector(0, 0, 0));
+	const FMnhCoreTransform B(FMnhCoreQuat(), FMnhCoreVector(100, 50, -20));
+	MNH_CHECK_VECTOR_NEAR(FMnhCoreTransform::LerpDualQuat(A, B, 0.25).Translation, FMnhCoreVector(25, 12.5, -5), 1e-9);
+}
+
+MNH_TEST(LerpDualQuatFollowsArc)
+{
+	// Rotating 90 degrees around a pivot, the blended tracer must stay on the circle instead of cutting the chord.
+	// The angle is blended like a nlerp so only the midpoint lands exactly halfway
+	const double SwingRadius = 150;
+	const FMnhCoreTransform A = MakeSwingTransform(0, SwingRadius);
+	const FMnhCoreTransform B = MakeSwingTransform(Pi / 2, SwingRadius);
+	for (const double Alpha : {0.1, 0.25, 0.5, 0.9})
+	{
+		const FMnhCoreTransform Blended = FMnhCoreTransform::LerpDualQuat(A, B, Alpha);
+		MNH_CHECK_VECTOR_NEAR(Blended.Translation, Blended.Rotation.RotateVector(FMnhCoreVector(SwingRadius, 0, 0)), 1e-9);
+	}
+	CheckTransformNear(FMnhCoreTransform::LerpDualQuat(A, B, 0.5), MakeSwingTransform(Pi / 4, SwingRadius), 1e-9);
+}
+
+MNH_TEST(LerpDualQuatTakesShortestPath)
+{
+	const FMnhCoreTransform A = MakeSwingTransform(0, 100);
+	FMnhCoreTransform B = MakeSwingTransform(Pi / 3, 100);
+	B.Rotation = B.Rotation * -1.0;
+	CheckTransformNear(FMnhCoreTransform::LerpDualQuat(A, B, 0.5), MakeSwingTransform(Pi / 6, 100), 1e-9);
+}
+
+MNH_TEST(SubstepTransformsCoverTheMove)
+{
+	const FMnhCoreTransform Previous = MakeSwingTransform(0, 120);
+	const FMnhCoreTransform Current = MakeSwingTransform(Pi, 120);
+	const uint32_t Substeps = 4;
+	FMnhCoreTransform LastEnd = Previous;
+	for (uint32_t SubstepIdx = 0; SubstepIdx < Substeps; SubstepIdx++)
+	{
+		const FMnhCoreSubstepTransforms Transforms = FMnhCoreScheduling::GetSubstepTransforms(Previous, Current, SubstepIdx, Substeps);
+		// Substeps are contiguous
+		CheckTransformNear(Transforms.Start, LastEnd, 1e-6);
+		MNH_CHECK_VECTOR_NEAR(Transforms.Average.Translation, Transforms.Average.Rotation.RotateVector(FMnhCoreVector(120, 0, 0)), 1e-6);
+		LastEnd = Transforms.End;
+	}
+	CheckTransformNear(LastEnd, Current, 1e-6);
+}
+
+MNH_TEST(ShouldTick)
+{
+	MNH_CHECK(FMnhCoreScheduling::ShouldTick(EMnhCoreTickType::MatchGameTick, 0, 0, 1.f / 60, 0));
+	// Gated by the pose serial of the mesh before it gets here
+	MNH_CHECK(FMnhCoreScheduling::ShouldTick(EMnhCoreTickType::AnimationFinalized, 0, 0, 1.f / 60, 0));
+
+	MNH_CHECK(FMnhCoreScheduling::ShouldTick(EMnhCoreTickType::DistanceTick, 30, 0, 1.f / 60, 30));
+	MNH_CHECK(!FMnhCoreScheduling::ShouldTick(EMnhCoreTickType::DistanceTick, 29.9, 0, 1.f / 60, 30));
+
+	// 30 Hz tracer in a 120 Hz game ticks every fourth frame, more than half an interval since the last tick
+	const float TickInterval = 1.f / 30;
+	const float DeltaTime = 1.f / 120;
+	MNH_CHECK(!FMnhCoreScheduling::ShouldTick(EMnhCoreTickType::FixedRateTick, 0, DeltaTime, DeltaTime, TickInterval));
+	MNH_CHECK(FMnhCoreScheduling::ShouldTick(EMnhCoreTickType::FixedRateTick, 0, 2 * DeltaTime, DeltaTime, TickInterval));
+}
+
+MNH_TEST(SubstepCount)
+{
+	MNH_CHECK(FMnhCoreScheduling::GetSubstepCount(EMnhCoreTickType::MatchGameTick, 1000, 1.f / 10, 0) == 1);
+	MNH_CHECK(FMnhCoreScheduling::GetSubstepCount(EMnhCoreTickType::AnimationFinalized, 1000, 1.f / 10, 0) == 1);
+
+	MNH_CHECK(FMnhCoreScheduling::GetSubstepCount(EMnhCoreTickType::DistanceTick, 95, 1.f / 60, 30) == 4);
+	MNH_CHECK(FMnhCoreScheduling::GetSubstepCount(EMnhCoreTickType::DistanceTick, 30, 1.f / 60, 30) == 1);
+	MNH_CHECK(FMnhCoreScheduling::GetSubstepCount(EMnhCoreTickType::DistanceTick, 3000, 1.f / 60, 30) == FMnhCoreScheduling::DefaultMaxSubsteps);
+	MNH_CHECK(FMnhCoreScheduling::GetSubstepCount(EMnhCoreTickType::DistanceTick, 3000, 1.f / 60, 30, 64) == 64);
+
+	MNH_CHECK(FMnhCoreScheduling::GetSubstepCount(EMnhCoreTickType::FixedRateTick, 0, 1.f / 60, 1.f / 30) == 1);
+	MNH_CHECK(FMnhCoreScheduling::GetSubstepCount(EMnhCoreTickType::FixedRateTick, 0, 1.f / 30, 1.f / 120) == 4);
+
+	// Zero intervals come from unset definitions and must not divide by zero
+	MNH_CHECK(FMnhCoreScheduling::GetSubstepCount(EMnhCoreTickType::DistanceTick, 95, 1.f / 60, 0) == 1);
+	MNH_CHECK(FMnhCoreScheduling::GetSubstepCount(EMnhCoreTickType::FixedRateTick, 0, 1.f / 60, 0) == 1);
+}
+
+MNH_TEST(ScaledTickInterval)
+{
+	MNH_CHECK_NEAR(FMnhCoreScheduling::GetScaledTickInterval(EMnhCoreTickType::FixedRateTick, 1.f / 60, 0.5f), 1.0 / 30, 1e-6);
+	MNH_CHECK_NEAR(FMnhCoreScheduling::GetScaledTickInterval(EMnhCoreTickType::DistanceTick, 30, 2), 15, 1e-6);
+	MNH_CHECK_NEAR(FMnhCoreScheduling::GetScaledTickInterval(EMnhCoreTickType::MatchGameTick, 0, 2), 0, 1e-6);
+	MNH_CHECK_NEAR(FMnhCoreScheduling::GetScaledTickInterval(EMnhCoreTickType::AnimationFinalized, 0, 2), 0, 1e-6);
+	// Invalid scales keep the authored interval
+	MNH_CHECK_NEAR(FMnhCoreScheduling::GetScaledTickInterval(EMnhCoreTickType::DistanceTick, 30, 0), 30, 1e-6);
+}
+
+MNH_TEST(CapsuleFromSockets)
+{
+	const FMnhCoreCapsule Capsule = FMnhCoreShapes::GetCapsuleFromSockets(FMnhCoreVector(0, 0, 0), FMnhCoreVector(0, 0, 100), 5, 8);
+	MNH_CHECK_VECTOR_NEAR(Capsule.Center, FMnhCoreVector(0, 0, 50), 1e-9);
+	MNH_CHECK_NEAR(Capsule.HalfHeight, 55, 1e-4);
+	MNH_CHECK_NEAR(Capsule.Radius, 8, 0);
+	// Z points from the second socket to the first, vertical capsules fall back to X as the up vector
+	MNH_CHECK_VECTOR_NEAR(Capsule.AxisZ, FMnhCoreVector(0, 0, -1), 1e-12);
+	MNH_CHECK_VECTOR_NEAR(Capsule.AxisX, FMnhCoreVector(0, 1, 0), 1e-12);
+	MNH_CHECK_VECTOR_NEAR(Capsule.AxisY, FMnhCoreVector(1, 0, 0), 1e-12);
+}
+
+MNH_TEST(CapsuleClampsToOne)
+{
+	const FMnhCoreCapsule Capsule = FMnhCoreShapes::GetCapsuleFromSockets(FMnhCoreVector(10, 10, 10), FMnhCoreVector(10, 10, 10.5), -20, 0.2f);
+	MNH_CHECK_NEAR(Capsule.HalfHeight, 1, 0);
+	MNH_CHECK_NEAR(Capsule.Radius, 1, 0);
+}
+
+MNH_TEST(CapsuleBasisIsOrthonormal)
+{
+	const FMnhCoreVector Directions[] = {{1, 0, 0}, {0.3, -0.7, 0.2}, {-5, 2, 40}, {0, 0.001, -1}, {3, 4, 0}};
+	for (const FMnhCoreVector& Direction : Directions)
+	{
+		const FMnhCoreCapsule Capsule = FMnhCoreShapes::GetCapsuleFromSockets(Direction * 50, FMnhCoreVector(), 0, 5);
+		MNH_CHECK_VECTOR_NEAR(Capsule.AxisZ, Direction.GetSafeNormal(), 1e-12);
+		MNH_CHECK_NEAR(Capsule.AxisX.Size(), 1, 1e-9);
+		MNH_CHECK_NEAR(Capsule.AxisY.Size(), 1, 1e-9);
+		MNH_CHECK_NEAR(FMnhCoreVector::Dot(Capsule.AxisX, Capsule.AxisZ), 0, 1e-9);
+		MNH_CHECK_NEAR(FMnhCoreVector::Dot(Capsule.AxisY, Capsule.AxisZ), 0, 1e-9);
+		MNH_CHECK_NEAR(FMnhCoreVector::Dot(Capsule.AxisX, Capsule.AxisY), 0, 1e-9);
+		// Right handed
+		MNH_CHECK_VECTOR_NEAR(FMnhCoreVector::Cross(Capsule.AxisX, Capsule.AxisY), Capsule.AxisZ, 1e-9);
+	}
+}
+
+MNH_TEST(HitCacheFilters)
+{
+	const FTestHitRecord Records[] = {{7, 1}, {9, 2}};
+	const auto MatchesTracer1 = [](const FTestHitRecord& Record) { return Record.TracerId == 1; };
+	const auto MatchesTracer2 = [](const FTestHitRecord& Record) { return Record.TracerId == 2; };
+
+	MNH_CHECK(!FMnhCoreHitCache::PassesFilter(Records, 2, EMnhCoreFilterType::FilterSameActorAcrossAllTracers, 9, MatchesTracer1));
+	MNH_CHECK(FMnhCoreHitCache::PassesFilter(Records, 2, EMnhCoreFilterType::FilterSameActorAcrossAllTracers, 8, MatchesTracer1));
+
+	MNH_CHECK(FMnhCoreHitCache::PassesFilter(Records, 2, EMnhCoreFilterType::FilterSameActorPerTracer, 9, MatchesTracer1));
+	MNH_CHECK(!FMnhCoreHitCache::PassesFilter(Records, 2, EMnhCoreFilterType::FilterSameActorPerTracer, 9, MatchesTracer2));
+
+	MNH_CHECK(FMnhCoreHitCache::PassesFilter(Records, 2, EMnhCoreFilterType::None, 7, MatchesTracer1));
+	MNH_CHECK(FMnhCoreHitCache::PassesFilter(Records, 0, EMnhCoreFilterType::FilterSameActorAcrossAllTracers, 7, MatchesTracer1));
+}
+
+MNH_TEST(HitCacheRemoveKeepsOrder)
+{
+	FTestHitRecord Records[] = {{1, 1}, {2, 2}, {3, 1}, {4, 3}, {5, 2}};
+	const int32_t NumKept = FMnhCoreHitCache::RemoveRecords(Records, 5, [](const FTestHitRecord& Record) { return Record.TracerId == 2; });
+	MNH_CHECK(NumKept == 3);
+	MNH_CHECK(Records[0].ActorKey == 1);
+	MNH_CHECK(Records[1].ActorKey == 3);
+	MNH_CHECK(Records[2].ActorKey == 4);
+}
+
+int main(const int ArgC, char** ArgV)
+{
+	return FMnhCoreTestRegistry::Get().RunAll(ArgC > 1 ? ArgV[1] : nullptr);
+}
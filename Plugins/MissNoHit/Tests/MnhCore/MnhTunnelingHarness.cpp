@@ -0,0 +1,438 @@
+﻿// Copyright 2024 Eren Balatkan. All Rights Reserved.
+
+#include "MnhCore/MnhCoreScheduling.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * Tunneling regression harness. Replays analytic attack motions against thin and small targets through the same
+ * tick decision, substep count and substep interpolation the MissNoHit module uses, and counts how many targets the
+ * linear substep sweeps catch. Every target is placed on the true path of the tracer, so a missed target is tunneling.
+ *   MnhTunnelingHarness [--baseline <Csv>] [--write-baseline <Csv>] [--csv <Csv>]
+ * With --baseline the run fails when any detection rate drops below the baseline.
+ */
+namespace
+{
+	constexpr double Pi = 3.14159265358979323846;
+	/* Sphere on the tip of the weapon */
+	constexpr double TracerRadius = 5;
+	constexpr int32_t NumPhases = 16;
+	constexpr int32_t NumPlacements = 16;
+	constexpr int32_t NumTrials = NumPhases * NumPlacements;
+	/* Ground truth samples per motion */
+	constexpr int32_t NumTruthSamples = 4000;
+
+	struct FMotion
+	{
+		const char* Name;
+		double Duration;
+		FMnhCoreVector Pivot;
+		FMnhCoreVector Axis;
+		/* Tracer position relative to the pivot at rest */
+		FMnhCoreVector ArmOffset;
+		double StartAngle;
+		double EndAngle;
+		/* Pivot translation over the motion, for thrusts */
+		FMnhCoreVector Travel;
+
+		FMnhCoreTransform GetTransform(double Time) const
+		{
+			Time = std::min(std::max(Time, 0.0), Duration);
+			const double Alpha = Time / Duration;
+			// Ease in and out, attacks accelerate and decelerate
+			const double Eased = Alpha * Alpha * (3 - 2 * Alpha);
+			const FMnhCoreQuat Rotation = FMnhCoreQuat::FromAxisAngle(Axis, StartAngle + (EndAngle - StartAngle) * Eased);
+			return FMnhCoreTransform(Rotation, Pivot + Travel * Eased + Rotation.RotateVector(ArmOffset));
+		}
+	};
+
+	const FMotion Motions[] = {
+		// Horizontal swing from the shoulder, 180 degrees in 150 ms
+		{"FastArc", 0.15, {0, 0, 120}, {0, 0, 1}, {110, 0, 0}, -Pi / 2, Pi / 2, {}},
+		// Vertical flick around the wrist, short radius and very high angular speed
+		{"WristFlick", 0.08, {60, 0, 110}, {0, 1, 0}, {0, 0, 45}, -Pi / 2, Pi, {}},
+		// Two full turns in place
+		{"Spin", 0.6, {0, 0, 100}, {0, 0, 1}, {150, 0, 0}, 0, 4 * Pi, {}},
+		// Thrust forward 250 units while the blade twists slightly
+		{"Lunge", 0.12, {0, 0, 100}, {0, 0, 1}, {90, 0, 0}, -0.2, 0.2, {250, 0, 0}},
+	};
+
+	enum class ETargetType : uint8_t
+	{
+		/* Vertical pole, 1 unit radius */
+		Thin,
+		/* 3 unit radius sphere */
+		Small
+	};
+
+	const char* LexToString(const ETargetType TargetType)
+	{
+		return TargetType == ETargetType::Thin ? "Thin" : "Small";
+	}
+
+	struct FTarget
+	{
+		ETargetType Type;
+		FMnhCoreVector Start;
+		FMnhCoreVector End;
+		double Radius;
+	};
+
+	struct FPolicy
+	{
+		const char* Name;
+		EMnhCoreTickType TickType;
+		/* Seconds for FixedRateTick, units for DistanceTick, same as the tracer definition's TickInterval */
+		float TickInterval;
+		int32_t MaxSubsteps;
+	};
+
+	const FPolicy Policies[] = {
+		{"MatchGameTick", EMnhCoreTickType::MatchGameTick, 0, FMnhCoreScheduling::DefaultMaxSubsteps},
+		{"FixedRate60", EMnhCoreTickType::FixedRateTick, 1.f / 60, FMnhCoreScheduling::DefaultMaxSubsteps},
+		{"FixedRate120", EMnhCoreTickType::FixedRateTick, 1.f / 120, FMnhCoreScheduling::DefaultMaxSubsteps},
+		{"FixedRate240", EMnhCoreTickType::FixedRateTick, 1.f / 240, FMnhCoreScheduling::DefaultMaxSubsteps},
+		{"Distance30", EMnhCoreTickType::DistanceTick, 30, FMnhCoreScheduling::DefaultMaxSubsteps},
+		{"Distance10", EMnhCoreTickType::DistanceTick, 10, FMnhCoreScheduling::DefaultMaxSubsteps},
+		{"Distance10Cap32", EMnhCoreTickType::DistanceTick, 10, 32},
+		// The mesh finalizes a pose every frame and the pose source is bound when the tracer starts, before its first sweep
+		{"AnimationFinalized", EMnhCoreTickType::AnimationFinalized, 0, FMnhCoreScheduling::DefaultMaxSubsteps},
+	};
+
+	const int32_t FrameRates[] = {30, 60, 120};
+
+	/* Closest points of two segments, Real-Time Collision Detection 5.1.9. Small targets are zero length segments */
+	double SegmentSegmentDistanceSquared(const FMnhCoreVector& P1, const FMnhCoreVector& Q1, const FMnhCoreVector& P2, const FMnhCoreVector& Q2)
+	{
+		const FMnhCoreVector D1 = Q1 - P1;
+		const FMnhCoreVector D2 = Q2 - P2;
+		const FMnhCoreVector R = P1 - P2;
+		const double A = D1.SizeSquared();
+		const double E = D2.SizeSquared();
+		const double F = FMnhCoreVector::Dot(D2, R);
+		double S = 0;
+		double T = 0;
+		if (A <= 1e-12 && E <= 1e-12)
+		{
+			return R.SizeSquared();
+		}
+		if (A <= 1e-12)
+		{
+			T = std::min(std::max(F / E, 0.0), 1.0);
+		}
+		else
+		{
+			const double C = FMnhCoreVector::Dot(D1, R);
+			if (E <= 1e-12)
+			{
+				S = std::min(std::max(-C / A, 0.0), 1.0);
+			}
+			else
+			{
+				const double B = FMnhCoreVector::Dot(D1, D2);
+				const double Denominator = A * E - B * B;
+				S = Denominator != 0 ? std::min(std::max((B * F - C * E) / Denominator, 0.0), 1.0) : 0.0;
+				T = (B * S + F) / E;
+				if (T < 0)
+				{
+					T = 0;
+					S = std::min(std::max(-C / A, 0.0), 1.0);
+				}
+				else if (T > 1)
+				{
+					T = 1;
+					S = std::min(std::max((B - C) / A, 0.0), 1.0);
+				}
+			}
+		}
+		return (P1 + D1 * S - (P2 + D2 * T)).SizeSquared();
+	}
+
+	/* Linear sweep of the tracer sphere, what a shape sweep between two substep locations covers */
+	bool SweepHitsTarget(const FMnhCoreVector& SweepStart, const FMnhCoreVector& SweepEnd, const FTarget& Target)
+	{
+		const double HitDistance = TracerRadius + Target.Radius;
+		return SegmentSegmentDistanceSquared(SweepStart, SweepEnd, Target.Start, Target.End) <= HitDistance * HitDistance;
+	}
+
+	std::vector<FTarget> MakeTargets(const FMotion& Motion, const ETargetType TargetType, const uint32_t Seed)
+	{
+		std::mt19937 Random(Seed);
+		std::uniform_real_distribution<double> Unit(0, 1);
+		std::vector<FTarget> Targets;
+		for (int32_t PlacementIdx = 0; PlacementIdx < NumPlacements; PlacementIdx++)
+		{
+			// Somewhere on the path, up to 80% of the contact distance off it
+			const FMnhCoreVector PathPoint = Motion.GetTransform(Motion.Duration * (0.1 + 0.8 * Unit(Random))).Translation;
+			const double OffsetAngle = 2 * Pi * Unit(Random);
+			const double OffsetSize = 0.8 * Unit(Random);
+			FTarget Target;
+			Target.Type = TargetType;
+			if (TargetType == ETargetType::Thin)
+			{
+				Target.Radius = 1;
+				const double Offset = OffsetSize * (TracerRadius + Target.Radius);
+				const FMnhCoreVector Center = PathPoint + FMnhCoreVector(std::cos(OffsetAngle), std::sin(OffsetAngle), 0) * Offset;
+				Target.Start = Center - FMnhCoreVector(0, 0, 100);
+				Target.End = Center + FMnhCoreVector(0, 0, 100);
+			}
+			else
+			{
+				Target.Radius = 3;
+				const double Offset = OffsetSize * (TracerRadius + Target.Radius);
+				const double Elevation = Pi * (Unit(Random) - 0.5);
+				Target.Start = PathPoint + FMnhCoreVector(std::cos(OffsetAngle) * std::cos(Elevation),
+					std::sin(OffsetAngle) * std::cos(Elevation), std::sin(Elevation)) * Offset;
+				Target.End = Target.Start;
+			}
+			Targets.push_back(Target);
+		}
+		return Targets;
+	}
+
+	bool IsHitByTruePath(const FMotion& Motion, const FTarget& Target)
+	{
+		FMnhCoreVector Previous = Motion.GetTransform(0).Translation;
+		for (int32_t SampleIdx = 1; SampleIdx <= NumTruthSamples; SampleIdx++)
+		{
+			const FMnhCoreVector Current = Motion.GetTransform(Motion.Duration * SampleIdx / NumTruthSamples).Translation;
+			if (SweepHitsTarget(Previous, Current, Target))
+			{
+				return true;
+			}
+			Previous = Current;
+		}
+		return false;
+	}
+
+	struct FTrialResult
+	{
+		bool bDetected = false;
+		int32_t NumSweeps = 0;
+	};
+
+	/**
+	 * One tracer started at the beginning of the motion and stopped at its end. Mirrors FMissNoHitModule's
+	 * UpdateTracerTransforms, PerformTraces and NotifyTraceResults for a single tracer, with a frame boundary
+	 * Phase seconds before the motion starts.
+	 */
+	FTrialResult RunTrial(const FMotion& Motion, const FTarget& Target, const FPolicy& Policy, const float DeltaTime, const double Phase)
+	{
+		FTrialResult Result;
+		// The first frame after starting sees the same transform twice, like the module's TracerTransformsOverTime
+		FMnhCoreTransform LastTickTransform = Motion.GetTransform(-Phase);
+		float DeltaTimeLastTick = 0;
+		bool bStopping = false;
+		for (int32_t FrameIdx = 0; !bStopping; FrameIdx++)
+		{
+			const double FrameTime = FrameIdx * double(DeltaTime) - Phase;
+			const FMnhCoreTransform CurrentTransform = Motion.GetTransform(FrameTime);
+			const double Distance = (CurrentTransform.Translation - LastTickTransform.Translation).Size();
+			// The tracer is stopped on the first frame past the motion, a pending stop always ticks once more
+			bStopping = FrameTime >= Motion.Duration;
+			const bool bShouldTick = bStopping
+				|| FMnhCoreScheduling::ShouldTick(Policy.TickType, Distance, DeltaTimeLastTick, DeltaTime, Policy.TickInterval);
+
+			if (bShouldTick)
+			{
+				const int32_t Substeps = FMnhCoreScheduling::GetSubstepCount(Policy.TickType, Distance, DeltaTime, Policy.TickInterval, Policy.MaxSubsteps);
+				for (int32_t SubstepIdx = 0; SubstepIdx < Substeps; SubstepIdx++)
+				{
+					const FMnhCoreSubstepTransforms Transforms = FMnhCoreScheduling::GetSubstepTransforms(LastTickTransform, CurrentTransform, SubstepIdx, Substeps);
+					Result.bDetected |= SweepHitsTarget(Transforms.Start.Translation, Transforms.End.Translation, Target);
+					Result.NumSweeps++;
+				}
+				LastTickTransform = CurrentTransform;
+				DeltaTimeLastTick = 0;
+			}
+			else
+			{
+				DeltaTimeLastTick += DeltaTime;
+			}
+		}
+		return Result;
+	}
+
+	struct FRow
+	{
+		std::string Motion;
+		std::string Target;
+		std::string Policy;
+		int32_t Fps = 0;
+		double DetectionRate = 0;
+		double SweepsPerMotion = 0;
+
+		std::string GetKey() const
+		{
+			return Motion + "," + Target + "," + Policy + "," + std::to_string(Fps);
+		}
+	};
+
+	std::map<std::string, FRow> ReadBaseline(const char* FilePath, bool& bOutSuccess)
+	{
+		std::map<std::string, FRow> Rows;
+		std::ifstream File(FilePath);
+		bOutSuccess = bool(File);
+		std::string Line;
+		std::getline(File, Line);
+		while (std::getline(File, Line))
+		{
+			std::stringstream LineStream(Line);
+			FRow Row;
+			std::string Fps, DetectionRate, SweepsPerMotion;
+			if (std::getline(LineStream, Row.Motion, ',') && std::getline(LineStream, Row.Target, ',') && std::getline(LineStream, Row.Policy, ',')
+				&& std::getline(LineStream, Fps, ',') && std::getline(LineStream, DetectionRate, ',') && std::getline(LineStream, SweepsPerMotion, ','))
+			{
+				Row.Fps = std::stoi(Fps);
+				Row.DetectionRate = std::stod(DetectionRate);
+				Row.SweepsPerMotion = std::stod(SweepsPerMotion);
+				Rows.emplace(Row.GetKey(), Row);
+			}
+		}
+		return Rows;
+	}
+
+	bool WriteCsv(const char* FilePath, const std::vector<FRow>& Rows)
+	{
+		FILE* File = std::fopen(FilePath, "w");
+		if (!File)
+		{
+			return false;
+		}
+		std::fprintf(File, "Motion,Target,Policy,Fps,DetectionRate,SweepsPerMotion\n");
+		for (const FRow& Row : Rows)
+		{
+			std::fprintf(File, "%s,%s,%s,%d,%.4f,%.2f\n", Row.Motion.c_str(), Row.Target.c_str(), Row.Policy.c_str(), Row.Fps,
+				Row.DetectionRate, Row.SweepsPerMotion);
+		}
+		std::fclose(File);
+		return true;
+	}
+}
+
+int main(const int ArgC, char** ArgV)
+{
+	const char* BaselinePath = nullptr;
+	const char* WriteBaselinePath = nullptr;
+	const char* CsvPath = nullptr;
+	for (int ArgIdx = 1; ArgIdx + 1 < ArgC; ArgIdx++)
+	{
+		if (std::strcmp(ArgV[ArgIdx], "--baseline") == 0)
+		{
+			BaselinePath = ArgV[++ArgIdx];
+		}
+		else if (std::strcmp(ArgV[ArgIdx], "--write-baseline") == 0)
+		{
+			WriteBaselinePath = ArgV[++ArgIdx];
+		}
+		else if (std::strcmp(ArgV[ArgIdx], "--csv") == 0)
+		{
+			CsvPath = ArgV[++ArgIdx];
+		}
+	}
+
+	std::vector<FRow> Rows;
+	uint32_t Seed = 1;
+	for (const FMotion& Motion : Motions)
+	{
+		for (const ETargetType TargetType : {ETargetType::Thin, ETargetType::Small})
+		{
+			const std::vector<FTarget> Targets = MakeTargets(Motion, TargetType, Seed++);
+			for (const FTarget& Target : Targets)
+			{
+				if (!IsHitByTruePath(Motion, Target))
+				{
+					std::printf("Target placement error: %s %s target is not on the true path\n", Motion.Name, LexToString(TargetType));
+					return 1;
+				}
+			}
+
+			for (const FPolicy& Policy : Policies)
+			{
+				for (const int32_t Fps : FrameRates)
+				{
+					const float DeltaTime = 1.f / Fps;
+					int32_t NumDetected = 0;
+					int64_t NumSweeps = 0;
+					for (int32_t TrialIdx = 0; TrialIdx < NumTrials; TrialIdx++)
+					{
+						// Frame boundaries spread evenly over one frame
+						const double Phase = ((TrialIdx % NumPhases) + 0.5) / NumPhases * DeltaTime;
+						const FTrialResult Result = RunTrial(Motion, Targets[TrialIdx / NumPhases], Policy, DeltaTime, Phase);
+						NumDetected += Result.bDetected ? 1 : 0;
+						NumSweeps += Result.NumSweeps;
+					}
+
+					FRow Row;
+					Row.Motion = Motion.Name;
+					Row.Target = LexToString(TargetType);
+					Row.Policy = Policy.Name;
+					Row.Fps = Fps;
+					Row.DetectionRate = double(NumDetected) / NumTrials;
+					Row.SweepsPerMotion = double(NumSweeps) / NumTrials;
+					Rows.push_back(Row);
+				}
+			}
+		}
+	}
+
+	std::map<std::string, FRow> Baseline;
+	if (BaselinePath)
+	{
+		bool bReadBaseline = false;
+		Baseline = ReadBaseline(BaselinePath, bReadBaseline);
+		if (!bReadBaseline)
+		{
+			std::printf("Could not read baseline %s\n", BaselinePath);
+			return 1;
+		}
+	}
+
+	// A single lost trial is the resolution of the harness, anything below that is floating point noise
+	const double Tolerance = 0.5 / NumTrials;
+	int32_t NumRegressions = 0;
+	std::printf("%-11s %-6s %-18s %4s %10s %8s %14s %10s\n", "Motion", "Target", "Policy", "Fps", "Detection", "Sweeps", "Base Detection", "Base Sweep");
+	for (const FRow& Row : Rows)
+	{
+		const auto BaselineRow = Baseline.find(Row.GetKey());
+		const bool bHasBaseline = BaselineRow != Baseline.end();
+		const bool bRegressed = bHasBaseline && Row.DetectionRate < BaselineRow->second.DetectionRate - Tolerance;
+		NumRegressions += bRegressed ? 1 : 0;
+		if (bHasBaseline)
+		{
+			std::printf("%-11s %-6s %-18s %4d %9.1f%% %8.2f %13.1f%% %10.2f%s\n", Row.Motion.c_str(), Row.Target.c_str(), Row.Policy.c_str(), Row.Fps,
+				Row.DetectionRate * 100, Row.SweepsPerMotion, BaselineRow->second.DetectionRate * 100, BaselineRow->second.SweepsPerMotion,
+				bRegressed ? "  REGRESSED" : "");
+		}
+		else
+		{
+			std::printf("%-11s %-6s %-18s %4d %9.1f%% %8.2f %14s %10s\n", Row.Motion.c_str(), Row.Target.c_str(), Row.Policy.c_str(), Row.Fps,
+				Row.DetectionRate * 100, Row.SweepsPerMotion, "-", "-");
+		}
+	}
+
+	if (CsvPath && !WriteCsv(CsvPath, Rows))
+	{
+		std::printf("Could not write %s\n", CsvPath);
+		return 1;
+	}
+	if (WriteBaselinePath && !WriteCsv(WriteBaselinePath, Rows))
+	{
+		std::printf("Could not write %s\n", WriteBaselinePath);
+		return 1;
+	}
+
+	if (BaselinePath)
+	{
+		std::printf("%d of %d rows below the baseline detection rate\n", NumRegressions, int32_t(Rows.size()));
+	}
+	return NumRegressions == 0 ? 0 : 1;
+}